@@ -0,0 +1,141 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "content-type-cache.h"
+
+#include <QIcon>
+
+using namespace Peony;
+
+ContentTypeCache *ContentTypeCache::getInstance()
+{
+    static ContentTypeCache global_instance;
+    return &global_instance;
+}
+
+const QString ContentTypeCache::resolveIconName(const QString &contentType, GIcon *gicon)
+{
+    if (!G_IS_THEMED_ICON(gicon))
+        return nullptr;
+
+    const gchar* const* icon_names = g_themed_icon_get_names(G_THEMED_ICON (gicon));
+    if (!icon_names)
+        return nullptr;
+
+    auto key = iconKey(contentType, icon_names);
+    m_mutex.lock();
+    checkIconTheme();
+    if (m_icon_names.contains(key)) {
+        auto icon_name = m_icon_names.value(key);
+        m_mutex.unlock();
+        return icon_name;
+    }
+    m_mutex.unlock();
+
+    //do not hold the lock while looking up icon theme.
+    QString icon_name = nullptr;
+    auto p = icon_names;
+    while (*p) {
+        QIcon icon = QIcon::fromTheme(*p);
+        if (!icon.isNull()) {
+            icon_name = *p;
+            break;
+        } else {
+            p++;
+        }
+    }
+
+    QMutexLocker l(&m_mutex);
+    m_icon_names.insert(key, icon_name);
+    return icon_name;
+}
+
+const QString ContentTypeCache::resolveSymbolicIconName(const QString &contentType, GIcon *gicon)
+{
+    if (!G_IS_THEMED_ICON(gicon))
+        return nullptr;
+
+    const gchar* const* symbolic_icon_names = g_themed_icon_get_names(G_THEMED_ICON (gicon));
+    if (!symbolic_icon_names)
+        return nullptr;
+
+    auto key = iconKey(contentType, symbolic_icon_names);
+    QMutexLocker l(&m_mutex);
+    checkIconTheme();
+    auto it = m_symbolic_icon_names.constFind(key);
+    if (it != m_symbolic_icon_names.constEnd())
+        return *it;
+
+    QString icon_name = *symbolic_icon_names;
+    m_symbolic_icon_names.insert(key, icon_name);
+    return icon_name;
+}
+
+const QString ContentTypeCache::description(const QString &contentType)
+{
+    if (contentType.isEmpty())
+        return nullptr;
+
+    QMutexLocker l(&m_mutex);
+    auto it = m_descriptions.constFind(contentType);
+    if (it != m_descriptions.constEnd())
+        return *it;
+
+    char *content_type_description = g_content_type_get_description(contentType.toUtf8().constData());
+    QString description = content_type_description;
+    g_free(content_type_description);
+    m_descriptions.insert(contentType, description);
+    return description;
+}
+
+void ContentTypeCache::clear()
+{
+    QMutexLocker l(&m_mutex);
+    m_icon_names.clear();
+    m_symbolic_icon_names.clear();
+    m_descriptions.clear();
+}
+
+const QString ContentTypeCache::iconKey(const QString &contentType, const gchar* const* iconNames)
+{
+    //the icon names of a content type might be different, for example,
+    //the special directories such as ~/Pictures have their own icons.
+    QString key = contentType;
+    auto p = iconNames;
+    while (*p) {
+        key.append('\n');
+        key.append(*p);
+        p++;
+    }
+    return key;
+}
+
+void ContentTypeCache::checkIconTheme()
+{
+    //must be called with m_mutex locked.
+    auto theme_name = QIcon::themeName();
+    if (theme_name != m_theme_name) {
+        m_theme_name = theme_name;
+        m_icon_names.clear();
+        m_symbolic_icon_names.clear();
+    }
+}
@@ -0,0 +1,95 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#ifndef CONTENTTYPECACHE_H
+#define CONTENTTYPECACHE_H
+
+#include "peony-core_global.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+#include <gio/gio.h>
+
+namespace Peony {
+
+/*!
+ * \brief The ContentTypeCache class
+ * <br>
+ * This is a process-wide cache of the results that only depend on the content type
+ * of a file, such as the themed icon name and the content type description.
+ * Resolving a themed icon needs several QIcon::fromTheme() lookups, and all the files
+ * with same content type (and same gio icon names) get the same result.
+ * FileInfoJob and FileInfo use this class to resolve them once for each content type.
+ * </br>
+ * \note The cache is thread safe. The results of icon names are bound to the current
+ * icon theme, the cache will be cleared once the icon theme name changed.
+ */
+class PEONYCORESHARED_EXPORT ContentTypeCache
+{
+public:
+    static ContentTypeCache *getInstance();
+
+    /*!
+     * \brief resolveIconName
+     * \param contentType
+     * \param gicon, the icon of GFileInfo.
+     * \return the first icon name of gicon which exists in current icon theme.
+     */
+    const QString resolveIconName(const QString &contentType, GIcon *gicon);
+
+    /*!
+     * \brief resolveSymbolicIconName
+     * \param contentType
+     * \param gicon, the symbolic icon of GFileInfo.
+     * \return the first symbolic icon name of gicon.
+     */
+    const QString resolveSymbolicIconName(const QString &contentType, GIcon *gicon);
+
+    /*!
+     * \brief description
+     * \param contentType
+     * \return the description of content type.
+     * \see g_content_type_get_description().
+     */
+    const QString description(const QString &contentType);
+
+    void clear();
+
+private:
+    ContentTypeCache() {}
+
+    const QString iconKey(const QString &contentType, const gchar* const* iconNames);
+    void checkIconTheme();
+
+    QMutex m_mutex;
+    QString m_theme_name;
+    QHash<QString, QString> m_icon_names;
+    QHash<QString, QString> m_symbolic_icon_names;
+    QHash<QString, QString> m_descriptions;
+};
+
+}
+
+#endif // CONTENTTYPECACHE_H
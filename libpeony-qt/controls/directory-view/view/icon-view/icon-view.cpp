@@ -31,6 +31,7 @@
 #include "file-utils.h"
 
 #include "global-settings.h"
+#include "prefetch-scheduler.h"
 
 #include <QMouseEvent>
 
@@ -387,6 +388,7 @@ void IconView::bindModel(FileItemModel *sourceModel, FileItemProxyFilterSortMode
     m_sort_filter_proxy_model = proxyModel;
 
     setModel(m_sort_filter_proxy_model);
+    m_sort_filter_proxy_model->pinSelection(selectionModel());
 
     //edit trigger
     connect(this->selectionModel(), &QItemSelectionModel::selectionChanged, [=](const QItemSelection &selection, const QItemSelection &deselection) {
@@ -415,6 +417,22 @@ void IconView::bindModel(FileItemModel *sourceModel, FileItemProxyFilterSortMode
 
         qDebug()<<"selection changed2"<<m_editValid;
     });
+
+    //prefetch the directory user might enter, see PrefetchScheduler.
+    setMouseTracking(true);
+    connect(this, &QAbstractItemView::entered, this, [=](const QModelIndex &index) {
+        auto item = m_sort_filter_proxy_model->itemFromIndex(index);
+        bool isDir = item && item->info()->isDir();
+        PrefetchScheduler::getInstance()->hover(isDir? item->uri(): QString());
+    });
+    connect(this, &QAbstractItemView::viewportEntered, this, [=]() {
+        PrefetchScheduler::getInstance()->hover(QString());
+    });
+    connect(this->selectionModel(), &QItemSelectionModel::currentChanged, this, [=](const QModelIndex &current) {
+        auto item = m_sort_filter_proxy_model->itemFromIndex(current);
+        if (item && item->info()->isDir())
+            PrefetchScheduler::getInstance()->request(item->uri());
+    });
 }
 
 void IconView::setProxy(DirectoryViewProxyIface *proxy)
@@ -32,6 +32,7 @@
 #include "list-view-style.h"
 
 #include "global-settings.h"
+#include "prefetch-scheduler.h"
 
 #include <QHeaderView>
 
@@ -112,6 +113,7 @@ void ListView::bindModel(FileItemModel *sourceModel, FileItemProxyFilterSortMode
     m_proxy_model = proxyModel;
     m_proxy_model->setSourceModel(m_model);
     setModel(proxyModel);
+    m_proxy_model->pinSelection(selectionModel());
     //adjust columns layout.
     adjustColumnsSize();
 
@@ -169,6 +171,22 @@ void ListView::bindModel(FileItemModel *sourceModel, FileItemProxyFilterSortMode
             m_editValid = false;
         }
     });
+
+    //prefetch the directory user might enter, see PrefetchScheduler.
+    setMouseTracking(true);
+    connect(this, &QAbstractItemView::entered, this, [=](const QModelIndex &index) {
+        auto item = m_proxy_model->itemFromIndex(index);
+        bool isDir = item && item->info()->isDir();
+        PrefetchScheduler::getInstance()->hover(isDir? item->uri(): QString());
+    });
+    connect(this, &QAbstractItemView::viewportEntered, this, [=]() {
+        PrefetchScheduler::getInstance()->hover(QString());
+    });
+    connect(this->selectionModel(), &QItemSelectionModel::currentChanged, this, [=](const QModelIndex &current) {
+        auto item = m_proxy_model->itemFromIndex(current);
+        if (item && item->info()->isDir())
+            PrefetchScheduler::getInstance()->request(item->uri());
+    });
 }
 
 void ListView::keyPressEvent(QKeyEvent *e)
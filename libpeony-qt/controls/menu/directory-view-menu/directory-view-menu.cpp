@@ -272,6 +272,7 @@ const QList<QAction *> DirectoryViewMenu::constructOpenOpActions()
                 **/
                 for (auto uri : m_selections) {
                     auto info = FileInfo::fromUri(uri);
+                    info->resolveTypeSync();
                     if (info->isDir() || info->isVolume()) {
                         dirs<<uri;
                     } else {
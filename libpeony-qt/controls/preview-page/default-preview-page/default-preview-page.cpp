@@ -280,6 +280,7 @@ void FilePreviewPage::countAsync(const QString &uri)
     QStringList uris;
     uris<<uri;
     auto info = FileInfo::fromUri(uri);
+    info->resolveTypeSync();
     m_count_op = new FileCountOperation(uris, !info->isDir());
     connect(m_count_op, &FileOperation::operationStarted, this, &FilePreviewPage::resetCount, Qt::BlockingQueuedConnection);
     connect(m_count_op, &FileOperation::operationPreparedOne, this, &FilePreviewPage::onPreparedOne, Qt::BlockingQueuedConnection);
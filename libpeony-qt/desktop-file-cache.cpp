@@ -0,0 +1,143 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "desktop-file-cache.h"
+
+#include <gio/gdesktopappinfo.h>
+
+#include <QFileInfo>
+#include <QDateTime>
+#include <QLocale>
+
+using namespace Peony;
+
+DesktopFileCache *DesktopFileCache::getInstance()
+{
+    static DesktopFileCache global_instance;
+    return &global_instance;
+}
+
+const DesktopFileCache::Entry DesktopFileCache::lookup(const QString &path)
+{
+    QFileInfo file_info(path);
+    if (!file_info.exists()) {
+        invalidate(path);
+        return Entry();
+    }
+    qint64 modified_time = file_info.lastModified().toMSecsSinceEpoch();
+
+    m_mutex.lock();
+    auto it = m_hash.constFind(path);
+    if (it != m_hash.constEnd() && it->modifiedTime == modified_time) {
+        auto entry = *it;
+        m_mutex.unlock();
+        return entry;
+    }
+    m_mutex.unlock();
+
+    //do not hold the lock while parsing desktop file.
+    auto entry = parse(path);
+    entry.modifiedTime = modified_time;
+
+    QMutexLocker l(&m_mutex);
+    m_hash.insert(path, entry);
+    return entry;
+}
+
+void DesktopFileCache::invalidate(const QString &path)
+{
+    QMutexLocker l(&m_mutex);
+    m_hash.remove(path);
+}
+
+void DesktopFileCache::clear()
+{
+    QMutexLocker l(&m_mutex);
+    m_hash.clear();
+}
+
+QString DesktopFileCache::getAppName(const QString &desktopfp)
+{
+    GError** error=nullptr;
+    GKeyFileFlags flags=G_KEY_FILE_NONE;
+    GKeyFile* keyfile=g_key_file_new ();
+
+    QByteArray fpbyte=desktopfp.toLocal8Bit();
+    char* filepath=fpbyte.data();
+    g_key_file_load_from_file(keyfile,filepath,flags,error);
+
+    char* name=g_key_file_get_locale_string(keyfile,"Desktop Entry","Name", nullptr, nullptr);
+    QString namestr=QString::fromLocal8Bit(name);
+
+    g_free(name);
+    g_key_file_free(keyfile);
+    return namestr;
+}
+
+const DesktopFileCache::Entry DesktopFileCache::parse(const QString &path)
+{
+    Entry entry;
+    GDesktopAppInfo *desktop_info = g_desktop_app_info_new_from_filename(path.toUtf8().constData());
+    if (!desktop_info)
+        return entry;
+
+    entry.isValid = true;
+
+#if GLIB_CHECK_VERSION(2, 56, 0)
+    auto string = g_desktop_app_info_get_locale_string(desktop_info, "Name");
+#else
+    //FIXME: should handle locale?
+    //change "Name" to QLocale::system().name(),
+    //try to fix Qt5.6 untranslated desktop file issue
+    auto key = "Name[" +  QLocale::system().name() + "]";
+    auto string = g_desktop_app_info_get_string(desktop_info, key.toUtf8().constData());
+#endif
+    if (string) {
+        entry.name = string;
+        g_free(string);
+    } else {
+        QString app_path = "/usr/share/applications/" + QFileInfo(path).fileName();
+        auto name = getAppName(app_path);
+        if (name.length() > 0) {
+            entry.name = name;
+        } else {
+            string = g_desktop_app_info_get_string(desktop_info, "Name");
+            if (string) {
+                entry.name = string;
+                g_free(string);
+            }
+        }
+    }
+
+    string = g_desktop_app_info_get_string(desktop_info, "Icon");
+    entry.icon = string;
+    g_free(string);
+
+    string = g_desktop_app_info_get_string(desktop_info, "Exec");
+    entry.exec = string;
+    g_free(string);
+
+    entry.noDisplay = g_desktop_app_info_get_nodisplay(desktop_info);
+
+    g_object_unref(desktop_info);
+    return entry;
+}
@@ -0,0 +1,90 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#ifndef DESKTOPFILECACHE_H
+#define DESKTOPFILECACHE_H
+
+#include "peony-core_global.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+namespace Peony {
+
+/*!
+ * \brief The DesktopFileCache class
+ * <br>
+ * This is a process-wide cache of the launcher metadata parsed from .desktop files,
+ * such as the localized name, icon and exec line. The entries are keyed by the local
+ * path of desktop file and the modified time of it, so an entry is parsed again once
+ * the desktop file changed. FileWatcher also invalidates the entries of the desktop
+ * files it watched changing.
+ * </br>
+ * \note The cache is thread safe, it is shared by FileInfoJob and ThumbnailManager.
+ */
+class PEONYCORESHARED_EXPORT DesktopFileCache
+{
+public:
+    struct Entry {
+        bool isValid = false;
+        qint64 modifiedTime = 0;
+        QString name;
+        QString icon;
+        QString exec;
+        bool noDisplay = false;
+    };
+
+    static DesktopFileCache *getInstance();
+
+    /*!
+     * \brief lookup
+     * \param path, the local path of desktop file.
+     * \return the cached entry, or the newly parsed entry if the
+     * file has never been parsed or has been modified.
+     * \note this checks the modified time of the file.
+     */
+    const Entry lookup(const QString &path);
+
+    void invalidate(const QString &path);
+    void clear();
+
+    /*!
+     * \brief getAppName
+     * \param desktopfp
+     * \return the localized name in a desktop file, loaded by GKeyFile.
+     */
+    static QString getAppName(const QString &desktopfp);
+
+private:
+    DesktopFileCache() {}
+
+    const Entry parse(const QString &path);
+
+    QMutex m_mutex;
+    QHash<QString, Entry> m_hash;
+};
+
+}
+
+#endif // DESKTOPFILECACHE_H
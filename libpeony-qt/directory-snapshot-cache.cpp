@@ -0,0 +1,386 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "directory-snapshot-cache.h"
+
+#include "file-info.h"
+#include "file-info-job.h"
+#include "global-settings.h"
+
+#include <QtConcurrent>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QSaveFile>
+#include <QFile>
+#include <QDir>
+#include <QTimer>
+
+#include <QDebug>
+
+#include <utime.h>
+
+#define SNAPSHOT_MAGIC 0x50445343
+#define SNAPSHOT_VERSION 1
+
+using namespace Peony;
+
+enum SnapshotRecordFlag {
+    SymbolLink = 1 << 0,
+    Virtual = 1 << 1,
+    CanRead = 1 << 2,
+    CanWrite = 1 << 3,
+    CanExecute = 1 << 4,
+    CanDelete = 1 << 5,
+    CanTrash = 1 << 6,
+    CanRename = 1 << 7
+};
+
+struct SnapshotRecord {
+    QString uri;
+    QString displayName;
+    quint32 fileType = G_FILE_TYPE_UNKNOWN;
+    quint32 flags = 0;
+    quint64 size = 0;
+    quint64 modifiedTime = 0;
+    quint64 accessTime = 0;
+    QString contentType;
+    QString iconName;
+    QString symbolicIconName;
+};
+
+static QDataStream &operator<<(QDataStream &stream, const SnapshotRecord &record)
+{
+    stream<<record.uri<<record.displayName<<record.fileType<<record.flags
+          <<record.size<<record.modifiedTime<<record.accessTime
+          <<record.contentType<<record.iconName<<record.symbolicIconName;
+    return stream;
+}
+
+static QDataStream &operator>>(QDataStream &stream, SnapshotRecord &record)
+{
+    stream>>record.uri>>record.displayName>>record.fileType>>record.flags
+          >>record.size>>record.modifiedTime>>record.accessTime
+          >>record.contentType>>record.iconName>>record.symbolicIconName;
+    return stream;
+}
+
+static SnapshotRecord record_from_info(const std::shared_ptr<FileInfo> &info)
+{
+    SnapshotRecord record;
+    record.uri = info->uri();
+    record.displayName = info->displayName();
+    if (info->isDir()) {
+        record.fileType = G_FILE_TYPE_DIRECTORY;
+    } else if (info->isVolume()) {
+        record.fileType = G_FILE_TYPE_MOUNTABLE;
+    } else {
+        record.fileType = G_FILE_TYPE_REGULAR;
+    }
+
+    record.flags |= info->isSymbolLink()? SymbolLink: 0;
+    record.flags |= info->isVirtual()? Virtual: 0;
+    record.flags |= info->canRead()? CanRead: 0;
+    record.flags |= info->canWrite()? CanWrite: 0;
+    record.flags |= info->canExecute()? CanExecute: 0;
+    record.flags |= info->canDelete()? CanDelete: 0;
+    record.flags |= info->canTrash()? CanTrash: 0;
+    record.flags |= info->canRename()? CanRename: 0;
+
+    record.size = info->size();
+    record.modifiedTime = info->modifiedTime();
+    record.accessTime = info->accessTime();
+    record.contentType = info->mimeType();
+    record.iconName = info->iconName();
+    record.symbolicIconName = info->symbolicIconName();
+    return record;
+}
+
+static void set_themed_icon(GFileInfo *g_info, const QString &iconName, bool symbolic)
+{
+    if (iconName.isEmpty())
+        return;
+
+    GIcon *icon = g_themed_icon_new(iconName.toUtf8().constData());
+    if (symbolic) {
+        g_file_info_set_symbolic_icon(g_info, icon);
+    } else {
+        g_file_info_set_icon(g_info, icon);
+    }
+    g_object_unref(icon);
+}
+
+static void apply_record(FileInfo *info, const SnapshotRecord &record)
+{
+    //only the display attributes are recorded, do not take the info as loaded,
+    //and keep its metadata, such as emblems, labels and colors.
+    GFileInfo *g_info = g_file_info_new();
+    g_file_info_set_display_name(g_info, record.displayName.toUtf8().constData());
+    g_file_info_set_file_type(g_info, GFileType(record.fileType));
+    g_file_info_set_attribute_boolean(g_info, G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK, record.flags & SymbolLink);
+    g_file_info_set_attribute_boolean(g_info, G_FILE_ATTRIBUTE_STANDARD_IS_VIRTUAL, record.flags & Virtual);
+    g_file_info_set_attribute_boolean(g_info, G_FILE_ATTRIBUTE_ACCESS_CAN_READ, record.flags & CanRead);
+    g_file_info_set_attribute_boolean(g_info, G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE, record.flags & CanWrite);
+    g_file_info_set_attribute_boolean(g_info, G_FILE_ATTRIBUTE_ACCESS_CAN_EXECUTE, record.flags & CanExecute);
+    g_file_info_set_attribute_boolean(g_info, G_FILE_ATTRIBUTE_ACCESS_CAN_DELETE, record.flags & CanDelete);
+    g_file_info_set_attribute_boolean(g_info, G_FILE_ATTRIBUTE_ACCESS_CAN_TRASH, record.flags & CanTrash);
+    g_file_info_set_attribute_boolean(g_info, G_FILE_ATTRIBUTE_ACCESS_CAN_RENAME, record.flags & CanRename);
+    g_file_info_set_attribute_uint64(g_info, G_FILE_ATTRIBUTE_STANDARD_SIZE, record.size);
+    g_file_info_set_attribute_uint64(g_info, G_FILE_ATTRIBUTE_TIME_MODIFIED, record.modifiedTime);
+    g_file_info_set_attribute_uint64(g_info, G_FILE_ATTRIBUTE_TIME_ACCESS, record.accessTime);
+    if (!record.contentType.isEmpty())
+        g_file_info_set_content_type(g_info, record.contentType.toUtf8().constData());
+    set_themed_icon(g_info, record.iconName, false);
+    set_themed_icon(g_info, record.symbolicIconName, true);
+
+    FileInfoJob::preloadInfoContents(info, g_info);
+    g_object_unref(g_info);
+}
+
+/*!
+ * \brief query_directory_stamp
+ * \return false if the directory can not be queried.
+ */
+static bool query_directory_stamp(const QString &uri, quint64 &modifiedTime, QString &id)
+{
+    GFile *dir = g_file_new_for_uri(uri.toUtf8().constData());
+    GFileInfo *info = g_file_query_info(dir,
+                                        G_FILE_ATTRIBUTE_TIME_MODIFIED "," G_FILE_ATTRIBUTE_ID_FILE,
+                                        G_FILE_QUERY_INFO_NONE,
+                                        nullptr,
+                                        nullptr);
+    g_object_unref(dir);
+    if (!info)
+        return false;
+
+    modifiedTime = g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+    id = g_file_info_get_attribute_string(info, G_FILE_ATTRIBUTE_ID_FILE);
+    g_object_unref(info);
+    return true;
+}
+
+/*!
+ * \brief read_snapshot
+ * \return the records of a valid snapshot, an invalid snapshot is removed.
+ * \note it does i/o, call it in a worker thread.
+ */
+static QList<SnapshotRecord> read_snapshot(const QString &uri, const QString &path, QMutex *mutex)
+{
+    QList<SnapshotRecord> records;
+
+    //the snapshot is out of date once the children of directory changed.
+    quint64 current_modified_time = 0;
+    QString current_id;
+    if (!query_directory_stamp(uri, current_modified_time, current_id))
+        return records;
+
+    QMutexLocker l(mutex);
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return records;
+
+    auto size = file.size();
+    uchar *data = file.map(0, size);
+    if (!data)
+        return records;
+
+    QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char *>(data), int(size));
+    QDataStream stream(bytes);
+    stream.setVersion(QDataStream::Qt_5_6);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    QString snapshot_uri;
+    quint64 dir_modified_time = 0;
+    QString dir_id;
+    quint32 count = 0;
+    stream>>magic>>version>>snapshot_uri>>dir_modified_time>>dir_id>>count;
+
+    bool valid = magic == SNAPSHOT_MAGIC && version == SNAPSHOT_VERSION && snapshot_uri == uri;
+    valid = valid && dir_modified_time == current_modified_time;
+    //a directory replaced by another one has different file id.
+    if (valid && !current_id.isEmpty() && !dir_id.isEmpty())
+        valid = current_id == dir_id;
+
+    if (valid) {
+        for (quint32 i = 0; i < count; i++) {
+            SnapshotRecord record;
+            stream>>record;
+            if (stream.status() != QDataStream::Ok) {
+                valid = false;
+                break;
+            }
+            records<<record;
+        }
+    }
+
+    file.unmap(data);
+    file.close();
+
+    if (!valid) {
+        records.clear();
+        QFile::remove(path);
+        return records;
+    }
+
+    //update access time for lru eviction.
+    utime(path.toLocal8Bit().constData(), nullptr);
+    return records;
+}
+
+DirectorySnapshotCache *DirectorySnapshotCache::getInstance()
+{
+    static DirectorySnapshotCache *global_instance = new DirectorySnapshotCache;
+    return global_instance;
+}
+
+DirectorySnapshotCache::DirectorySnapshotCache(QObject *parent) : QObject(parent)
+{
+    m_cache_dir = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/peony-qt/directory-snapshots";
+    QDir().mkpath(m_cache_dir);
+}
+
+bool DirectorySnapshotCache::isEnabled()
+{
+    auto settings = GlobalSettings::getInstance();
+    return settings->isExist(DIRECTORY_SNAPSHOT_CACHE) && settings->getValue(DIRECTORY_SNAPSHOT_CACHE).toBool();
+}
+
+void DirectorySnapshotCache::loadSnapshotAsync(std::shared_ptr<FileInfo> dirInfo)
+{
+    auto uri = dirInfo->uri();
+    if (!isEnabled()) {
+        //keep the signal asynchronous as the snapshot loaded in worker.
+        QTimer::singleShot(0, this, [=]() {
+            Q_EMIT snapshotLoaded(uri, QList<std::shared_ptr<FileInfo>>());
+        });
+        return;
+    }
+
+    auto path = snapshotPath(uri);
+    QtConcurrent::run([=]() {
+        auto records = read_snapshot(uri, path, &m_mutex);
+        QTimer::singleShot(0, this, [=]() {
+            QList<std::shared_ptr<FileInfo>> infos;
+            for (auto record : records) {
+                auto info = FileInfo::fromUri(record.uri);
+                if (!info->isLoaded())
+                    apply_record(info.get(), record);
+                infos<<info;
+            }
+            Q_EMIT snapshotLoaded(uri, infos);
+        });
+    });
+}
+
+void DirectorySnapshotCache::saveSnapshot(std::shared_ptr<FileInfo> dirInfo, const QList<std::shared_ptr<FileInfo>> &children)
+{
+    if (!isEnabled())
+        return;
+
+    auto uri = dirInfo->uri();
+    //local directories with a few children are enumerated fast enough.
+    if (uri.startsWith("file://") && children.count() < PEONY_DIRECTORY_SNAPSHOT_MIN_CHILDREN) {
+        removeSnapshot(uri);
+        return;
+    }
+
+    QList<SnapshotRecord> records;
+    for (auto info : children) {
+        if (info->isLoaded())
+            records<<record_from_info(info);
+    }
+
+    //the snapshot is stamped with the directory which was enumerated.
+    bool dir_loaded = dirInfo->isLoaded();
+    quint64 loaded_modified_time = dirInfo->modifiedTime();
+    QString loaded_id = dirInfo->fileID();
+    auto path = snapshotPath(uri);
+
+    auto settings = GlobalSettings::getInstance();
+    qint64 max_size = PEONY_DIRECTORY_SNAPSHOT_DEFAULT_CACHE_SIZE;
+    if (settings->isExist(DIRECTORY_SNAPSHOT_CACHE_SIZE))
+        max_size = settings->getValue(DIRECTORY_SNAPSHOT_CACHE_SIZE).toLongLong();
+    max_size *= 1024*1024;
+
+    QtConcurrent::run([=]() {
+        quint64 dir_modified_time = loaded_modified_time;
+        QString dir_id = loaded_id;
+        if (!dir_loaded && !query_directory_stamp(uri, dir_modified_time, dir_id))
+            return;
+
+        QByteArray bytes;
+        QDataStream stream(&bytes, QIODevice::WriteOnly);
+        stream.setVersion(QDataStream::Qt_5_6);
+        stream<<quint32(SNAPSHOT_MAGIC)<<quint32(SNAPSHOT_VERSION)<<uri<<dir_modified_time<<dir_id<<quint32(records.count());
+        for (auto record : records) {
+            stream<<record;
+        }
+
+        QMutexLocker l(&m_mutex);
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly))
+            return;
+        file.write(bytes);
+        if (!file.commit()) {
+            qDebug()<<"failed to save directory snapshot"<<uri;
+            return;
+        }
+        evict(max_size);
+    });
+}
+
+void DirectorySnapshotCache::removeSnapshot(const QString &uri)
+{
+    QMutexLocker l(&m_mutex);
+    QFile::remove(snapshotPath(uri));
+}
+
+void DirectorySnapshotCache::clear()
+{
+    QMutexLocker l(&m_mutex);
+    QDir dir(m_cache_dir);
+    for (auto name : dir.entryList(QDir::Files)) {
+        dir.remove(name);
+    }
+}
+
+const QString DirectorySnapshotCache::snapshotPath(const QString &uri)
+{
+    auto hash = QCryptographicHash::hash(uri.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return m_cache_dir + "/" + hash + ".snapshot";
+}
+
+void DirectorySnapshotCache::evict(qint64 maxSize)
+{
+    //must be called with m_mutex locked.
+    //snapshots are sorted from the most recently used one.
+    QDir dir(m_cache_dir);
+    auto entries = dir.entryInfoList(QDir::Files, QDir::Time);
+    qint64 total_size = 0;
+    for (auto entry : entries) {
+        total_size += entry.size();
+        if (total_size > maxSize) {
+            dir.remove(entry.fileName());
+        }
+    }
+}
@@ -0,0 +1,117 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#ifndef DIRECTORYSNAPSHOTCACHE_H
+#define DIRECTORYSNAPSHOTCACHE_H
+
+#include "peony-core_global.h"
+
+#include <QObject>
+#include <QMutex>
+
+#include <memory>
+
+#define PEONY_DIRECTORY_SNAPSHOT_MIN_CHILDREN 256
+#define PEONY_DIRECTORY_SNAPSHOT_DEFAULT_CACHE_SIZE 64
+
+namespace Peony {
+
+class FileInfo;
+
+/*!
+ * \brief The DirectorySnapshotCache class
+ * <br>
+ * This class saves the children records of a directory to a snapshot file in
+ * user's cache directory, and loads them when the directory is opened again.
+ * A record contains the attributes the views need, such as name, type, size,
+ * modified time, content type and icon name. The loaded records are applied
+ * to the children infos, so that the model can show the children immediately,
+ * while the enumeration revalidates them in background.
+ * </br>
+ * \note
+ * The snapshot file is memory mapped and parsed in a worker thread. Each snapshot is keyed by the
+ * directory uri, and it records the modified time and file id of the directory,
+ * a snapshot of a changed or replaced directory will be discarded.
+ * The total size of snapshots is bounded by DIRECTORY_SNAPSHOT_CACHE_SIZE, the least
+ * recently used snapshots will be evicted.
+ * The cache is disabled unless DIRECTORY_SNAPSHOT_CACHE is set in GlobalSettings.
+ * \see GlobalSettings, FileItem::findChildrenAsync().
+ */
+class PEONYCORESHARED_EXPORT DirectorySnapshotCache : public QObject
+{
+    Q_OBJECT
+public:
+    static DirectorySnapshotCache *getInstance();
+
+    bool isEnabled();
+
+    /*!
+     * \brief loadSnapshotAsync
+     * \param dirInfo, the info of directory.
+     * \details
+     * the snapshot is read and validated in a worker thread, then the records
+     * are applied to the children infos in ui thread, and snapshotLoaded() is sent.
+     * a snapshot is discarded if the modified time or the file id of directory
+     * has changed since it was saved.
+     * \note the children infos which have been loaded will not be overwritten,
+     * the others are only filled with the recorded display attributes and they
+     * are not taken as loaded.
+     * \see FileInfoJob::preloadInfoContents().
+     */
+    void loadSnapshotAsync(std::shared_ptr<FileInfo> dirInfo);
+
+    /*!
+     * \brief saveSnapshot
+     * \param dirInfo, the info of directory.
+     * \param children, the children infos of directory.
+     * \details
+     * the records are collected in caller's thread, and written in a worker thread.
+     * directories with a few local children are not saved.
+     */
+    void saveSnapshot(std::shared_ptr<FileInfo> dirInfo, const QList<std::shared_ptr<FileInfo>> &children);
+
+    void removeSnapshot(const QString &uri);
+    void clear();
+
+Q_SIGNALS:
+    /*!
+     * \brief snapshotLoaded
+     * \param uri, the uri of directory.
+     * \param infos, the children infos, empty if there is no valid snapshot.
+     */
+    void snapshotLoaded(const QString &uri, const QList<std::shared_ptr<FileInfo>> &infos);
+
+protected:
+    const QString snapshotPath(const QString &uri);
+    void evict(qint64 maxSize);
+
+private:
+    explicit DirectorySnapshotCache(QObject *parent = nullptr);
+
+    QString m_cache_dir;
+    QMutex m_mutex;
+};
+
+}
+
+#endif // DIRECTORYSNAPSHOTCACHE_H
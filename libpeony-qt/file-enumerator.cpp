@@ -22,6 +22,7 @@
 
 #include "file-enumerator.h"
 #include "file-info.h"
+#include "file-info-job.h"
 #include "file-info-manager.h"
 
 #include "mount-operation.h"
@@ -30,6 +31,8 @@
 
 #include "file-utils.h"
 #include "peony-search-vfs-file.h"
+#include "local-file-enumerator.h"
+#include "target-uri-resolver.h"
 
 //play audio lib head file
 #include <canberra.h>
@@ -39,21 +42,58 @@
 
 #include <QDebug>
 #include <QTimer>
+#include <QHash>
+#include <QtConcurrent>
 
 #include <QUrl>
 
-#ifndef PEONY_FIND_NEXT_FILES_BATCH_SIZE
-#define PEONY_FIND_NEXT_FILES_BATCH_SIZE 100
-#endif
-
 using namespace Peony;
 
+static QHash<QString, EnumerateBatchPolicy> *global_batch_policies = nullptr;
+
+static void init_batch_policies()
+{
+    if (global_batch_policies)
+        return;
+
+    global_batch_policies = new QHash<QString, EnumerateBatchPolicy>;
+
+    //local batches are cheap, send children once per frame.
+    EnumerateBatchPolicy local;
+    local.firstBatchSize = 64;
+    local.maxBatchSize = 2048;
+    local.frameBudget = 16;
+    local.flushInterval = 16;
+    global_batch_policies->insert("file", local);
+
+    //every batch is a round trip for remote file systems, keep batches
+    //small and do not flush too often.
+    EnumerateBatchPolicy remote;
+    remote.firstBatchSize = 32;
+    remote.maxBatchSize = 256;
+    remote.frameBudget = 100;
+    remote.flushInterval = 100;
+    for (auto scheme : {"smb", "sftp", "ftp", "dav", "davs", "nfs", "afp", "mtp", "gphoto2", "afc"}) {
+        global_batch_policies->insert(scheme, remote);
+    }
+}
+
+static int next_batch_size(const EnumerateBatchPolicy &policy, int batchSize, qint64 elapsed)
+{
+    if (elapsed < policy.frameBudget)
+        return qMin(batchSize*2, policy.maxBatchSize);
+    if (elapsed > 2*policy.frameBudget)
+        return qMax(batchSize/2, policy.firstBatchSize);
+    return batchSize;
+}
+
 FileEnumerator::FileEnumerator(QObject *parent) : QObject(parent)
 {
     m_root_file = g_file_new_for_uri("file:///");
     m_cancellable = g_cancellable_new();
 
     m_children_uris = new QList<QString>();
+    m_children_infos = new QList<std::shared_ptr<FileInfo>>();
 
     m_cache_uris = new QStringList();
 
@@ -67,17 +107,11 @@ FileEnumerator::FileEnumerator(QObject *parent) : QObject(parent)
     });
 
     connect(this, &FileEnumerator::enumerateFinished, this, [=](){
-        *m_children_uris<<*m_cache_uris;
-        childrenUpdated(*m_cache_uris);
-        m_cache_uris->clear();
+        flushCachedUris();
         m_idle->stop();
     });
 
-    connect(m_idle, &QTimer::timeout, this, [=](){
-        *m_children_uris<<*m_cache_uris;
-        childrenUpdated(*m_cache_uris);
-        m_cache_uris->clear();
-    });
+    connect(m_idle, &QTimer::timeout, this, &FileEnumerator::flushCachedUris);
 }
 
 /*!
@@ -97,20 +131,38 @@ FileEnumerator::FileEnumerator(QObject *parent) : QObject(parent)
 FileEnumerator::~FileEnumerator()
 {
     g_cancellable_cancel(m_cancellable);
+    //the local enumerating worker posts results to this object.
+    m_local_future.waitForFinished();
+    clearPreparedEnumerator();
     disconnect();
     //qDebug()<<"~FileEnumerator";
     g_object_unref(m_root_file);
     g_object_unref(m_cancellable);
 
     delete m_children_uris;
+    delete m_children_infos;
 
     delete m_cache_uris;
 }
 
+void FileEnumerator::setBatchPolicy(const QString &scheme, const EnumerateBatchPolicy &policy)
+{
+    init_batch_policies();
+    global_batch_policies->insert(scheme, policy);
+}
+
+const EnumerateBatchPolicy FileEnumerator::batchPolicy(const QString &scheme)
+{
+    init_batch_policies();
+    return global_batch_policies->value(scheme, EnumerateBatchPolicy());
+}
+
 void FileEnumerator::setEnumerateDirectory(QString uri)
 {
     m_uri = uri;
 
+    clearPreparedEnumerator();
+
     if (m_cancellable) {
         g_cancellable_cancel(m_cancellable);
         g_object_unref(m_cancellable);
@@ -139,6 +191,8 @@ void FileEnumerator::setEnumerateDirectory(QString uri)
 
 void FileEnumerator::setEnumerateDirectory(GFile *file)
 {
+    clearPreparedEnumerator();
+
     if (m_cancellable) {
         g_cancellable_cancel(m_cancellable);
         g_object_unref(m_cancellable);
@@ -181,55 +235,115 @@ void FileEnumerator::cancel()
     g_object_unref(m_cancellable);
     m_cancellable = g_cancellable_new();
 
+    clearPreparedEnumerator();
+
     m_children_uris->clear();
+    m_children_infos->clear();
 
     Q_EMIT enumerateFinished(false);
 }
 
 void FileEnumerator::prepare()
 {
-    GError *err = nullptr;
-    GFileEnumerator *enumerator = g_file_enumerate_children(m_root_file,
-                                  G_FILE_ATTRIBUTE_STANDARD_NAME,
-                                  G_FILE_QUERY_INFO_NONE,
-                                  m_cancellable,
-                                  &err);
+    clearPreparedEnumerator();
+    m_target_uri.clear();
+    m_can_mount = false;
+
+    //native directories have no target uri and can not be mounted,
+    //open them directly.
+    if (LocalFileEnumerator::isSupported(m_root_file)) {
+        prepareLocalAsync();
+        return;
+    }
 
-    if (err) {
-        //do not send prepared(err) here, wait handle err finished.
-        handleError(err);
-        g_error_free(err);
-    } else {
-        //even though there is no err, we still need to wait a little while
-        //for confirming other object will recieve this signal, you can aslo
-        //connect prepared signal before prepared() method to confirm that.
-        //Q_EMIT prepared(nullptr);
-        g_object_unref(enumerator);
+    //a known target uri is enough for redirecting, the mountable
+    //attribute is only needed if there is no target uri.
+    QString targetUri;
+    if (TargetUriResolver::getInstance()->lookup(m_uri, targetUri) && !targetUri.isEmpty()) {
+        m_target_uri = targetUri;
+        prepareGioAsync();
+        return;
+    }
+
+    //prepared signal is always sent asynchronously, so that the receivers
+    //connected after prepare() called will not miss it.
+    g_file_query_info_async(m_root_file,
+                            G_FILE_ATTRIBUTE_STANDARD_TARGET_URI "," G_FILE_ATTRIBUTE_MOUNTABLE_CAN_MOUNT,
+                            G_FILE_QUERY_INFO_NONE,
+                            G_PRIORITY_DEFAULT,
+                            m_cancellable,
+                            GAsyncReadyCallback(prepare_query_info_async_ready_callback),
+                            this);
+}
 
-        QTimer::singleShot(100, this, [=]() {
+void FileEnumerator::prepareLocalAsync()
+{
+    m_local_future.waitForFinished();
+
+    GFile *dir = g_file_dup(m_root_file);
+    auto cancellable = std::shared_ptr<GCancellable>(G_CANCELLABLE(g_object_ref(m_cancellable)), g_object_unref);
+    bool withInfo = m_with_info;
+
+    m_local_future = QtConcurrent::run([=]() {
+        auto enumerator = std::make_shared<LocalFileEnumerator>(dir, withInfo);
+        g_object_unref(dir);
+        bool opened = enumerator->open(cancellable.get());
+
+        QTimer::singleShot(0, this, [=]() {
+            if (g_cancellable_is_cancelled(cancellable.get()))
+                return;
+            if (!opened) {
+                //let GIO report the error, see handleError().
+                prepareGioAsync();
+                return;
+            }
+            m_prepared_local_enumerator = enumerator;
             Q_EMIT prepared(nullptr);
         });
+    });
+}
+
+void FileEnumerator::prepareGioAsync()
+{
+    g_file_enumerate_children_async(m_root_file,
+                                    queryAttributes(),
+                                    G_FILE_QUERY_INFO_NONE,
+                                    G_PRIORITY_DEFAULT,
+                                    m_cancellable,
+                                    GAsyncReadyCallback(prepare_enumerate_async_ready_callback),
+                                    this);
+}
+
+void FileEnumerator::refreshTargetUri()
+{
+    g_file_query_info_async(m_root_file,
+                            G_FILE_ATTRIBUTE_STANDARD_TARGET_URI,
+                            G_FILE_QUERY_INFO_NONE,
+                            G_PRIORITY_DEFAULT,
+                            m_cancellable,
+                            GAsyncReadyCallback(refresh_target_uri_async_ready_callback),
+                            this);
+}
+
+void FileEnumerator::clearPreparedEnumerator()
+{
+    if (m_prepared_enumerator) {
+        g_file_enumerator_close_async(m_prepared_enumerator, 0, nullptr, nullptr, nullptr);
+        g_object_unref(m_prepared_enumerator);
+        m_prepared_enumerator = nullptr;
     }
+    m_prepared_local_enumerator.reset();
 }
 
 GFile *FileEnumerator::enumerateTargetFile()
 {
-    //FIXME: replace BLOCKING api in ui thread.
-    GFileInfo *info = g_file_query_info(m_root_file,
-                                        G_FILE_ATTRIBUTE_STANDARD_TARGET_URI,
-                                        G_FILE_QUERY_INFO_NONE,
-                                        nullptr,
-                                        nullptr);
-    char *uri = nullptr;
-    uri = g_file_info_get_attribute_as_string(info,
-            G_FILE_ATTRIBUTE_STANDARD_TARGET_URI);
-    g_object_unref(info);
+    //enumerateSync() is blocking, the target uri is queried only if it is not cached.
+    auto uri = TargetUriResolver::getInstance()->resolveSync(m_uri);
 
     GFile *target = nullptr;
-    if (uri) {
+    if (!uri.isEmpty()) {
         //qDebug()<<"enumerateTargetFile"<<uri;
-        target = g_file_new_for_uri(uri);
-        g_free(uri);
+        target = g_file_new_for_uri(uri.toUtf8().constData());
     } else {
         target = g_file_dup(m_root_file);
     }
@@ -243,7 +357,7 @@ void FileEnumerator::enumerateSync()
     GFile *target = enumerateTargetFile();
 
     GFileEnumerator *enumerator = g_file_enumerate_children(target,
-                                  G_FILE_ATTRIBUTE_STANDARD_NAME,
+                                  queryAttributes(),
                                   G_FILE_QUERY_INFO_NONE,
                                   m_cancellable,
                                   nullptr);
@@ -277,26 +391,13 @@ void FileEnumerator::handleError(GError *err)
     //eventid 是/usr/share/sounds音频文件名,不带后缀
     switch (err->code) {
     case G_IO_ERROR_NOT_DIRECTORY: {
-        auto uri = g_file_get_uri(m_root_file);
-        //FIXME: replace BLOCKING api in ui thread.
-        auto targetUri = FileUtils::getTargetUri(uri);
-        if (uri) {
-            g_free(uri);
-        }
-        if (!targetUri.isEmpty()) {
-            prepared(nullptr, targetUri);
+        //the target uri and mountable attribute are queried in prepare().
+        if (!m_target_uri.isEmpty()) {
+            Q_EMIT prepared(nullptr, m_target_uri);
             return;
         }
 
-        bool isMountable = false;
-        //FIXME: replace BLOCKING api in ui thread.
-        GFileInfo *file_mount_info = g_file_query_info(m_root_file, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_MOUNT,
-                                     G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, nullptr, nullptr);
-
-        if (file_mount_info) {
-            isMountable = g_file_info_get_attribute_boolean(file_mount_info, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_MOUNT);
-            g_object_unref(file_mount_info);
-        }
+        bool isMountable = m_can_mount;
 
         if (isMountable) {
             g_file_mount_mountable(m_root_file,
@@ -340,19 +441,45 @@ void FileEnumerator::handleError(GError *err)
         Q_EMIT prepared(GErrorWrapper::wrapFrom(g_error_new(G_IO_ERROR, G_IO_ERROR_NOT_FOUND, "file not found")));
         break;
     default:
-        Q_EMIT prepared(GErrorWrapper::wrapFrom(err), nullptr, true);
+        //the caller owns err.
+        Q_EMIT prepared(GErrorWrapper::wrapFrom(g_error_copy(err)), nullptr, true);
         break;
     }
 }
 
 void FileEnumerator::enumerateAsync()
 {
-    m_idle->start(1000);
+    char *scheme = g_file_get_uri_scheme(m_root_file);
+    m_policy = batchPolicy(scheme);
+    g_free(scheme);
+    m_batch_size = m_policy.firstBatchSize;
+    m_batch_count = 0;
+
+    m_idle->start(m_policy.flushInterval);
 
+    if (m_prepared_local_enumerator || LocalFileEnumerator::isSupported(m_root_file)) {
+        enumerateLocalAsync();
+        return;
+    }
+
+    if (m_prepared_enumerator) {
+        //continue with the directory opened in prepare().
+        GFileEnumerator *enumerator = m_prepared_enumerator;
+        m_prepared_enumerator = nullptr;
+        requestNextFiles(enumerator);
+        g_object_unref(enumerator);
+        return;
+    }
+
+    enumerateGioAsync();
+}
+
+void FileEnumerator::enumerateGioAsync()
+{
     //auto uri = g_file_get_uri(m_root_file);
     //auto path = g_file_get_path(m_root_file);
     g_file_enumerate_children_async(m_root_file,
-                                    G_FILE_ATTRIBUTE_STANDARD_NAME,
+                                    queryAttributes(),
                                     G_FILE_QUERY_INFO_NONE,
                                     G_PRIORITY_DEFAULT,
                                     m_cancellable,
@@ -381,12 +508,14 @@ void FileEnumerator::enumerateChildren(GFileEnumerator *enumerator)
         if (path && !url.isLocalFile()) {
             QString localUri = QString("file://%1").arg(path);
             *m_children_uris<<localUri;
+            handleChildInfo(localUri, info);
             g_free(path);
         } else {
             if (path) {
                 g_free(path);
             }
             *m_children_uris<<uri;
+            handleChildInfo(uri, info);
         }
 
         g_free(uri);
@@ -396,6 +525,130 @@ void FileEnumerator::enumerateChildren(GFileEnumerator *enumerator)
     Q_EMIT enumerateFinished(true);
 }
 
+void FileEnumerator::handleChildInfo(const QString &uri, GFileInfo *info)
+{
+    if (!m_with_info || !info)
+        return;
+
+    auto fileInfo = FileInfo::fromUri(uri);
+    FileInfoJob::refreshInfoContents(fileInfo.get(), info);
+    *m_children_infos<<fileInfo;
+}
+
+const char *FileEnumerator::queryAttributes()
+{
+    if (m_with_info)
+        return PEONY_FILE_INFO_QUERY_ATTRIBUTES;
+    return G_FILE_ATTRIBUTE_STANDARD_NAME;
+}
+
+void FileEnumerator::requestNextFiles(GFileEnumerator *enumerator)
+{
+    m_batch_timer.start();
+    g_file_enumerator_next_files_async(enumerator,
+                                       m_batch_size,
+                                       G_PRIORITY_DEFAULT,
+                                       m_cancellable,
+                                       GAsyncReadyCallback(enumerator_next_files_async_ready_callback),
+                                       this);
+}
+
+void FileEnumerator::adjustBatchSize()
+{
+    m_batch_size = next_batch_size(m_policy, m_batch_size, m_batch_timer.elapsed());
+}
+
+void FileEnumerator::flushCachedUris()
+{
+    if (m_cache_uris->isEmpty())
+        return;
+
+    *m_children_uris<<*m_cache_uris;
+    auto uris = *m_cache_uris;
+    m_cache_uris->clear();
+    Q_EMIT childrenUpdated(uris);
+}
+
+void FileEnumerator::enumerateLocalAsync()
+{
+    //the previous worker has been cancelled with its cancellable.
+    m_local_future.waitForFinished();
+
+    GFile *dir = g_file_dup(m_root_file);
+    auto cancellable = std::shared_ptr<GCancellable>(G_CANCELLABLE(g_object_ref(m_cancellable)), g_object_unref);
+    bool withInfo = m_with_info;
+    auto policy = m_policy;
+    //the directory might have been opened in prepare().
+    auto preparedEnumerator = m_prepared_local_enumerator;
+    m_prepared_local_enumerator.reset();
+
+    m_local_future = QtConcurrent::run([=]() {
+        auto enumerator = preparedEnumerator;
+        if (!enumerator) {
+            enumerator = std::make_shared<LocalFileEnumerator>(dir, withInfo);
+        }
+        g_object_unref(dir);
+
+        if (!preparedEnumerator && !enumerator->open(cancellable.get())) {
+            QTimer::singleShot(0, this, [=]() {
+                if (!g_cancellable_is_cancelled(cancellable.get()))
+                    enumerateGioAsync();
+            });
+            return;
+        }
+
+        int batchSize = policy.firstBatchSize;
+        int found = 0;
+        bool hasNext = true;
+        while (hasNext && !g_cancellable_is_cancelled(cancellable.get())) {
+            QElapsedTimer timer;
+            timer.start();
+
+            //the infos are released with the batch, even if it is never delivered.
+            auto batch = std::shared_ptr<QList<LocalFileEntry>>(new QList<LocalFileEntry>, [](QList<LocalFileEntry> *children) {
+                for (auto child : *children) {
+                    if (child.info)
+                        g_object_unref(child.info);
+                }
+                delete children;
+            });
+            hasNext = enumerator->nextFiles(batchSize, *batch);
+            batchSize = next_batch_size(policy, batchSize, timer.elapsed());
+            if (batch->isEmpty())
+                continue;
+            found += batch->count();
+
+            QTimer::singleShot(0, this, [=]() {
+                if (g_cancellable_is_cancelled(cancellable.get()))
+                    return;
+                for (auto child : *batch) {
+                    *m_cache_uris<<child.uri;
+                    handleChildInfo(child.uri, child.info);
+                }
+                //send the first batch at once for the first paint.
+                if (m_batch_count == 0) {
+                    flushCachedUris();
+                }
+                m_batch_count++;
+            });
+        }
+
+        bool failed = enumerator->error() != 0;
+        QTimer::singleShot(0, this, [=]() {
+            if (g_cancellable_is_cancelled(cancellable.get()))
+                return;
+            if (failed && found == 0) {
+                //let GIO handle the error.
+                enumerateGioAsync();
+                return;
+            }
+            //the listing is incomplete if some children were found before the error,
+            //the receivers must not take the unseen children as deleted.
+            Q_EMIT enumerateFinished(!failed);
+        });
+    });
+}
+
 GAsyncReadyCallback FileEnumerator::mount_mountable_callback(GFile *file,
         GAsyncResult *res,
         FileEnumerator *p_this)
@@ -416,7 +669,8 @@ GAsyncReadyCallback FileEnumerator::mount_mountable_callback(GFile *file,
         auto err_data = GErrorWrapper::wrapFrom(err);
         Q_EMIT p_this->prepared(err_data);
     } else {
-        Q_EMIT p_this->prepared(nullptr);
+        //the target uri might be available after mounted.
+        p_this->refreshTargetUri();
         if (err) {
             g_error_free(err);
         }
@@ -443,7 +697,7 @@ GAsyncReadyCallback FileEnumerator::mount_enclosing_volume_callback(GFile *file,
             qDebug()<<"mount successed, err:"<<err->code<<err->message;
             Q_EMIT p_this->prepared(GErrorWrapper::wrapFrom(err), nullptr, true);
         } else {
-            Q_EMIT p_this->prepared();
+            p_this->refreshTargetUri();
         }
     } else {
         if (err) {
@@ -484,7 +738,7 @@ GAsyncReadyCallback FileEnumerator::mount_enclosing_volume_callback(GFile *file,
                     }
                     Q_EMIT p_this->prepared(finished_err);
                 } else {
-                    Q_EMIT p_this->prepared(nullptr);
+                    p_this->refreshTargetUri();
                 }
             });
             op->start();
@@ -493,6 +747,79 @@ GAsyncReadyCallback FileEnumerator::mount_enclosing_volume_callback(GFile *file,
     return nullptr;
 }
 
+GAsyncReadyCallback FileEnumerator::prepare_query_info_async_ready_callback(GFile *file,
+        GAsyncResult *res,
+        FileEnumerator *p_this)
+{
+    GError *err = nullptr;
+    GFileInfo *info = g_file_query_info_finish(file, res, &err);
+    if (err) {
+        if (err->code == G_IO_ERROR_CANCELLED) {
+            g_error_free(err);
+            return nullptr;
+        }
+        //the error will be reported again while opening the directory.
+        g_error_free(err);
+    }
+
+    if (info) {
+        p_this->m_target_uri = g_file_info_get_attribute_string(info, G_FILE_ATTRIBUTE_STANDARD_TARGET_URI);
+        p_this->m_can_mount = g_file_info_get_attribute_boolean(info, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_MOUNT);
+        TargetUriResolver::getInstance()->insert(p_this->m_uri, p_this->m_target_uri);
+        g_object_unref(info);
+    }
+
+    p_this->prepareGioAsync();
+    return nullptr;
+}
+
+GAsyncReadyCallback FileEnumerator::prepare_enumerate_async_ready_callback(GFile *file,
+        GAsyncResult *res,
+        FileEnumerator *p_this)
+{
+    GError *err = nullptr;
+    GFileEnumerator *enumerator = g_file_enumerate_children_finish(file, res, &err);
+    if (err) {
+        if (err->code == G_IO_ERROR_CANCELLED) {
+            g_error_free(err);
+            return nullptr;
+        }
+        //do not send prepared(err) here, wait handle err finished.
+        p_this->handleError(err);
+        g_error_free(err);
+        return nullptr;
+    }
+
+    //keep the enumerator for enumerateAsync().
+    p_this->m_prepared_enumerator = enumerator;
+    Q_EMIT p_this->prepared(nullptr);
+    return nullptr;
+}
+
+GAsyncReadyCallback FileEnumerator::refresh_target_uri_async_ready_callback(GFile *file,
+        GAsyncResult *res,
+        FileEnumerator *p_this)
+{
+    GError *err = nullptr;
+    GFileInfo *info = g_file_query_info_finish(file, res, &err);
+    if (err) {
+        if (err->code == G_IO_ERROR_CANCELLED) {
+            g_error_free(err);
+            return nullptr;
+        }
+        g_error_free(err);
+    }
+
+    if (info) {
+        p_this->m_target_uri = g_file_info_get_attribute_string(info, G_FILE_ATTRIBUTE_STANDARD_TARGET_URI);
+        TargetUriResolver::getInstance()->insert(p_this->m_uri, p_this->m_target_uri);
+        g_object_unref(info);
+    }
+
+    Q_EMIT p_this->prepared(nullptr);
+    return nullptr;
+}
+
 GAsyncReadyCallback FileEnumerator::find_children_async_ready_callback(GFile *file,
         GAsyncResult *res,
         FileEnumerator *p_this)
@@ -522,13 +849,8 @@ GAsyncReadyCallback FileEnumerator::find_children_async_ready_callback(GFile *fi
             Q_EMIT p_this->enumerateFinished(false);
         return nullptr;
     }
-    //
-    g_file_enumerator_next_files_async(enumerator,
-                                       PEONY_FIND_NEXT_FILES_BATCH_SIZE,
-                                       G_PRIORITY_DEFAULT,
-                                       p_this->m_cancellable,
-                                       GAsyncReadyCallback(enumerator_next_files_async_ready_callback),
-                                       p_this);
+    //the first batch is small, see EnumerateBatchPolicy.
+    p_this->requestNextFiles(enumerator);
 
     g_object_unref(enumerator);
     return nullptr;
@@ -584,10 +906,15 @@ GAsyncReadyCallback FileEnumerator::enumerator_next_files_async_ready_callback(G
             QString localUri = QString("file://%1").arg(path);
             uriList<<localUri;
             *(p_this->m_cache_uris)<<localUri;
+            p_this->handleChildInfo(localUri, info);
             g_free(path);
         } else {
+            if (path) {
+                g_free(path);
+            }
             uriList<<uri;
             *(p_this->m_cache_uris)<<uri;
+            p_this->handleChildInfo(uri, info);
         }
 
         g_free(uri);
@@ -597,14 +924,17 @@ GAsyncReadyCallback FileEnumerator::enumerator_next_files_async_ready_callback(G
     g_list_free_full(files, g_object_unref);
     //Q_EMIT p_this->childrenUpdated(uriList);
 
-    if (files_count == PEONY_FIND_NEXT_FILES_BATCH_SIZE) {
+    //send the first batch at once for the first paint, the others
+    //are sent by idle timer.
+    if (p_this->m_batch_count == 0) {
+        p_this->flushCachedUris();
+    }
+    p_this->m_batch_count++;
+
+    if (files_count == p_this->m_batch_size) {
         //have next files, countinue.
-        g_file_enumerator_next_files_async(enumerator,
-                                           PEONY_FIND_NEXT_FILES_BATCH_SIZE,
-                                           G_PRIORITY_DEFAULT,
-                                           p_this->m_cancellable,
-                                           GAsyncReadyCallback(enumerator_next_files_async_ready_callback),
-                                           p_this);
+        p_this->adjustBatchSize();
+        p_this->requestNextFiles(enumerator);
     } else {
         //no next files, emit finished.
         //qDebug()<<"async enumerateFinished";
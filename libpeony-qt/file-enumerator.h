@@ -24,6 +24,8 @@
 #define FILEENUMERATOR_H
 
 #include <QObject>
+#include <QElapsedTimer>
+#include <QFuture>
 #include "peony-core_global.h"
 
 #include <memory>
@@ -35,6 +37,26 @@ namespace Peony {
 
 class FileInfo;
 class GErrorWrapper;
+class LocalFileEnumerator;
+
+/*!
+ * \brief The EnumerateBatchPolicy struct
+ * <br>
+ * Describe how FileEnumerator delivers the enumerated children asynchronously.
+ * The first batch is small and sent at once, so that the first screenful of
+ * a view can be painted quickly. Then the batch size grows while a batch takes
+ * less than frameBudget milliseconds, and shrinks while it takes more. The
+ * enumerated children are sent every flushInterval milliseconds.
+ * </br>
+ * \see FileEnumerator::setBatchPolicy().
+ */
+struct PEONYCORESHARED_EXPORT EnumerateBatchPolicy
+{
+    int firstBatchSize = 64;
+    int maxBatchSize = 1024;
+    int frameBudget = 16;
+    int flushInterval = 16;
+};
 
 /*!
  * \brief The FileEnumerator class
@@ -70,9 +92,25 @@ public:
      * of prepare done, then we can enumerate the file, or get something
      * error messages. we should connect prepared() signal for async.
      * </br>
-     * \see prepared().
+     * <br>
+     * The directory opened while preparing is kept, and the following
+     * enumerateAsync() continues with it rather than opening the directory
+     * again. There is no blocking call in prepare(), the target uri and
+     * the mountable attribute of the directory are queried asynchronously
+     * before opening it.
+     * </br>
+     * \see prepared(), preparedTargetUri().
      */
     void prepare();
+    /*!
+     * \brief preparedTargetUri
+     * \return the target uri of the enumerate directory queried in prepare(),
+     * it is empty if the directory has no target uri.
+     * \note it is only valid after prepared() sent.
+     */
+    const QString preparedTargetUri() {
+        return m_target_uri;
+    }
     /*!
      * \brief enumerateSync
      * <br>
@@ -94,10 +132,55 @@ public:
         return *m_children_uris;
     }
 
+    /*!
+     * \brief releaseChildren
+     * drop the children uris and infos enumerated so far. it is used by
+     * the receivers which keep the children in their own way, such as a
+     * virtual FileItem, so that a huge directory is not held twice.
+     * \see FileItem::isVirtual().
+     */
+    void releaseChildren() {
+        m_children_uris->clear();
+        m_children_infos->clear();
+    }
+
     void setAutoDelete(bool autoDelete = true) {
         m_auto_delete = true;
     }
 
+    /*!
+     * \brief setEnumerateWithInfo
+     * \param withInfo
+     * <br>
+     * By default, enumerator only query the name of children, and the info of
+     * children should be queried by FileInfoJob later. If withInfo is true,
+     * enumerator will query all the attributes FileInfo needs while enumerating,
+     * and fill the children's FileInfo with the result directly.
+     * That means the children got from getChildren() or FileInfo::fromUri()
+     * are already loaded, there is no need to start a FileInfoJob for them.
+     * </br>
+     * \note this should be set before enumerating.
+     * \see FileInfoJob::refreshInfoContents().
+     */
+    void setEnumerateWithInfo(bool withInfo = true) {
+        m_with_info = withInfo;
+    }
+    bool isEnumerateWithInfo() {
+        return m_with_info;
+    }
+
+    /*!
+     * \brief setBatchPolicy
+     * \param scheme, uri scheme such as "file", "smb" or "sftp".
+     * \param policy
+     * <br>
+     * Tune the async enumeration of all the uris with the scheme. There are
+     * default policies for local file system and remote file systems.
+     * </br>
+     */
+    static void setBatchPolicy(const QString &scheme, const EnumerateBatchPolicy &policy);
+    static const EnumerateBatchPolicy batchPolicy(const QString &scheme);
+
 Q_SIGNALS:
     /*!
      * \brief prepared
@@ -155,11 +238,67 @@ protected:
      *
      */
     void handleError(GError *err);
+    /*!
+     * \brief prepareLocalAsync
+     * open a native directory with LocalFileEnumerator in a worker thread.
+     * if it failed, prepareGioAsync() is used to get the GIO error.
+     */
+    void prepareLocalAsync();
+    void prepareGioAsync();
+    /*!
+     * \brief refreshTargetUri
+     * query the target uri again after the directory mounted, then send prepared().
+     */
+    void refreshTargetUri();
+    /*!
+     * \brief clearPreparedEnumerator
+     * close the directory opened in prepare() but not enumerated.
+     */
+    void clearPreparedEnumerator();
     /*!
      * \brief enumerateChildren, a sync method enumerate children and cached their GFile handle.
      * \param enumerator, handle of enum next file.
      */
     void enumerateChildren(GFileEnumerator *enumerator);
+    /*!
+     * \brief handleChildInfo
+     * \param uri
+     * \param info, the enumerated GFileInfo of child.
+     * \details
+     * if enumerator is enumerating with info, fill the child's FileInfo
+     * with the enumerated GFileInfo.
+     * \see setEnumerateWithInfo().
+     */
+    void handleChildInfo(const QString &uri, GFileInfo *info);
+    /*!
+     * \brief queryAttributes
+     * \return the attributes enumerator should query.
+     */
+    const char *queryAttributes();
+    /*!
+     * \brief requestNextFiles
+     * \param enumerator
+     * request next batch of children with current batch size.
+     */
+    void requestNextFiles(GFileEnumerator *enumerator);
+    /*!
+     * \brief adjustBatchSize
+     * grow or shrink the batch size with the time last batch took.
+     */
+    void adjustBatchSize();
+    void flushCachedUris();
+
+    /*!
+     * \brief enumerateLocalAsync
+     * <br>
+     * Enumerate a native directory with LocalFileEnumerator in a worker thread.
+     * The batches are delivered in the same way as GIO enumeration. If the fast
+     * path fails before any child found, GIO enumeration is used instead.
+     * </br>
+     * \see LocalFileEnumerator.
+     */
+    void enumerateLocalAsync();
+    void enumerateGioAsync();
     /*!
      * \brief enumerateTargetFile
      * \return target uri which original uri point to.
@@ -195,6 +334,42 @@ protected:
             GAsyncResult *res,
             FileEnumerator *p_this);
 
+    /*!
+     * \brief prepare_query_info_async_ready_callback
+     * \param file
+     * \param res
+     * \param p_this
+     * \return
+     * \see prepare().
+     */
+    static GAsyncReadyCallback prepare_query_info_async_ready_callback(GFile *file,
+            GAsyncResult *res,
+            FileEnumerator *p_this);
+
+    /*!
+     * \brief prepare_enumerate_async_ready_callback
+     * \param file
+     * \param res
+     * \param p_this
+     * \return
+     * \see prepare().
+     */
+    static GAsyncReadyCallback prepare_enumerate_async_ready_callback(GFile *file,
+            GAsyncResult *res,
+            FileEnumerator *p_this);
+
+    /*!
+     * \brief refresh_target_uri_async_ready_callback
+     * \param file
+     * \param res
+     * \param p_this
+     * \return
+     * \see refreshTargetUri().
+     */
+    static GAsyncReadyCallback refresh_target_uri_async_ready_callback(GFile *file,
+            GAsyncResult *res,
+            FileEnumerator *p_this);
+
     /*!
      * \brief find_children_async_ready_callback
      * \param file
@@ -230,7 +405,31 @@ private:
     QStringList *m_cache_uris;
     QTimer *m_idle;
 
+    EnumerateBatchPolicy m_policy;
+    int m_batch_size = 0;
+    int m_batch_count = 0;
+    QElapsedTimer m_batch_timer;
+
+    QFuture<void> m_local_future;
+
+    /*!
+     * \brief m_prepared_enumerator
+     * the directory opened in prepare(), reused by enumerateAsync().
+     */
+    GFileEnumerator *m_prepared_enumerator = nullptr;
+    std::shared_ptr<LocalFileEnumerator> m_prepared_local_enumerator;
+    QString m_target_uri;
+    bool m_can_mount = false;
+
     bool m_auto_delete = false;
+
+    bool m_with_info = false;
+    /*!
+     * \brief m_children_infos
+     * hold the children infos queried in enumeration with info,
+     * so that they will not be released before the holders get them.
+     */
+    QList<std::shared_ptr<FileInfo>> *m_children_infos = nullptr;
 };
 
 }
@@ -0,0 +1,300 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "file-info-batch-job.h"
+
+#include "file-info.h"
+#include "file-info-job.h"
+#include "local-file-enumerator.h"
+#include "uring-statx-engine.h"
+
+#include <QtConcurrent>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <QDebug>
+
+using namespace Peony;
+
+static GFileInfo *query_file_info(const QByteArray &uri, GCancellable *cancellable)
+{
+    GFile *file = g_file_new_for_uri(uri.constData());
+    GError *err = nullptr;
+    auto g_info = g_file_query_info(file,
+                                    PEONY_FILE_INFO_QUERY_ATTRIBUTES,
+                                    G_FILE_QUERY_INFO_NONE,
+                                    cancellable,
+                                    &err);
+    g_object_unref(file);
+
+    if (err) {
+        qDebug()<<err->code<<err->message;
+        g_error_free(err);
+    }
+    return g_info;
+}
+
+static QThreadPool *query_pool()
+{
+    //a separate pool, the queries of remote files might block for long.
+    static QThreadPool *pool = []() {
+        auto pool = new QThreadPool;
+        pool->setMaxThreadCount(PEONY_FILE_INFO_BATCH_QUERY_THREADS);
+        return pool;
+    }();
+    return pool;
+}
+
+/*!
+ * \brief query_file_infos
+ * query the uris with blocking queries in several threads, so that the
+ * round-trips of remote files are not waited one by one.
+ * \return the queried infos in the order of uris, nullptr for the failed ones.
+ */
+static QVector<GFileInfo *> query_file_infos(const QList<QByteArray> &uris, GCancellable *cancellable)
+{
+    QVector<GFileInfo *> g_infos(uris.count());
+    GFileInfo **data = g_infos.data();
+    int slices = qMin(uris.count(), PEONY_FILE_INFO_BATCH_QUERY_THREADS);
+    auto querySlice = [=, &uris](int slice) {
+        for (int i = slice; i < uris.count(); i += slices) {
+            if (g_cancellable_is_cancelled(cancellable))
+                break;
+            data[i] = query_file_info(uris.at(i), cancellable);
+        }
+    };
+
+    QList<QFuture<void>> futures;
+    for (int slice = 1; slice < slices; slice++) {
+        futures<<QtConcurrent::run(query_pool(), [=]() {
+            querySlice(slice);
+        });
+    }
+    querySlice(0);
+    for (auto future : futures) {
+        future.waitForFinished();
+    }
+    return g_infos;
+}
+
+/*!
+ * \brief local_children_run
+ * \param uris
+ * \param start
+ * \param names, the names of children in the run are appended to it.
+ * \return the directory if the consecutive uris from start are children of
+ * a same local directory, otherwise nullptr.
+ */
+static GFile *local_children_run(const QList<QByteArray> &uris, int start, QList<QByteArray> &names)
+{
+    GFile *file = g_file_new_for_uri(uris.at(start).constData());
+    GFile *parent = g_file_get_parent(file);
+    g_object_unref(file);
+    if (!parent)
+        return nullptr;
+    if (!LocalFileEnumerator::isSupported(parent)) {
+        g_object_unref(parent);
+        return nullptr;
+    }
+
+    for (int i = start; i < uris.count(); i++) {
+        GFile *child = g_file_new_for_uri(uris.at(i).constData());
+        GFile *child_parent = g_file_get_parent(child);
+        bool sameParent = child_parent && g_file_equal(parent, child_parent);
+        if (child_parent)
+            g_object_unref(child_parent);
+        if (!sameParent) {
+            g_object_unref(child);
+            break;
+        }
+        char *name = g_file_get_basename(child);
+        names<<QByteArray(name);
+        g_free(name);
+        g_object_unref(child);
+    }
+    return parent;
+}
+
+FileInfoBatchJob::FileInfoBatchJob(const QList<std::shared_ptr<FileInfo>> &infos, QObject *parent) : QObject(parent)
+{
+    m_infos = infos;
+    m_cancellable = g_cancellable_new();
+}
+
+FileInfoBatchJob::FileInfoBatchJob(const QStringList &uris, QObject *parent) : QObject(parent)
+{
+    for (auto uri : uris) {
+        m_infos<<FileInfo::fromUri(uri);
+    }
+    m_cancellable = g_cancellable_new();
+}
+
+FileInfoBatchJob::~FileInfoBatchJob()
+{
+    //the worker holds this job, wait for it.
+    g_cancellable_cancel(m_cancellable);
+    m_future.waitForFinished();
+    g_object_unref(m_cancellable);
+}
+
+bool FileInfoBatchJob::isCancelled()
+{
+    return g_cancellable_is_cancelled(m_cancellable);
+}
+
+void FileInfoBatchJob::cancel()
+{
+    g_cancellable_cancel(m_cancellable);
+    if (!m_future.isRunning() && !m_finished) {
+        //the job has not been started, or there is nothing to wait.
+        finish();
+    }
+}
+
+void FileInfoBatchJob::queryAsync()
+{
+    if (m_future.isRunning() || m_finished)
+        return;
+
+    if (isCancelled() || m_infos.isEmpty()) {
+        finish();
+        return;
+    }
+
+    //do not touch the shared infos in worker thread, query them by uris.
+    QList<QByteArray> uris;
+    for (auto info : m_infos) {
+        uris<<info->uriAtom().utf8();
+    }
+    int chunk_size = m_chunk_size;
+    GCancellable *cancellable = m_cancellable;
+
+    m_future = QtConcurrent::run([=]() {
+        QList<int> indexes;
+        QList<GFileInfoWrapperPtr> g_infos;
+        bool uring = UringStatxEngine::isSupported();
+        //the children of a local directory are queried with one enumerator,
+        //which is opened once for the whole run of them.
+        std::unique_ptr<LocalFileEnumerator> enumerator;
+        QList<QByteArray> run_names;
+        int run_start = 0;
+        int run_end = 0;
+        int i = 0;
+        while (i < uris.count()) {
+            if (g_cancellable_is_cancelled(cancellable))
+                break;
+
+            if (uring && i >= run_end) {
+                enumerator.reset();
+                run_names.clear();
+                GFile *dir = local_children_run(uris, i, run_names);
+                run_start = i;
+                run_end = i + qMax(1, run_names.count());
+                //it is only worth when the batch is large enough for the ring.
+                if (dir && run_names.count() >= PEONY_URING_MIN_BATCH) {
+                    enumerator.reset(new LocalFileEnumerator(dir, true));
+                    if (!enumerator->open(cancellable)) {
+                        enumerator.reset();
+                    } else if (run_names.count() >= PEONY_LOCAL_METADATA_PRELOAD_MIN) {
+                        enumerator->loadMetadata(cancellable);
+                    }
+                }
+                if (dir)
+                    g_object_unref(dir);
+            }
+
+            //children of a local directory are stated in a batch with io_uring.
+            if (enumerator) {
+                int handled = qMin(chunk_size, run_end - i);
+                auto local_infos = enumerator->queryFileInfos(run_names.mid(i - run_start, handled));
+                for (int j = 0; j < handled; j++) {
+                    auto g_info = local_infos.at(j);
+                    if (!g_info)
+                        g_info = query_file_info(uris.at(i + j), cancellable);
+                    if (g_info) {
+                        indexes<<i + j;
+                        g_infos<<wrapGFileInfo(g_info);
+                    }
+                }
+                i += handled;
+            } else {
+                //the others are queried a chunk at a time, in several threads.
+                int end = qMin(uris.count(), i + chunk_size);
+                auto queried_infos = query_file_infos(uris.mid(i, end - i), cancellable);
+                for (int j = 0; j < queried_infos.count(); j++) {
+                    if (queried_infos.at(j)) {
+                        indexes<<i + j;
+                        g_infos<<wrapGFileInfo(queried_infos.at(j));
+                    }
+                }
+                //look for the next run of local children after this chunk.
+                run_end = qMax(run_end, end);
+                i = end;
+            }
+
+            if (indexes.count() >= chunk_size) {
+                QTimer::singleShot(0, this, [=]() {
+                    applyChunk(indexes, g_infos);
+                });
+                indexes.clear();
+                g_infos.clear();
+            }
+        }
+
+        if (!indexes.isEmpty()) {
+            QTimer::singleShot(0, this, [=]() {
+                applyChunk(indexes, g_infos);
+            });
+        }
+
+        QTimer::singleShot(0, this, [=]() {
+            finish();
+        });
+    });
+}
+
+void FileInfoBatchJob::applyChunk(const QList<int> &indexes, const QList<GFileInfoWrapperPtr> &gInfos)
+{
+    if (isCancelled())
+        return;
+
+    QList<std::shared_ptr<FileInfo>> infos;
+    for (int i = 0; i < indexes.count(); i++) {
+        auto info = m_infos.at(indexes.at(i));
+        FileInfoJob::refreshInfoContents(info.get(), gInfos.at(i)->get());
+        infos<<info;
+    }
+
+    Q_EMIT chunkUpdated(infos);
+}
+
+void FileInfoBatchJob::finish()
+{
+    if (m_finished)
+        return;
+
+    m_finished = true;
+    Q_EMIT queryAsyncFinished(!isCancelled());
+
+    if (m_auto_delete)
+        deleteLater();
+}
@@ -0,0 +1,129 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#ifndef FILEINFOBATCHJOB_H
+#define FILEINFOBATCHJOB_H
+
+#include "peony-core_global.h"
+#include "gobject-template.h"
+
+#include <QObject>
+#include <QFuture>
+
+#include <memory>
+#include <gio/gio.h>
+
+#define PEONY_FILE_INFO_BATCH_CHUNK_SIZE 64
+/*!
+ * \brief PEONY_FILE_INFO_BATCH_QUERY_THREADS
+ * the count of threads querying a chunk of infos which are not local children
+ * stated with io_uring, such as the files of a network share.
+ */
+#define PEONY_FILE_INFO_BATCH_QUERY_THREADS 8
+
+namespace Peony {
+
+class FileInfo;
+
+/*!
+ * \brief The FileInfoBatchJob class
+ * <br>
+ * FileInfoBatchJob refreshes a list of FileInfo in one job. Unlike FileInfoJob,
+ * which starts an async query for every info, the batch job queries all the infos
+ * in one worker task, and applies the results in ui thread chunk by chunk.
+ * The children of a local directory are stated in a batch, the other infos of a
+ * chunk are queried in PEONY_FILE_INFO_BATCH_QUERY_THREADS threads, so that
+ * the round-trips of a remote file system overlap.
+ * Each applied chunk sends a chunkUpdated() signal, so that the model can handle
+ * a range of infos at once instead of handling every info separately.
+ * </br>
+ * \note The infos are always refreshed in ui thread, as FileInfoJob does.
+ * Cancelling the job cancels all the queries which have not finished yet,
+ * and the chunks not applied will be discarded.
+ * \see FileInfoJob::refreshInfoContents().
+ */
+class PEONYCORESHARED_EXPORT FileInfoBatchJob : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FileInfoBatchJob(const QList<std::shared_ptr<FileInfo>> &infos, QObject *parent = nullptr);
+    explicit FileInfoBatchJob(const QStringList &uris, QObject *parent = nullptr);
+    ~FileInfoBatchJob();
+
+    const QList<std::shared_ptr<FileInfo>> getInfos() {
+        return m_infos;
+    }
+
+    void setAutoDelete(bool deleteWhenJobFinished = true) {
+        m_auto_delete = deleteWhenJobFinished;
+    }
+
+    /*!
+     * \brief setChunkSize
+     * \param size, the count of infos applied in one chunk.
+     * default is PEONY_FILE_INFO_BATCH_CHUNK_SIZE.
+     */
+    void setChunkSize(int size) {
+        m_chunk_size = qMax(1, size);
+    }
+
+    bool isCancelled();
+
+Q_SIGNALS:
+    /*!
+     * \brief chunkUpdated
+     * \param infos, the infos refreshed in this chunk, in the order of job's list.
+     * \note the infos failed to query are not contained.
+     */
+    void chunkUpdated(const QList<std::shared_ptr<FileInfo>> &infos);
+
+    /*!
+     * \brief queryAsyncFinished
+     * \param successed
+     * \retval true if all chunks are applied.
+     * \retval false if the job is cancelled.
+     */
+    void queryAsyncFinished(bool successed);
+
+public Q_SLOTS:
+    void queryAsync();
+    void cancel();
+
+protected:
+    void applyChunk(const QList<int> &indexes, const QList<GFileInfoWrapperPtr> &gInfos);
+    void finish();
+
+private:
+    QList<std::shared_ptr<FileInfo>> m_infos;
+
+    int m_chunk_size = PEONY_FILE_INFO_BATCH_CHUNK_SIZE;
+    bool m_auto_delete = false;
+    bool m_finished = false;
+
+    GCancellable *m_cancellable = nullptr;
+    QFuture<void> m_future;
+};
+
+}
+
+#endif // FILEINFOBATCHJOB_H
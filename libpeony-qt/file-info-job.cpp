@@ -27,14 +27,13 @@
 
 #include "file-info-manager.h"
 #include "file-label-model.h"
-
-#include <gio/gdesktopappinfo.h>
+#include "content-type-cache.h"
+#include "desktop-file-cache.h"
 
 #include <QDebug>
 #include <QDateTime>
 #include <QIcon>
 #include <QUrl>
-#include <QLocale>
 
 using namespace Peony;
 
@@ -81,7 +80,7 @@ bool FileInfoJob::querySync()
     GError *err = nullptr;
 
     auto _info = g_file_query_info(info->m_file,
-                                   "standard::*," "time::*," "access::*," "mountable::*," "metadata::*," G_FILE_ATTRIBUTE_ID_FILE,
+                                   PEONY_FILE_INFO_QUERY_ATTRIBUTES,
                                    G_FILE_QUERY_INFO_NONE,
                                    nullptr,
                                    &err);
@@ -141,7 +140,7 @@ void FileInfoJob::queryAsync()
         return;
     }
     g_file_query_info_async(info->m_file,
-                            "standard::*," "time::*," "access::*," "mountable::*," "metadata::*," G_FILE_ATTRIBUTE_ID_FILE,
+                            PEONY_FILE_INFO_QUERY_ATTRIBUTES,
                             G_FILE_QUERY_INFO_NONE,
                             G_PRIORITY_DEFAULT,
                             m_cancellable,
@@ -154,176 +153,131 @@ void FileInfoJob::queryAsync()
 
 void FileInfoJob::refreshInfoContents(GFileInfo *new_info)
 {
-//    if (!m_info->m_mutex.tryLock(300))
-//        return;
-
-    FileInfo *info = nullptr;
     if (auto data = m_info) {
-        info = data.get();
-    } else {
-        return;
+        refreshInfoContents(data.get(), new_info);
     }
+}
+
+void FileInfoJob::preloadInfoContents(FileInfo *info, GFileInfo *new_info)
+{
+    if (!info || info->isLoaded())
+        return;
+
+    refreshDisplayContents(info, new_info);
+    info->setState(FileInfo::IsPreloaded, true);
+
+    Q_EMIT info->updated();
+}
+
+void FileInfoJob::refreshDisplayContents(FileInfo *info, GFileInfo *new_info)
+{
     GFileType type = g_file_info_get_file_type (new_info);
     switch (type) {
     case G_FILE_TYPE_DIRECTORY:
         //qDebug()<<"dir";
-        info->m_is_dir = true;
+        info->setState(FileInfo::IsDir, true);
         break;
     case G_FILE_TYPE_MOUNTABLE:
         //qDebug()<<"mountable";
-        info->m_is_volume = true;
+        info->setState(FileInfo::IsVolume, true);
         break;
     default:
         break;
     }
 
-    info->m_is_symbol_link = g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK);
+    info->setState(FileInfo::IsSymbolLink, g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK));
     if (g_file_info_has_attribute(new_info, G_FILE_ATTRIBUTE_ACCESS_CAN_READ)) {
-        info->m_can_read = g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_ACCESS_CAN_READ);
+        info->setState(FileInfo::CanRead, g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_ACCESS_CAN_READ));
     } else {
         // we assume an unknow access file is readable.
-        info->m_can_read = true;
+        info->setState(FileInfo::CanRead, true);
     }
-    info->m_can_write = g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE);
-    info->m_can_excute = g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_ACCESS_CAN_EXECUTE);
-    info->m_can_delete = g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_ACCESS_CAN_DELETE);
-    info->m_can_trash = g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_ACCESS_CAN_TRASH);
-    info->m_can_rename = g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_ACCESS_CAN_RENAME);
+    info->setState(FileInfo::CanWrite, g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE));
+    info->setState(FileInfo::CanExcute, g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_ACCESS_CAN_EXECUTE));
+    info->setState(FileInfo::CanDelete, g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_ACCESS_CAN_DELETE));
+    info->setState(FileInfo::CanTrash, g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_ACCESS_CAN_TRASH));
+    info->setState(FileInfo::CanRename, g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_ACCESS_CAN_RENAME));
 
-    info->m_can_mount = g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_MOUNT);
-    info->m_can_unmount = g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_UNMOUNT);
-    info->m_can_eject = g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_EJECT);
-    info->m_can_start = g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_START);
-    info->m_can_stop = g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_STOP);
+    info->setState(FileInfo::CanMount, g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_MOUNT));
+    info->setState(FileInfo::CanUnmount, g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_UNMOUNT));
+    info->setState(FileInfo::CanEject, g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_EJECT));
+    info->setState(FileInfo::CanStart, g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_START));
+    info->setState(FileInfo::CanStop, g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_MOUNTABLE_CAN_STOP));
 
-    info->m_is_virtual = g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_STANDARD_IS_VIRTUAL);
+    info->setState(FileInfo::IsVirtual, g_file_info_get_attribute_boolean(new_info, G_FILE_ATTRIBUTE_STANDARD_IS_VIRTUAL));
 
     info->m_display_name = QString (g_file_info_get_display_name(new_info));
+    QString content_type = g_file_info_get_content_type (new_info);
+    if (content_type == nullptr) {
+        if (g_file_info_has_attribute(new_info, "standard::fast-content-type")) {
+            content_type = g_file_info_get_attribute_string(new_info, "standard::fast-content-type");
+        }
+    }
+    info->m_content_type = FileInfo::internString(content_type);
+
+    //icon theme lookups are the same for all the files with same content type.
+    auto content_type_cache = ContentTypeCache::getInstance();
     GIcon *g_icon = g_file_info_get_icon (new_info);
     if (G_IS_ICON(g_icon)) {
-        const gchar* const* icon_names = g_themed_icon_get_names(G_THEMED_ICON (g_icon));
-        if (icon_names) {
-            auto p = icon_names;
-            while (*p) {
-                QIcon icon = QIcon::fromTheme(*p);
-                if (!icon.isNull()) {
-                    info->m_icon_name = QString (*p);
-                    break;
-                } else {
-                    p++;
-                }
-            }
-        }
+        auto icon_name = content_type_cache->resolveIconName(info->m_content_type, g_icon);
+        if (!icon_name.isEmpty())
+            info->m_icon_name = FileInfo::internString(icon_name);
         //g_object_unref(g_icon);
     }
 
     //qDebug()<<m_display_name<<m_icon_name;
     GIcon *g_symbolic_icon = g_file_info_get_symbolic_icon (new_info);
     if (G_IS_ICON(g_symbolic_icon)) {
-        const gchar* const* symbolic_icon_names = g_themed_icon_get_names(G_THEMED_ICON (g_symbolic_icon));
-        if (symbolic_icon_names)
-            info->m_symbolic_icon_name = QString (*symbolic_icon_names);
+        auto symbolic_icon_name = content_type_cache->resolveSymbolicIconName(info->m_content_type, g_symbolic_icon);
+        if (!symbolic_icon_name.isEmpty())
+            info->m_symbolic_icon_name = FileInfo::internString(symbolic_icon_name);
         //g_object_unref(g_symbolic_icon);
     }
 
-    char* name = g_file_get_path(info->m_file);
-    info->m_path = name;
-    if (NULL != name) {
-        g_free(name);
-    }
     info->m_file_id = g_file_info_get_attribute_string(new_info, G_FILE_ATTRIBUTE_ID_FILE);
 
-    info->m_content_type = g_file_info_get_content_type (new_info);
-    if (info->m_content_type == nullptr) {
-        if (g_file_info_has_attribute(new_info, "standard::fast-content-type")) {
-            info->m_content_type = g_file_info_get_attribute_string(new_info, "standard::fast-content-type");
-        }
-    }
-
     info->m_size = g_file_info_get_attribute_uint64(new_info, G_FILE_ATTRIBUTE_STANDARD_SIZE);
     info->m_modified_time = g_file_info_get_attribute_uint64(new_info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
     info->m_access_time = g_file_info_get_attribute_uint64(new_info, G_FILE_ATTRIBUTE_TIME_ACCESS);
 
-    info->m_mime_type_string = info->m_content_type;
-    if (!info->m_mime_type_string.isEmpty()) {
-        char *content_type = g_content_type_get_description (info->m_mime_type_string.toUtf8().constData());
-        info->m_file_type = content_type;
-        g_free (content_type);
-        content_type = nullptr;
-    }
+    //display strings will be formatted when they are needed.
+    info->clearDisplayStrings();
+}
+
+void FileInfoJob::refreshInfoContents(FileInfo *info, GFileInfo *new_info)
+{
+    if (!info)
+        return;
 
-    char *size_full = g_format_size_full(info->m_size, G_FORMAT_SIZE_DEFAULT);
-    info->m_file_size = size_full;
-    g_free(size_full);
+    refreshDisplayContents(info, new_info);
 
-    QDateTime date = QDateTime::fromMSecsSinceEpoch(info->m_modified_time*1000);
-    info->m_modified_date = date.toString(Qt::SystemLocaleShortDate);
+    info->m_meta_info = FileMetaInfo::fromGFileInfo(info->uri(), new_info);
 
-    date = QDateTime::fromMSecsSinceEpoch(info->m_access_time*1000);
-    info->m_access_date = date.toString(Qt::SystemLocaleShortDate);
+    // update peony qt color list and the label index after meta info updated.
+    FileLabelModel::getGlobalModel()->updateFileLabelIndex(info->uri(), info->m_meta_info->getLabelIds());
+    info->m_colors = FileLabelModel::getGlobalModel()->getFileColors(info->uri());
 
-    m_info->m_meta_info = FileMetaInfo::fromGFileInfo(m_info->uri(), new_info);
-    // update peony qt color list after meta info updated.
-    m_info->m_colors = FileLabelModel::getGlobalModel()->getFileColors(m_info->uri());
+    info->setState(FileInfo::IsLoaded, true);
 
     if (info->isDesktopFile()) {
+        //launcher metadata is parsed once and shared until the desktop file changed.
         QUrl url = info->uri();
-        GDesktopAppInfo *desktop_info = g_desktop_app_info_new_from_filename(url.path().toUtf8());
-        if (!desktop_info) {
-            m_info->m_mutex.unlock();
+        auto entry = DesktopFileCache::getInstance()->lookup(url.path());
+        if (!entry.isValid) {
             info->updated();
             return;
         }
-#if GLIB_CHECK_VERSION(2, 56, 0)
-        auto string = g_desktop_app_info_get_locale_string(desktop_info, "Name");
-#else
-        //FIXME: should handle locale?
-        //change "Name" to QLocale::system().name(),
-        //try to fix Qt5.6 untranslated desktop file issue
-        auto key = "Name[" +  QLocale::system().name() + "]";
-        auto string = g_desktop_app_info_get_string(desktop_info, key.toUtf8().constData());
-#endif
-        qDebug() << "get name string:"<<string <<info->uri()<<info->displayName();
-        if (string) {
-            info->m_display_name = string;
-            g_free(string);
-        } else {
-            QString path = "/usr/share/applications/" + info->displayName();
-            auto name = getAppName(path);
-            if (name.length() > 0)
-                info->m_display_name = name;
-            else
-            {
-                string = g_desktop_app_info_get_string(desktop_info, "Name");
-                if (string) {
-                    info->m_display_name = string;
-                    g_free(string);
-                }
-            }
-        }
-        g_object_unref(desktop_info);
+        if (!entry.name.isEmpty())
+            info->m_display_name = entry.name;
     }
 
     info->m_target_uri = g_file_info_get_attribute_string(new_info, G_FILE_ATTRIBUTE_STANDARD_TARGET_URI);
     info->m_symlink_target = g_file_info_get_symlink_target(new_info);
 
     Q_EMIT info->updated();
-//    m_info->m_mutex.unlock();
 }
 
 QString FileInfoJob::getAppName(QString desktopfp)
 {
-    GError** error=nullptr;
-    GKeyFileFlags flags=G_KEY_FILE_NONE;
-    GKeyFile* keyfile=g_key_file_new ();
-
-    QByteArray fpbyte=desktopfp.toLocal8Bit();
-    char* filepath=fpbyte.data();
-    g_key_file_load_from_file(keyfile,filepath,flags,error);
-
-    char* name=g_key_file_get_locale_string(keyfile,"Desktop Entry","Name", nullptr, nullptr);
-    QString namestr=QString::fromLocal8Bit(name);
-
-    g_key_file_free(keyfile);
-    return namestr;
+    return DesktopFileCache::getAppName(desktopfp);
 }
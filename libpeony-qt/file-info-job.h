@@ -30,6 +30,14 @@
 #include <memory>
 #include <gio/gio.h>
 
+/*!
+ * \brief PEONY_FILE_INFO_QUERY_ATTRIBUTES
+ * the attributes a FileInfo needs to be fully populated. FileInfoJob and
+ * FileEnumerator (with info mode) both query these attributes, so that the
+ * GFileInfo they get can be applied by FileInfoJob::refreshInfoContents().
+ */
+#define PEONY_FILE_INFO_QUERY_ATTRIBUTES "standard::*," "time::*," "access::*," "mountable::*," "metadata::*," G_FILE_ATTRIBUTE_ID_FILE
+
 namespace Peony {
 
 class FileInfo;
@@ -77,6 +85,32 @@ public:
         m_auto_delete = deleteWhenJobFinished;
     }
 
+    /*!
+     * \brief refreshInfoContents
+     * \param info, the shared info to be updated.
+     * \param new_info, a GFileInfo queried with PEONY_FILE_INFO_QUERY_ATTRIBUTES.
+     * <br>
+     * Fill the info with the queried attributes and emit FileInfo::updated().
+     * This is the same routine a FileInfoJob uses in its callback, it is exposed
+     * for the code that already holds a GFileInfo, such as FileEnumerator, so that
+     * it does not need to start another query job for each file.
+     * </br>
+     */
+    static void refreshInfoContents(FileInfo *info, GFileInfo *new_info);
+
+    /*!
+     * \brief preloadInfoContents
+     * \param info
+     * \param new_info, the display attributes of info, such as a record of
+     * a directory snapshot.
+     * \details
+     * Fill the display attributes of an info which has not been loaded. Unlike
+     * refreshInfoContents(), the metadata of info, such as emblems, labels and
+     * colors are kept, and the info is not marked as loaded, so that it will
+     * still be refreshed by an enumerator or an info job.
+     */
+    static void preloadInfoContents(FileInfo *info, GFileInfo *new_info);
+
 Q_SIGNALS:
     /*!
      * \brief queryAsyncFinished
@@ -123,6 +157,7 @@ protected:
 
 private:
     void refreshInfoContents(GFileInfo *new_info);
+    static void refreshDisplayContents(FileInfo *info, GFileInfo *new_info);
     std::shared_ptr<FileInfo> m_info;
 
     quint64 m_file_size_uint = 0;
@@ -22,52 +22,97 @@
 
 #include "file-info-manager.h"
 #include "thumbnail-manager.h"
-#include <QMap>
+#include <QHash>
 #include <QDebug>
 
+#define FILE_INFO_MANAGER_SHARD_COUNT 32
+
 using namespace Peony;
 
-static FileInfoManager* global_file_info_manager = nullptr;
-static QMap<QString, std::weak_ptr<FileInfo>> *global_info_list = nullptr;
+struct FileInfoShard
+{
+    QMutex mutex;
+    QHash<UriAtom, std::weak_ptr<FileInfo>> hash;
+};
+
+static FileInfoShard global_info_shards[FILE_INFO_MANAGER_SHARD_COUNT];
+
+static FileInfoShard &shardForUri(const UriAtom &uri)
+{
+    return global_info_shards[uri.hash() % FILE_INFO_MANAGER_SHARD_COUNT];
+}
 
 FileInfoManager::FileInfoManager()
 {
-    global_info_list = new QMap<QString, std::weak_ptr<FileInfo>>();
+
 }
 
 FileInfoManager::~FileInfoManager()
 {
-    delete global_info_list;
+
 }
 
 FileInfoManager *FileInfoManager::getInstance()
 {
-    if (!global_file_info_manager)
-        global_file_info_manager = new FileInfoManager;
-    return global_file_info_manager;
+    static FileInfoManager global_file_info_manager;
+    return &global_file_info_manager;
 }
 
 std::shared_ptr<FileInfo> FileInfoManager::findFileInfoByUri(const QString &uri)
 {
-    Q_ASSERT(global_info_list);
-    return global_info_list->value(uri).lock();//.lock();
+    //an alive info always holds its uri atom.
+    auto atom = UriAtom::find(uri);
+    if (atom.isNull())
+        return nullptr;
+
+    auto &shard = shardForUri(atom);
+    QMutexLocker locker(&shard.mutex);
+    auto it = shard.hash.constFind(atom);
+    if (it == shard.hash.constEnd())
+        return nullptr;
+    return it.value().lock();
 }
 
 std::shared_ptr<FileInfo> FileInfoManager::insertFileInfo(std::shared_ptr<FileInfo> info)
 {
-    Q_ASSERT(global_info_list);
-
-    if (global_info_list->value(info->uri()).lock()) {
-        //qDebug()<<"has info yet"<<info->uri();
-        info = global_info_list->value(info->uri()).lock();
+    auto uri = info->uriAtom();
+    auto &shard = shardForUri(uri);
+    QMutexLocker locker(&shard.mutex);
+    auto it = shard.hash.find(uri);
+    if (it != shard.hash.end()) {
+        if (auto existed = it.value().lock()) {
+            //qDebug()<<"has info yet"<<uri;
+            return existed;
+        }
+        it.value() = info;
     } else {
-        global_info_list->insert(info->uri(), info);
+        shard.hash.insert(uri, info);
     }
 
     return info;
 }
 
+void FileInfoManager::removeExpiredFileInfo(const UriAtom &uri)
+{
+    auto &shard = shardForUri(uri);
+    QMutexLocker locker(&shard.mutex);
+    auto it = shard.hash.find(uri);
+    //another info with same uri might be inserted after this one expired.
+    if (it != shard.hash.end() && it.value().expired())
+        shard.hash.erase(it);
+}
+
 void FileInfoManager::showState()
 {
-    qDebug()<<global_info_list->keys().count()<<global_info_list->values().count();
+    int count = 0;
+    int expiredCount = 0;
+    for (auto &shard : global_info_shards) {
+        QMutexLocker locker(&shard.mutex);
+        count += shard.hash.count();
+        for (auto info : shard.hash) {
+            if (info.expired())
+                expiredCount++;
+        }
+    }
+    qDebug()<<count<<expiredCount;
 }
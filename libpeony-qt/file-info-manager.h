@@ -39,43 +39,61 @@ namespace Peony {
  * use FileInfo::fromUri(), FileInfo::fromPath() or FileInfo::fromGFile()
  * for getting the corresponding shared data.
  * </br>
- * \note The memory management is based on std smart pointer, but it is not regular.
- * Because hash table always hold a use count of shared data. If you want to use
- * shared data of this class instance, you should remenmber this point:
- * When releasing your info resources, you aslo need to add an additional judgment that whether
- * there is no other member but you and manager instance hold this shared data.
- * If true, you should aslo remove the element in manager's hash for really releasing resources.
- * Otherwise, it might cause an one-time memory leak.
- * \see FileInfo, FileInfoJob, FileEnumerator; FileInfo::~FileInfo(), FileInfoJob::~FileInfoJob(),
- * FileEnumerator::~FileEnumerator().
- * \bug
- * Even though I try my best to make share the file info data, it seems that the info is not be shared
- * sometimes. Maybe there were some wrong in other classes?
+ * \note The hash table only holds weak references of the infos. It is split into
+ * several shards, each shard has its own lock, so that the threads querying different
+ * uris (ui thread, thumbnail workers and gio callbacks) rarely wait for each other.
+ * The hash table is keyed by UriAtom, the interned uri of info.
+ * An info created by FileInfo::fromUri() removes its expired entry from the hash
+ * when the last shared_ptr is released, so the table does not grow with every uri
+ * ever visited.
+ * \see FileInfo, FileInfoJob, FileEnumerator; FileInfo::fromUri().
  */
 class PEONYCORESHARED_EXPORT FileInfoManager
 {
     friend class FileInfo;
 public:
     static FileInfoManager *getInstance();
-    std::shared_ptr<FileInfo> findFileInfoByUri(const QString &uri); //{return global_info_list->value(uri);}
+    std::shared_ptr<FileInfo> findFileInfoByUri(const QString &uri);
 
-    void lock() {
-        m_mutex.tryLock();
-    }
-    void unlock() {
-        m_mutex.unlock();
-    }
+    /*!
+     * \brief lock
+     * \deprecated
+     * every shard of the hash table is locked internally,
+     * there is no need to lock the manager anymore.
+     */
+    void lock() {}
+    /*!
+     * \brief unlock
+     * \deprecated
+     * \see lock().
+     */
+    void unlock() {}
 
     void showState();
 
 protected:
-    std::shared_ptr<FileInfo> insertFileInfo(std::shared_ptr<FileInfo> info); //{global_info_list->insert(info->uri(), info);}
+    /*!
+     * \brief insertFileInfo
+     * \param info
+     * \return the info in hash table.
+     * \details
+     * if there is an alive info with same uri in hash, return the existed one,
+     * otherwise insert the info and return it. Both are done in one locking.
+     */
+    std::shared_ptr<FileInfo> insertFileInfo(std::shared_ptr<FileInfo> info);
+
+    /*!
+     * \brief removeExpiredFileInfo
+     * \param uri
+     * \details
+     * remove the entry of uri if its info has been released.
+     * this is called by the deleter of infos created by FileInfo::fromUri().
+     */
+    void removeExpiredFileInfo(const UriAtom &uri);
 
 private:
     FileInfoManager();
     ~FileInfoManager();
-
-    QMutex m_mutex;
 };
 
 }
@@ -27,21 +27,31 @@
 #include "file-meta-info.h"
 
 #include "thumbnail-manager.h"
+#include "content-type-cache.h"
+#include "file-label-model.h"
 
 #include <QUrl>
+#include <QDateTime>
+#include <QSet>
+#include <QMutex>
+#include <QCoreApplication>
+#include <QTimer>
 
 #include <QDebug>
 
 using namespace Peony;
 
-FileInfo::FileInfo(QObject *parent) : QObject (parent)
+static QMutex intern_mutex;
+static QSet<QString> intern_strings;
+
+FileInfo::FileInfo(QObject *parent) : QObject (parent),
+    m_state(CanRead)
 {
-    m_cancellable = g_cancellable_new();
+
 }
 
-FileInfo::FileInfo(const QString &uri, QObject *parent) : QObject (parent)
+FileInfo::FileInfo(const QString &uri, QObject *parent) : FileInfo (parent)
 {
-    m_cancellable = g_cancellable_new();
     /*!
      * \note
      * In qt program we alwas handle file's uri format as unicode,
@@ -50,74 +60,53 @@ FileInfo::FileInfo(const QString &uri, QObject *parent) : QObject (parent)
      * this would help me avoid some problem, such as the uri path completion
      * bug in PathBarModel enumeration.
      */
-    m_uri = uri;
-    m_file = g_file_new_for_uri(uri.toUtf8().data());
-    m_parent = g_file_get_parent(m_file);
-    m_is_remote = !g_file_is_native(m_file);
-    GFileType type = g_file_query_file_type(m_file, G_FILE_QUERY_INFO_NONE, nullptr);
-    switch (type) {
-    case G_FILE_TYPE_DIRECTORY:
-        //qDebug()<<"dir";
-        m_is_dir = true;
-        break;
-    case G_FILE_TYPE_MOUNTABLE:
-        //qDebug()<<"mountable";
-        m_is_volume = true;
-        break;
-    default:
-        break;
-    }
+    m_uri = UriAtom::fromUri(uri);
+    m_file = g_file_new_for_uri(m_uri.utf8().constData());
+    setState(IsRemote, !g_file_is_native(m_file));
 }
 
 FileInfo::~FileInfo()
 {
-    ThumbnailManager::getInstance()->releaseThumbnail(m_uri);
-    //qDebug()<<"~FileInfo"<<m_uri;
+    ThumbnailManager::getInstance()->releaseThumbnail(m_uri.uri());
+    //qDebug()<<"~FileInfo"<<m_uri.uri();
     disconnect();
 
-    g_object_unref(m_cancellable);
     g_object_unref(m_file);
 
-    if (m_parent)
-        g_object_unref(m_parent);
-
-    m_uri = nullptr;
+    m_uri = UriAtom();
 }
 
 std::shared_ptr<FileInfo> FileInfo::fromUri(QString uri, bool addToHash)
 {
     addToHash = true;
     FileInfoManager *info_manager = FileInfoManager::getInstance();
-    info_manager->lock();
     std::shared_ptr<FileInfo> info = info_manager->findFileInfoByUri(uri);
     if (info != nullptr) {
-        info_manager->unlock();
         return info;
     } else {
-        std::shared_ptr<FileInfo> newly_info = std::make_shared<FileInfo>();
-
-        newly_info->m_uri = uri;
-        newly_info->m_file = g_file_new_for_uri(uri.toUtf8().data());
-
-        newly_info->m_parent = g_file_get_parent(newly_info->m_file);
-        newly_info->m_is_remote = !g_file_is_native(newly_info->m_file);
-        GFileType type = g_file_query_file_type(newly_info->m_file, G_FILE_QUERY_INFO_NONE, nullptr);
-        switch (type) {
-        case G_FILE_TYPE_DIRECTORY:
-            //qDebug()<<"dir";
-            newly_info->m_is_dir = true;
-            break;
-        case G_FILE_TYPE_MOUNTABLE:
-            //qDebug()<<"mountable";
-            newly_info->m_is_volume = true;
-            break;
-        default:
-            break;
-        }
+        //the deleter removes the expired entry from manager when the info released.
+        std::shared_ptr<FileInfo> newly_info(new FileInfo, [](FileInfo *info) {
+            auto atom = info->m_uri;
+            delete info;
+            auto manager = FileInfoManager::getInstance();
+            manager->removeExpiredFileInfo(atom);
+            //the labels of a file are indexed while its info is alive.
+            auto uri = atom.uri();
+            if (!manager->findFileInfoByUri(uri))
+                FileLabelModel::removeFileLabelIndex(uri);
+        });
+
+        newly_info->m_uri = UriAtom::fromUri(uri);
+        newly_info->m_file = g_file_new_for_uri(newly_info->m_uri.utf8().constData());
+
+        newly_info->setState(IsRemote, !g_file_is_native(newly_info->m_file));
+        //NOTE: do not query anything here, a newly created info only holds its uri.
+        //the file type is filled by enumerator or info job, or resolved lazily.
+        //see resolveFileType().
         if (addToHash) {
+            //if another thread has inserted an info with same uri, use that one.
             newly_info = info_manager->insertFileInfo(newly_info);
         }
-        info_manager->unlock();
         return newly_info;
     }
 }
@@ -136,6 +125,165 @@ std::shared_ptr<FileInfo> FileInfo::fromGFile(GFile *file, bool addToHash)
     return fromUri(uri, addToHash);
 }
 
+QString FileInfo::fileType()
+{
+    QMutexLocker l(&m_mutex);
+    if (m_file_type.isNull() && !m_content_type.isEmpty()) {
+        m_file_type = ContentTypeCache::getInstance()->description(m_content_type);
+    }
+    return m_file_type;
+}
+
+QString FileInfo::filePath()
+{
+    char *path = g_file_get_path(m_file);
+    QString file_path = path;
+    g_free(path);
+    return file_path;
+}
+
+QString FileInfo::fileSize()
+{
+    QMutexLocker l(&m_mutex);
+    if (m_file_size.isNull() && (testState(IsLoaded) || testState(IsPreloaded))) {
+        char *size_full = g_format_size_full(m_size, G_FORMAT_SIZE_DEFAULT);
+        m_file_size = size_full;
+        g_free(size_full);
+    }
+    return m_file_size;
+}
+
+QString FileInfo::modifiedDate()
+{
+    QMutexLocker l(&m_mutex);
+    if (m_modified_date.isNull() && (testState(IsLoaded) || testState(IsPreloaded))) {
+        QDateTime date = QDateTime::fromMSecsSinceEpoch(m_modified_time*1000);
+        m_modified_date = date.toString(Qt::SystemLocaleShortDate);
+    }
+    return m_modified_date;
+}
+
+QString FileInfo::accessDate()
+{
+    QMutexLocker l(&m_mutex);
+    if (m_access_date.isNull() && (testState(IsLoaded) || testState(IsPreloaded))) {
+        QDateTime date = QDateTime::fromMSecsSinceEpoch(m_access_time*1000);
+        m_access_date = date.toString(Qt::SystemLocaleShortDate);
+    }
+    return m_access_date;
+}
+
+const QString FileInfo::internString(const QString &string)
+{
+    if (string.isEmpty())
+        return string;
+
+    QMutexLocker l(&intern_mutex);
+    auto it = intern_strings.constFind(string);
+    if (it != intern_strings.constEnd())
+        return *it;
+    intern_strings.insert(string);
+    return string;
+}
+
+void FileInfo::clearDisplayStrings()
+{
+    QMutexLocker l(&m_mutex);
+    m_file_type = nullptr;
+    m_file_size = nullptr;
+    m_modified_date = nullptr;
+    m_access_date = nullptr;
+}
+
+bool FileInfo::isDir()
+{
+    resolveFileType();
+    return testState(IsDir) || m_content_type == "inode/directory";
+}
+
+bool FileInfo::isVolume()
+{
+    resolveFileType();
+    return testState(IsVolume);
+}
+
+void FileInfo::resolveFileType()
+{
+    if (testState(IsLoaded) || testState(IsPreloaded) || testState(IsTypeResolved))
+        return;
+
+    //only the first caller starts the query, even if it is called in several threads.
+    if (m_state.fetchAndOrOrdered(IsTypeResolved) & IsTypeResolved)
+        return;
+
+    //the info might be used in a worker thread without event loop, start the
+    //query in ui thread. the info is looked up again there, as it might have
+    //been released.
+    QString uri = m_uri.uri();
+    QTimer::singleShot(0, QCoreApplication::instance(), [uri]() {
+        auto info = FileInfoManager::getInstance()->findFileInfoByUri(uri);
+        if (!info || info->isLoaded())
+            return;
+        g_file_query_info_async(info->m_file,
+                                G_FILE_ATTRIBUTE_STANDARD_TYPE,
+                                G_FILE_QUERY_INFO_NONE,
+                                G_PRIORITY_DEFAULT,
+                                nullptr,
+                                GAsyncReadyCallback(FileInfo::queryFileTypeCallback),
+                                new std::weak_ptr<FileInfo>(info));
+    });
+}
+
+void FileInfo::resolveTypeSync()
+{
+    if (testState(IsLoaded) || testState(IsPreloaded))
+        return;
+
+    GFileInfo *g_info = g_file_query_info(m_file,
+                                          G_FILE_ATTRIBUTE_STANDARD_TYPE,
+                                          G_FILE_QUERY_INFO_NONE,
+                                          nullptr,
+                                          nullptr);
+    if (!g_info)
+        return;
+    GFileType type = g_file_info_get_file_type(g_info);
+    g_object_unref(g_info);
+
+    //an async query started later is not needed.
+    setState(IsTypeResolved, true);
+    setState(IsDir, type == G_FILE_TYPE_DIRECTORY);
+    setState(IsVolume, type == G_FILE_TYPE_MOUNTABLE);
+}
+
+void FileInfo::queryFileTypeCallback(GFile *file, GAsyncResult *res, gpointer data)
+{
+    auto weakInfo = static_cast<std::weak_ptr<FileInfo> *>(data);
+    auto info = weakInfo->lock();
+    delete weakInfo;
+
+    GFileInfo *g_info = g_file_query_info_finish(file, res, nullptr);
+    if (!g_info)
+        return;
+    GFileType type = g_file_info_get_file_type(g_info);
+    g_object_unref(g_info);
+
+    //an enumerator or an info job has filled the info meanwhile.
+    if (!info || info->isLoaded())
+        return;
+
+    switch (type) {
+    case G_FILE_TYPE_DIRECTORY:
+        info->setState(IsDir, true);
+        break;
+    case G_FILE_TYPE_MOUNTABLE:
+        info->setState(IsVolume, true);
+        break;
+    default:
+        return;
+    }
+    Q_EMIT info->updated();
+}
+
 /*******
 函数功能：判断文件是否是视频文件
 一般的视频文件都是 video/*,但是有些视频文件比较特殊
@@ -149,14 +297,14 @@ h264:   application/octet-stream
 **/
 bool FileInfo::isVideoFile()
 {
-    if (nullptr != m_mime_type_string)
+    if (nullptr != m_content_type)
     {
-        if (m_mime_type_string.startsWith("video")
-            || m_mime_type_string.endsWith("vnd.trolltech.linguist")
-            || m_mime_type_string.endsWith("vnd.adobe.flash.movie")
-            || m_mime_type_string.endsWith("vnd.rn-realmedia")
-            || m_mime_type_string.endsWith("vnd.ms-asf")
-            || m_mime_type_string.endsWith("octet-stream"))
+        if (m_content_type.startsWith("video")
+            || m_content_type.endsWith("vnd.trolltech.linguist")
+            || m_content_type.endsWith("vnd.adobe.flash.movie")
+            || m_content_type.endsWith("vnd.rn-realmedia")
+            || m_content_type.endsWith("vnd.ms-asf")
+            || m_content_type.endsWith("octet-stream"))
         {
             return true;
         }
@@ -180,7 +328,7 @@ bool FileInfo::isOfficeFile()
     for (idx = 0; office_mime_types[idx] != "end"; idx++)
     {
         mtype = office_mime_types[idx];
-        if (m_mime_type_string.contains(mtype))
+        if (m_content_type.contains(mtype))
         {
             return true;
         }
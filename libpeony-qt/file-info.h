@@ -25,6 +25,7 @@
 #define FILEINFO_H
 
 #include "peony-core_global.h"
+#include "uri-atom.h"
 
 #include <memory>
 #include <gio/gio.h>
@@ -32,6 +33,7 @@
 #include <QObject>
 
 #include <QMutex>
+#include <QAtomicInt>
 
 #include <QIcon>
 #include <QColor>
@@ -145,23 +147,53 @@ public:
     static std::shared_ptr<FileInfo> fromGFile(GFile *file, bool addToHash = true);
 
     QString uri() {
-        return m_uri;
-    }
-    bool isDir() {
-        return m_is_dir || m_content_type == "inode/directory";
+        return m_uri.uri();
     }
-    bool isVolume() {
-        return m_is_volume;
+    /*!
+     * \brief uriAtom
+     * \return the interned uri of this info.
+     * \see UriAtom.
+     */
+    const UriAtom uriAtom() {
+        return m_uri;
     }
+    /*!
+     * \brief isDir
+     * \return
+     * \note
+     * if the info has not been loaded by an enumerator or an info job yet,
+     * it returns false until the file type is resolved asynchronously.
+     * Call resolveTypeSync() first if the info might be newly created and
+     * the answer is needed at once, such as handling a drop or a key press.
+     * \see resolveFileType().
+     */
+    bool isDir();
+    bool isVolume();
+
+    /*!
+     * \brief resolveTypeSync
+     * query the file type synchronously if the info is not loaded yet,
+     * so that isDir() and isVolume() are correct for a newly created info.
+     * \note this blocks on i/o, do not call it for every item of a model.
+     */
+    void resolveTypeSync();
     bool isSymbolLink() {
-        return m_is_symbol_link;
+        return testState(IsSymbolLink);
     }
     bool isVirtual() {
-        return m_is_virtual;
+        return testState(IsVirtual);
     }
     bool isValid()
     {
-        return m_is_valid;
+        return testState(IsValid);
+    }
+    /*!
+     * \brief isLoaded
+     * \return true if the info has been filled by an enumerator, an info job
+     * or a directory snapshot.
+     */
+    bool isLoaded() {
+        return testState(IsLoaded);
     }
 
     QString displayName() {
@@ -177,25 +209,23 @@ public:
         return m_file_id;
     }
     QString mimeType() {
-        return m_mime_type_string;
-    }
-    QString fileType() {
-        return m_file_type;
+        return m_content_type;
     }
 
-    QString filePath() {
-        return m_path;
-    }
+    /*!
+     * \brief fileType
+     * \return the description of content type.
+     * \note display strings, such as fileType(), fileSize(), modifiedDate()
+     * and accessDate(), are formatted at the first time they are called
+     * after info updated, rather than every time the info is refreshed.
+     */
+    QString fileType();
 
-    QString fileSize() {
-        return m_file_size;
-    }
-    QString modifiedDate() {
-        return m_modified_date;
-    }
-    QString accessDate() {
-        return m_access_date;
-    }
+    QString filePath();
+
+    QString fileSize();
+    QString modifiedDate();
+    QString accessDate();
 
     QString type() {
         return m_content_type;
@@ -215,51 +245,51 @@ public:
     }
 
     bool canRead() {
-        return m_can_read;
+        return testState(CanRead);
     }
     bool canWrite() {
-        return m_can_write;
+        return testState(CanWrite);
     }
     bool canExecute() {
-        return m_can_excute;
+        return testState(CanExcute);
     }
     bool canDelete() {
-        return m_can_delete;
+        return testState(CanDelete);
     }
     bool canTrash() {
-        return m_can_trash;
+        return testState(CanTrash);
     }
     bool canRename() {
-        return m_can_rename;
+        return testState(CanRename);
     }
 
     bool canMount() {
-        return m_can_mount;
+        return testState(CanMount);
     }
     bool canUnmount() {
-        return m_can_unmount;
+        return testState(CanUnmount);
     }
     bool canEject() {
-        return m_can_eject;
+        return testState(CanEject);
     }
     bool canStart() {
-        return m_can_start;
+        return testState(CanStart);
     }
     bool canStop() {
-        return m_can_stop;
+        return testState(CanStop);
     }
 
     bool isDesktopFile() {
-        return m_can_excute && m_uri.endsWith(".desktop");
+        return testState(CanExcute) && m_uri.uri().endsWith(".desktop");
     }
 
     bool isPdfFile(){
-        return m_mime_type_string.contains("pdf");
+        return m_content_type.contains("pdf");
 
     }
 
     bool isImageFile(){
-        return m_mime_type_string.startsWith("image/");
+        return m_content_type.startsWith("image/");
     }
 
     bool isVideoFile();
@@ -272,26 +302,26 @@ public:
     AccessFlags accesses() {
         auto flags = AccessFlags();
 #if (QT_VERSION >= QT_VERSION_CHECK(5, 7, 0))
-        flags.setFlag(Readable, m_can_read);
-        flags.setFlag(Writeable, m_can_write);
-        flags.setFlag(Executable, m_can_excute);
-        flags.setFlag(Deleteable, m_can_delete);
-        flags.setFlag(Trashable, m_can_trash);
-        flags.setFlag(Renameable, m_can_rename);
+        flags.setFlag(Readable, testState(CanRead));
+        flags.setFlag(Writeable, testState(CanWrite));
+        flags.setFlag(Executable, testState(CanExcute));
+        flags.setFlag(Deleteable, testState(CanDelete));
+        flags.setFlag(Trashable, testState(CanTrash));
+        flags.setFlag(Renameable, testState(CanRename));
         return flags;
 #else
         flags = 0;
-        if (m_can_read)
+        if (testState(CanRead))
             flags |= Readable;
-        if (m_can_write)
+        if (testState(CanWrite))
             flags |= Writeable;
-        if (m_can_excute)
+        if (testState(CanExcute))
             flags |= Executable;
-        if (m_can_delete)
+        if (testState(CanDelete))
             flags |= Deleteable;
-        if (m_can_trash)
+        if (testState(CanTrash))
             flags |= Trashable;
-        if (m_can_rename)
+        if (testState(CanRename))
             flags |= Renameable;
 #endif
     }
@@ -309,72 +339,127 @@ public:
 Q_SIGNALS:
     void updated();
 
+protected:
+    /*!
+     * \brief resolveFileType
+     * \details
+     * FileInfo::fromUri() does not do any i/o, so a newly created info
+     * does not know whether it is a directory or a volume. Most infos
+     * are loaded by FileEnumerator or FileInfoJob before their type is
+     * needed, for the others, an async query of the type is started once
+     * when isDir() or isVolume() is called. The type is unknown until the
+     * query finished, and updated() is sent if it is a directory or a volume.
+     */
+    void resolveFileType();
+    static void queryFileTypeCallback(GFile *file, GAsyncResult *res, gpointer data);
+
+protected:
+    /*!
+     * \brief internString
+     * \param string
+     * \return the shared copy of string.
+     * \details
+     * content types and icon names are the same for a lot of files,
+     * intern them so that all infos share one copy of each string.
+     */
+    static const QString internString(const QString &string);
+
+    /*!
+     * \brief clearDisplayStrings
+     * clear the formatted display strings, they will be formatted
+     * again when they are needed.
+     */
+    void clearDisplayStrings();
+
 private:
-    QString m_uri = nullptr;
-    bool m_is_valid = false;
-    bool m_is_dir = false;
-    bool m_is_volume = false;
-    bool m_is_remote = false;
-    bool m_is_symbol_link = false;
-    bool m_is_virtual = false;
+    enum StateFlag {
+        IsValid = 1 << 0,
+        IsDir = 1 << 1,
+        IsVolume = 1 << 2,
+        IsRemote = 1 << 3,
+        IsSymbolLink = 1 << 4,
+        IsVirtual = 1 << 5,
+        IsLoaded = 1 << 6,
+        IsTypeResolved = 1 << 7,
+        CanRead = 1 << 8,
+        CanWrite = 1 << 9,
+        CanExcute = 1 << 10,
+        CanDelete = 1 << 11,
+        CanTrash = 1 << 12,
+        CanRename = 1 << 13,
+        CanMount = 1 << 14,
+        CanUnmount = 1 << 15,
+        CanEject = 1 << 16,
+        CanStart = 1 << 17,
+        CanStop = 1 << 18,
+        //filled with the display attributes of a directory snapshot, but not loaded.
+        IsPreloaded = 1 << 19
+    };
+
+    bool testState(StateFlag flag) {
+        return m_state.loadAcquire() & flag;
+    }
+    void setState(StateFlag flag, bool on) {
+        if (on) {
+            m_state.fetchAndOrRelease(flag);
+        } else {
+            m_state.fetchAndAndRelease(~int(flag));
+        }
+    }
+
+    UriAtom m_uri;
 
-    bool m_is_loaded = false;
+    /*!
+     * \brief m_state
+     * the boolean states of this info, they are read in worker threads
+     * while the info is refreshed in ui thread, so they are kept in an
+     * atomic word instead of bitfields.
+     * \see StateFlag.
+     */
+    QAtomicInt m_state;
 
     QString m_display_name = nullptr;
+    /*!
+     * \brief m_icon_name
+     * \see internString().
+     */
     QString m_icon_name = nullptr;
     QString m_symbolic_icon_name = nullptr;
     QString m_file_id = nullptr;
-    QString m_path = nullptr;
+    /*!
+     * \brief m_content_type
+     * \see internString().
+     */
     QString m_content_type = nullptr;
     guint64 m_size = 0;
     guint64 m_modified_time = 0;
     guint64 m_access_time = 0;
 
     /*!
-     * \deprecated
-     * \brief m_mime_type_string
-     * \see m_content_type
+     * \brief m_file_type
+     * lazily formatted display strings.
+     * \see clearDisplayStrings().
      */
-    QString m_mime_type_string = nullptr;
     QString m_file_type = nullptr;
     QString m_file_size = nullptr;
     QString m_modified_date = nullptr;
     QString m_access_date = nullptr;
+    /*!
+     * \brief m_mutex
+     * guards the lazily formatted display strings, which might be formatted
+     * in a worker thread while ui thread is reading or clearing them.
+     */
+    QMutex m_mutex;
 
-    //access
-    bool m_can_read = true;
-    bool m_can_write = false;
-    bool m_can_excute = false;
-    bool m_can_delete = false;
-    bool m_can_trash = false;
-    bool m_can_rename = false;
-
-    bool m_can_mount = false;
-    bool m_can_unmount = false;
-    bool m_can_eject = false;
-
-    bool m_can_start = false;
-    bool m_can_stop = false;
-
-    //FIXME: should i use smart pointer wrap these data?
     GFile *m_file = nullptr;
-    GFile *m_parent = nullptr;
 
     QString m_target_uri;
     QString m_symlink_target;
 
-    /*!
-     * \brief m_cancellable
-     * This cancellable is used in async query file info in FileInfoJob instance.
-     */
-    GCancellable *m_cancellable = nullptr;
-
     //QIcon m_thumbnail;
     std::shared_ptr<FileMetaInfo> m_meta_info = nullptr;
 
     QList<QColor> m_colors;
-
-    QMutex m_mutex;
 };
 
 }
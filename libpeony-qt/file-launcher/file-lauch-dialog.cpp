@@ -87,6 +87,7 @@ FileLauchDialog::FileLauchDialog(const QString &uri, QWidget *parent) : QDialog(
     connect(m_button_box, &QDialogButtonBox::rejected, this, &QDialog::reject);
 
     auto info = FileInfo::fromUri(uri);
+    info->resolveTypeSync();
     if (info->isDir() || info->isDesktopFile()) {
         m_check_box->setEnabled(false);
     }
@@ -22,6 +22,8 @@
 
 #include "file-meta-info.h"
 #include "file-info-manager.h"
+#include "metadata-write-queue.h"
+#include "file-label-model.h"
 
 #include <QDebug>
 
@@ -59,6 +61,18 @@ FileMetaInfo::FileMetaInfo(const QString &uri, GFileInfo *g_info)
             g_strfreev(metainfo_attributes);
         }
     }
+
+    //the values in gvfs might be out of date if there are writes not flushed yet.
+    auto pending = MetadataWriteQueue::getInstance()->pendingAttributes(uri);
+    for (auto it = pending.constBegin(); it != pending.constEnd(); it++) {
+        if (it.value().isValid()) {
+            m_meta_hash.insert(it.key(), it.value());
+        } else {
+            m_meta_hash.remove(it.key());
+        }
+    }
+
+    updateLabelIds();
 }
 
 void FileMetaInfo::setMetaInfoInt(const QString &key, int value)
@@ -89,33 +103,13 @@ void FileMetaInfo::setMetaInfoVariant(const QString &key, const QVariant &value,
 
     m_meta_hash.remove(realKey);
     m_meta_hash.insert(realKey, value);
-    GFile *file = g_file_new_for_uri(m_uri.toUtf8().constData());
-//    GFileInfo *info = g_file_info_new();
-    std::string tmp = realKey.toStdString();
-    auto data = value.toString().toUtf8().data();
-//    g_file_info_set_attribute(info, tmp.c_str(), G_FILE_ATTRIBUTE_TYPE_STRING, (gpointer)data);
-    //FIXME: should i add callback?
-//    g_file_set_attributes_async(file,
-//                                info,
-//                                G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
-//                                0,
-//                                nullptr,
-//                                nullptr,
-//                                nullptr);
-    //qDebug()<<tmp.c_str()<<value;
-    if (syncToFile) {
-        GError *err = nullptr;
-        g_file_set_attribute(file, tmp.c_str(), G_FILE_ATTRIBUTE_TYPE_STRING, (gpointer)data,
-                             G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, nullptr, &err);
+    if (realKey == "metadata::" PEONY_FILE_LABEL_IDS)
+        updateLabelIds();
 
-        if (err) {
-            qDebug()<<err->message;
-            g_error_free(err);
-        }
+    //the write is queued and flushed in a worker thread later.
+    if (syncToFile) {
+        MetadataWriteQueue::getInstance()->setAttribute(m_uri, realKey, value.toString());
     }
-
-//    g_object_unref(info);
-    g_object_unref(file);
 //    m_mutex.unlock();
 }
 
@@ -155,27 +149,29 @@ void FileMetaInfo::removeMetaInfo(const QString &key)
     if (!key.startsWith("metadata::"))
         realKey = "metadata::" + key;
     m_meta_hash.remove(realKey);
-    GFile *file = g_file_new_for_uri(m_uri.toUtf8().constData());
-    g_file_set_attribute(file,
-                         realKey.toUtf8().constData(),
-                         G_FILE_ATTRIBUTE_TYPE_INVALID,
-                         nullptr,
-                         G_FILE_QUERY_INFO_NONE,
-                         nullptr,
-                         nullptr);
-//    GFileInfo *info = g_file_info_new();
-//    std::string tmp = realKey.toStdString();
-//    //g_file_info_set_attribute(info, realKey.toUtf8(), G_FILE_ATTRIBUTE_TYPE_INVALID, nullptr);
-//    g_file_info_remove_attribute(info, realKey.toUtf8());
-//    //FIXME: should i add callback?
-//    g_file_set_attributes_async(file,
-//                                info,
-//                                G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
-//                                0,
-//                                nullptr,
-//                                nullptr,
-//                                nullptr);
-//    g_object_unref(info);
-    g_object_unref(file);
+    if (realKey == "metadata::" PEONY_FILE_LABEL_IDS)
+        updateLabelIds();
+    MetadataWriteQueue::getInstance()->removeAttribute(m_uri, realKey);
 //    m_mutex.unlock();
 }
+
+const QVector<int> FileMetaInfo::getLabelIds()
+{
+    return m_label_ids;
+}
+
+void FileMetaInfo::updateLabelIds()
+{
+    m_label_ids.clear();
+    auto var = m_meta_hash.value("metadata::" PEONY_FILE_LABEL_IDS);
+    if (!var.isValid())
+        return;
+
+    auto labels = var.toString().split('\n', QString::SkipEmptyParts);
+    for (auto label : labels) {
+        bool ok = false;
+        int id = label.toInt(&ok);
+        if (ok && !m_label_ids.contains(id))
+            m_label_ids<<id;
+    }
+}
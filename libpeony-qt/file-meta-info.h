@@ -27,6 +27,7 @@
 #include <QStringList>
 #include <QHash>
 #include <QVariant>
+#include <QVector>
 #include <QMutex>
 
 #include <memory>
@@ -70,9 +71,23 @@ public:
 
     void removeMetaInfo(const QString &key);
 
+    /*!
+     * \brief getLabelIds
+     * \return the file label ids of this file.
+     * \details
+     * Label ids are stored in gvfs as a newline-joined string. They are parsed
+     * once when the meta info is loaded or the label key changed, so that label
+     * lookups do not need to split the string again.
+     */
+    const QVector<int> getLabelIds();
+
+protected:
+    void updateLabelIds();
+
 private:
     QString m_uri;
     QHash<QString, QVariant> m_meta_hash;
+    QVector<int> m_label_ids;
     QMutex m_mutex;
 };
 
@@ -23,6 +23,7 @@
 #include "file-rename-operation.h"
 #include "file-operation-manager.h"
 #include "file-utils.h"
+#include "file-label-model.h"
 #include <gio/gdesktopappinfo.h>
 #include <glib/gprintf.h>
 #include <QUrl>
@@ -284,6 +285,12 @@ retry:
         if (nullptr != newName) {
             g_free(newName);
         }
+        if (!err) {
+            //the labels are kept in metadata, which is moved with the file.
+            char *newUri = g_file_get_uri(newFile.get()->get());
+            FileLabelModel::renameFileLabelIndex(m_uri, newUri);
+            g_free(newUri);
+        }
 /*
         g_file_move(file.get()->get(),
                     newFile.get()->get(),
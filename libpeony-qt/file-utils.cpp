@@ -22,6 +22,7 @@
 
 #include "file-utils.h"
 #include "file-info.h"
+#include "target-uri-resolver.h"
 #include <QUrl>
 #include <QFileInfo>
 #include <QFileInfoList>
@@ -114,6 +115,7 @@ bool FileUtils::getFileIsFolder(const QString &uri)
 {
     auto info = FileInfo::fromUri(uri);
     if (!info.get()->isEmptyInfo()) {
+        info.get()->resolveTypeSync();
         return info.get()->isDir();
     }
 
@@ -290,19 +292,18 @@ GErrorWrapperPtr FileUtils::getEnumerateError(const QString &uri)
 
 QString FileUtils::getTargetUri(const QString &uri)
 {
+    auto resolver = TargetUriResolver::getInstance();
+    QString targetUri;
+    if (resolver->lookup(uri, targetUri)) {
+        return targetUri;
+    }
+
     auto fileInfo = FileInfo::fromUri(uri);
     if (!fileInfo.get()->isEmptyInfo()) {
         return fileInfo.get()->targetUri();
     }
 
-    auto file = wrapGFile(g_file_new_for_uri(uri.toUtf8().constData()));
-    auto info = wrapGFileInfo(g_file_query_info(file.get()->get(),
-                              G_FILE_ATTRIBUTE_STANDARD_TARGET_URI,
-                              G_FILE_QUERY_INFO_NONE,
-                              nullptr,
-                              nullptr));
-    return g_file_info_get_attribute_string(info.get()->get(),
-                                            G_FILE_ATTRIBUTE_STANDARD_TARGET_URI);
+    return resolver->resolveSync(uri);
 }
 
 
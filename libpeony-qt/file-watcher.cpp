@@ -24,15 +24,28 @@
 #include "gerror-wrapper.h"
 
 #include "file-label-model.h"
+#include "desktop-file-cache.h"
 
 #include <QUrl>
 #include "file-utils.h"
 #include "file-operation-manager.h"
+#include "target-uri-resolver.h"
 
 #include <QDebug>
 
 using namespace Peony;
 
+static void invalidate_desktop_file_cache(GFile *file)
+{
+    //drop the cached launcher metadata of a changed desktop file.
+    char *path = g_file_get_path(file);
+    if (path) {
+        if (g_str_has_suffix(path, ".desktop"))
+            DesktopFileCache::getInstance()->invalidate(path);
+        g_free(path);
+    }
+}
+
 FileWatcher::FileWatcher(QString uri, QObject *parent) : QObject(parent)
 {
     if (uri.startsWith("thumbnail://"))
@@ -108,28 +121,77 @@ FileWatcher::~FileWatcher()
  * a file watcher instance, I recommend you call a file enumerator class instance
  * with FileEnumerator::prepare() and wait it finished first.
  * </br>
- * \see FileEnumerator::prepare().
+ * <br>
+ * The target uri is resolved by TargetUriResolver. If it is cached, the monitors
+ * are created for the target directly, otherwise the monitors are created for the
+ * uri first, and moved to the target once it resolved.
+ * </br>
+ * \see FileEnumerator::prepare(), TargetUriResolver.
  */
 void FileWatcher::prepare()
 {
-    //FIXME: replace BLOCKING api in ui thread.
-    GFileInfo *info = g_file_query_info(m_file,
-                                        G_FILE_ATTRIBUTE_STANDARD_TARGET_URI,
-                                        G_FILE_QUERY_INFO_NONE,
-                                        m_cancellable,
-                                        nullptr);
+    auto resolver = TargetUriResolver::getInstance();
+    QString targetUri;
+    if (resolver->lookup(m_uri, targetUri)) {
+        if (!targetUri.isEmpty()) {
+            g_object_unref(m_file);
+            m_file = g_file_new_for_uri(targetUri.toUtf8().constData());
+            m_target_uri = targetUri;
+        }
+        return;
+    }
 
-    char *uri = g_file_info_get_attribute_as_string(info,
-                G_FILE_ATTRIBUTE_STANDARD_TARGET_URI);
+    QString uri = m_uri;
+    resolver->resolveAsync(uri, this, [=](const QString &resolvedUri) {
+        //the watcher might have changed its location.
+        if (uri != m_uri || resolvedUri.isEmpty() || resolvedUri == m_target_uri)
+            return;
+        monitorTargetUri(resolvedUri);
+    });
+}
 
-    if (uri) {
+void FileWatcher::monitorTargetUri(const QString &targetUri)
+{
+    bool monitoring = m_file_handle > 0 || m_dir_handle > 0;
+    stopMonitor();
+
+    m_target_uri = targetUri;
+    if (m_file)
         g_object_unref(m_file);
-        m_file = g_file_new_for_uri(uri);
-        m_target_uri = uri;
-        g_free(uri);
+    if (m_monitor)
+        g_object_unref(m_monitor);
+    if (m_dir_monitor)
+        g_object_unref(m_dir_monitor);
+    m_monitor = nullptr;
+    m_dir_monitor = nullptr;
+    m_support_monitor = true;
+
+    m_file = g_file_new_for_uri(targetUri.toUtf8().constData());
+
+    GError *err1 = nullptr;
+    m_monitor = g_file_monitor_file(m_file,
+                                    G_FILE_MONITOR_WATCH_MOVES,
+                                    m_cancellable,
+                                    &err1);
+    if (err1) {
+        m_support_monitor = false;
+        qDebug()<<err1->code<<err1->message;
+        g_error_free(err1);
+    }
+
+    GError *err2 = nullptr;
+    m_dir_monitor = g_file_monitor_directory(m_file,
+                    G_FILE_MONITOR_NONE,
+                    m_cancellable,
+                    &err2);
+    if (err2) {
+        m_support_monitor = false;
+        qDebug()<<err2->code<<err2->message;
+        g_error_free(err2);
     }
 
-    g_object_unref(info);
+    if (monitoring)
+        startMonitor();
 }
 
 void FileWatcher::cancel()
@@ -251,6 +313,7 @@ void FileWatcher::file_changed_callback(GFileMonitor *monitor,
         break;
     }
     case G_FILE_MONITOR_EVENT_ATTRIBUTE_CHANGED: {
+        invalidate_desktop_file_cache(file);
         char *uri = g_file_get_uri(file);
         qDebug()<<uri;
         Q_EMIT p_this->fileChanged(uri);
@@ -274,6 +337,7 @@ void FileWatcher::dir_changed_callback(GFileMonitor *monitor,
     switch (event_type) {
     case G_FILE_MONITOR_EVENT_ATTRIBUTE_CHANGED:
     case G_FILE_MONITOR_EVENT_CHANGED: {
+        invalidate_desktop_file_cache(file);
         if (p_this->m_montor_children_change) {
             char *uri = g_file_get_uri(file);
             QString changedFileUri = uri;
@@ -295,11 +359,13 @@ void FileWatcher::dir_changed_callback(GFileMonitor *monitor,
         break;
     }
     case G_FILE_MONITOR_EVENT_DELETED: {
+        invalidate_desktop_file_cache(file);
         char *uri = g_file_get_uri(file);
         QString deletedFileUri = uri;
         //QUrl url = deletedFileUri;
         //deletedFileUri = url.toDisplayString();
         g_free(uri);
+        FileLabelModel::removeFileLabelIndex(deletedFileUri);
         Q_EMIT p_this->fileDeleted(deletedFileUri);
         break;
     }
@@ -107,6 +107,12 @@ public Q_SLOTS:
 
 protected:
     void prepare();
+    /*!
+     * \brief monitorTargetUri
+     * \param targetUri
+     * move the monitors to the target uri resolved asynchronously.
+     */
+    void monitorTargetUri(const QString &targetUri);
 
     static void file_changed_callback(GFileMonitor *monitor,
                                       GFile *file,
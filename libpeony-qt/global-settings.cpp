@@ -22,6 +22,10 @@
 
 #include "global-settings.h"
 #include <QtConcurrent>
+#include <QTimer>
+#include <QFileSystemWatcher>
+#include <QFileInfo>
+#include <QDateTime>
 
 #include <QGSettings>
 
@@ -32,6 +36,18 @@ using namespace Peony;
 
 static GlobalSettings *global_instance = nullptr;
 
+/*!
+ * \brief settings_file_stamp
+ * \return modified time and size of the settings file.
+ */
+static QPair<qint64, qint64> settings_file_stamp(const QString &fileName)
+{
+    QFileInfo settingsFile(fileName);
+    if (!settingsFile.exists())
+        return qMakePair(qint64(-1), qint64(-1));
+    return qMakePair(settingsFile.lastModified().toMSecsSinceEpoch(), settingsFile.size());
+}
+
 GlobalSettings *GlobalSettings::getInstance()
 {
     if (!global_instance) {
@@ -43,6 +59,17 @@ GlobalSettings *GlobalSettings::getInstance()
 GlobalSettings::GlobalSettings(QObject *parent) : QObject(parent)
 {
     m_settings = new QSettings("org.ukui", "peony-qt-preferences", this);
+    m_file_name = m_settings->fileName();
+
+    m_sync_timer = new QTimer(this);
+    m_sync_timer->setSingleShot(true);
+    m_sync_timer->setInterval(PEONY_GLOBAL_SETTINGS_SYNC_DELAY);
+    connect(m_sync_timer, &QTimer::timeout, this, &GlobalSettings::syncAsync);
+
+    if (auto app = QCoreApplication::instance()) {
+        connect(app, &QCoreApplication::aboutToQuit, this, &GlobalSettings::flush);
+    }
+
     //set default allow parallel
     if (! m_settings->allKeys().contains(ALLOW_FILE_OP_PARALLEL))
     {
@@ -82,6 +109,22 @@ GlobalSettings::GlobalSettings(QObject *parent) : QObject(parent)
     if (m_cache.value(DEFAULT_VIEW_ZOOM_LEVEL).isNull()) {
         setValue(DEFAULT_VIEW_ZOOM_LEVEL, 25);
     }
+
+    //settings might be changed by another process, such as peony-qt-desktop.
+    m_watcher = new QFileSystemWatcher(this);
+    QFileInfo settingsFile(m_file_name);
+    m_watcher->addPath(settingsFile.absolutePath());
+    if (settingsFile.exists())
+        m_watcher->addPath(settingsFile.absoluteFilePath());
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, &GlobalSettings::reloadChangedKeys);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, [=]() {
+        //QSettings replaces the file when it syncs, watch the new one.
+        QFileInfo settingsFile(m_file_name);
+        if (settingsFile.exists() && !m_watcher->files().contains(settingsFile.absoluteFilePath())) {
+            m_watcher->addPath(settingsFile.absoluteFilePath());
+            reloadChangedKeys();
+        }
+    });
 }
 
 GlobalSettings::~GlobalSettings()
@@ -102,13 +145,10 @@ bool GlobalSettings::isExist(const QString &key)
 void GlobalSettings::reset(const QString &key)
 {
     m_cache.remove(key);
-    QtConcurrent::run([=]() {
-        if (m_mutex.tryLock(1000)) {
-            m_settings->remove(key);
-            m_settings->sync();
-            m_mutex.unlock();
-        }
-    });
+    m_mutex.lock();
+    m_dirty.insert(key, QVariant());
+    m_mutex.unlock();
+    scheduleSync();
     Q_EMIT this->valueChanged(key);
 }
 
@@ -116,32 +156,34 @@ void GlobalSettings::resetAll()
 {
     QStringList tmp = m_cache.keys();
     m_cache.clear();
+    m_mutex.lock();
+    m_dirty.clear();
+    m_clear_all = true;
+    m_mutex.unlock();
+    scheduleSync();
     for (auto key : tmp) {
         Q_EMIT this->valueChanged(key);
     }
-    QtConcurrent::run([=]() {
-        if (m_mutex.tryLock(1000)) {
-            m_settings->clear();
-            m_settings->sync();
-            m_mutex.unlock();
-        }
-    });
 }
 
 void GlobalSettings::setValue(const QString &key, const QVariant &value)
 {
+    bool changed = m_cache.value(key) != value;
     m_cache.insert(key, value);
-    QtConcurrent::run([=]() {
-        if (m_mutex.tryLock(1000)) {
-            m_settings->setValue(key, value);
-            m_settings->sync();
-            m_mutex.unlock();
-        }
-    });
+    m_mutex.lock();
+    m_dirty.insert(key, value);
+    m_mutex.unlock();
+    scheduleSync();
+    if (changed)
+        Q_EMIT this->valueChanged(key);
 }
 
 void GlobalSettings::forceSync(const QString &key)
 {
+    //write the dirty keys first, or they would be overwritten by the old values.
+    flush();
+
+    QMutexLocker l(&m_sync_mutex);
     m_settings->sync();
     if (key.isNull()) {
         m_cache.clear();
@@ -153,3 +195,144 @@ void GlobalSettings::forceSync(const QString &key)
         m_cache.insert(key, m_settings->value(key));
     }
 }
+
+void GlobalSettings::flush()
+{
+    m_sync_timer->stop();
+    //wait for the syncing worker.
+    QMutexLocker l(&m_sync_mutex);
+    m_mutex.lock();
+    auto dirty = m_dirty;
+    bool clearAll = m_clear_all;
+    m_dirty.clear();
+    m_clear_all = false;
+    m_mutex.unlock();
+    writeDirtyKeys(dirty, clearAll);
+}
+
+void GlobalSettings::scheduleSync()
+{
+    //do not restart the timer, so that the delay is bounded.
+    if (!m_sync_timer->isActive())
+        m_sync_timer->start();
+}
+
+void GlobalSettings::syncAsync()
+{
+    QtConcurrent::run([=]() {
+        //never drop the writes, wait for the previous syncing.
+        QMutexLocker l(&m_sync_mutex);
+        m_mutex.lock();
+        auto dirty = m_dirty;
+        bool clearAll = m_clear_all;
+        m_dirty.clear();
+        m_clear_all = false;
+        m_mutex.unlock();
+        writeDirtyKeys(dirty, clearAll);
+    });
+}
+
+void GlobalSettings::writeDirtyKeys(const QHash<QString, QVariant> &dirty, bool clearAll)
+{
+    //called with m_sync_mutex locked.
+    if (dirty.isEmpty() && !clearAll)
+        return;
+
+    if (clearAll)
+        m_settings->clear();
+
+    for (auto it = dirty.constBegin(); it != dirty.constEnd(); it++) {
+        if (it.value().isValid()) {
+            m_settings->setValue(it.key(), it.value());
+        } else {
+            m_settings->remove(it.key());
+        }
+    }
+    m_settings->sync();
+
+    //the watcher will notify this write, it is not reloaded.
+    auto stamp = settings_file_stamp(m_file_name);
+    m_mutex.lock();
+    m_written_stamp = stamp;
+    m_write_count++;
+    m_mutex.unlock();
+}
+
+void GlobalSettings::reloadChangedKeys()
+{
+    //ignore the changes written by this process.
+    auto stamp = settings_file_stamp(m_file_name);
+    m_mutex.lock();
+    bool written = stamp == m_written_stamp;
+    m_mutex.unlock();
+    if (written)
+        return;
+
+    reloadAsync();
+}
+
+void GlobalSettings::reloadAsync()
+{
+    QtConcurrent::run([=]() {
+        QMutexLocker l(&m_sync_mutex);
+        m_settings->sync();
+        QHash<QString, QVariant> values;
+        for (auto key : m_settings->allKeys()) {
+            values.insert(key, m_settings->value(key));
+        }
+        m_mutex.lock();
+        int writeCount = m_write_count;
+        m_mutex.unlock();
+        l.unlock();
+
+        QTimer::singleShot(0, this, [=]() {
+            applyReloadedValues(values, writeCount);
+        });
+    });
+}
+
+void GlobalSettings::applyReloadedValues(const QHash<QString, QVariant> &values, int writeCount)
+{
+    m_mutex.lock();
+    auto dirty = m_dirty;
+    bool clearAll = m_clear_all;
+    bool written = writeCount != m_write_count;
+    m_mutex.unlock();
+
+    //the values are older than the keys written meanwhile, read them again.
+    if (written) {
+        reloadAsync();
+        return;
+    }
+    //all keys are going to be removed.
+    if (clearAll)
+        return;
+
+    QStringList changedKeys;
+    for (auto it = values.constBegin(); it != values.constEnd(); it++) {
+        auto key = it.key();
+        //keys changed in this process but not written yet win.
+        if (dirty.contains(key))
+            continue;
+        auto value = it.value();
+        auto cachedValue = m_cache.value(key);
+        //values read from file might have a different type from cached ones.
+        if (cachedValue == value || (cachedValue.canConvert<QString>() && value.canConvert<QString>() &&
+                                     cachedValue.toString() == value.toString() && !value.toString().isEmpty()))
+            continue;
+        m_cache.insert(key, value);
+        changedKeys<<key;
+    }
+
+    //the keys removed by another process, the gsettings key is never in the file.
+    for (auto key : m_cache.keys()) {
+        if (values.contains(key) || dirty.contains(key) || key == SIDEBAR_BG_OPACITY)
+            continue;
+        m_cache.remove(key);
+        changedKeys<<key;
+    }
+
+    for (auto key : changedKeys) {
+        Q_EMIT this->valueChanged(key);
+    }
+}
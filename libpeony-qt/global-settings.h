@@ -26,6 +26,7 @@
 #include <QObject>
 #include <QSettings>
 #include <QMutex>
+#include <QHash>
 
 #include "peony-core_global.h"
 
@@ -39,6 +40,11 @@
 #define DEFAULT_WINDOW_SIZE "default-window-size"
 #define DEFAULT_SIDEBAR_WIDTH "default-sidebar-width"
 
+//directory snapshot cache, disabled by default.
+//the size is in MiB, see DirectorySnapshotCache.
+#define DIRECTORY_SNAPSHOT_CACHE "directory-snapshot-cache"
+#define DIRECTORY_SNAPSHOT_CACHE_SIZE "directory-snapshot-cache-size"
+
 #define DEFAULT_VIEW_ID "directory-view/default-view-id"
 #define DEFAULT_VIEW_ZOOM_LEVEL "directory-view/default-view-zoom-level"
 
@@ -48,7 +54,12 @@
 //difference between Community version and Commercial version
 #define COMMERCIAL_VERSION  false
 
+//delay of writing dirty keys to settings file, in milliseconds.
+#define PEONY_GLOBAL_SETTINGS_SYNC_DELAY 1000
+
 class QGSettings;
+class QTimer;
+class QFileSystemWatcher;
 
 namespace Peony {
 
@@ -61,6 +72,12 @@ namespace Peony {
  *
  * you can also save another kind of datas using by extensions. such as enable properties.
  * this class instance is shared in both peony-qt and its plugins.
+ *
+ * values are read from and written to an in-memory cache. the changed keys are marked
+ * dirty and written to the settings file by a worker thread in one batch, at most
+ * PEONY_GLOBAL_SETTINGS_SYNC_DELAY milliseconds after the first change, and when the
+ * application is about to quit. valueChanged() is emitted when a value changed in this
+ * process or when the settings file is changed by another process.
  */
 class PEONYCORESHARED_EXPORT GlobalSettings : public QObject
 {
@@ -87,16 +104,71 @@ public Q_SLOTS:
      */
     void forceSync(const QString &key = nullptr);
 
+    /*!
+     * \brief flush
+     * write all dirty keys to settings file in caller's thread, and wait
+     * for the syncing worker.
+     */
+    void flush();
+
+protected:
+    void scheduleSync();
+    void syncAsync();
+    void writeDirtyKeys(const QHash<QString, QVariant> &dirty, bool clearAll);
+
+    /*!
+     * \brief reloadChangedKeys
+     * reload the settings file changed by another process, and notify the
+     * keys whose value changed or which are removed. the changes written
+     * by this process are ignored.
+     */
+    void reloadChangedKeys();
+    /*!
+     * \brief reloadAsync
+     * read the settings file in a worker, then apply the values in ui thread.
+     */
+    void reloadAsync();
+    void applyReloadedValues(const QHash<QString, QVariant> &values, int writeCount);
+
 private:
     explicit GlobalSettings(QObject *parent = nullptr);
     ~GlobalSettings();
 
     QSettings *m_settings;
+    QString m_file_name;
     QMap<QString, QVariant> m_cache;
 
     QGSettings *m_gsettings = nullptr;
 
+    /*!
+     * \brief m_dirty
+     * the keys not written yet, a removed key has an invalid value.
+     */
+    QHash<QString, QVariant> m_dirty;
+    bool m_clear_all = false;
     QMutex m_mutex;
+
+    /*!
+     * \brief m_sync_mutex
+     * protects m_settings, and serializes the syncing so that the writes
+     * keep their order.
+     */
+    QMutex m_sync_mutex;
+
+    /*!
+     * \brief m_written_stamp
+     * modified time and size of the settings file after the last write of
+     * this process, guarded by m_mutex.
+     */
+    QPair<qint64, qint64> m_written_stamp;
+    /*!
+     * \brief m_write_count
+     * the count of writes, a reloaded result read before a write is stale.
+     */
+    int m_write_count = 0;
+
+    QTimer *m_sync_timer = nullptr;
+    QFileSystemWatcher *m_watcher = nullptr;
 };
 
 }
@@ -0,0 +1,619 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "local-file-enumerator.h"
+#include "uring-statx-engine.h"
+
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+
+#if defined(__linux__) && defined(SYS_getdents64) && defined(STATX_BASIC_STATS)
+#define PEONY_HAS_LOCAL_FILE_ENUMERATOR
+#endif
+
+using namespace Peony;
+
+#ifdef PEONY_HAS_LOCAL_FILE_ENUMERATOR
+
+static const unsigned int statx_mask = STATX_TYPE|STATX_MODE|STATX_NLINK|STATX_UID|STATX_GID|
+                                       STATX_ATIME|STATX_MTIME|STATX_CTIME|STATX_INO|STATX_SIZE|STATX_BLOCKS;
+
+struct linux_dirent64
+{
+    quint64 d_ino;
+    qint64 d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+static QVector<gid_t> process_groups()
+{
+    QVector<gid_t> groups;
+    groups.append(getgid());
+    int count = getgroups(0, nullptr);
+    if (count > 0) {
+        QVector<gid_t> supplementary(count);
+        count = getgroups(count, supplementary.data());
+        for (int i = 0; i < count; i++) {
+            groups.append(supplementary.at(i));
+        }
+    }
+    return groups;
+}
+
+static bool in_group(gid_t gid)
+{
+    //groups of a process are not changed while it is running.
+    static const QVector<gid_t> groups = process_groups();
+    return groups.contains(gid);
+}
+
+/*!
+ * \brief check_access
+ * the same result as access() in most cases, but computed from
+ * the statx result without another syscall. acl is not checked.
+ */
+static bool check_access(const struct statx &stx, int mode)
+{
+    static uid_t uid = getuid();
+    if (uid == 0) {
+        if (mode == X_OK)
+            return S_ISDIR(stx.stx_mode) || (stx.stx_mode & (S_IXUSR|S_IXGRP|S_IXOTH));
+        return true;
+    }
+    if (stx.stx_uid == uid)
+        return stx.stx_mode & (mode << 6);
+    if (in_group(stx.stx_gid))
+        return stx.stx_mode & (mode << 3);
+    return stx.stx_mode & mode;
+}
+
+static GFileType file_type_from_mode(mode_t mode)
+{
+    if (S_ISREG(mode))
+        return G_FILE_TYPE_REGULAR;
+    if (S_ISDIR(mode))
+        return G_FILE_TYPE_DIRECTORY;
+    if (S_ISLNK(mode))
+        return G_FILE_TYPE_SYMBOLIC_LINK;
+    if (S_ISCHR(mode) || S_ISBLK(mode) || S_ISFIFO(mode) || S_ISSOCK(mode))
+        return G_FILE_TYPE_SPECIAL;
+    return G_FILE_TYPE_UNKNOWN;
+}
+
+/*!
+ * \brief guess_content_type
+ * same as GIO does for local files. the content type is guessed from
+ * the file name, the head of file is only read if the name is uncertain.
+ */
+static char *guess_content_type(int dirfd, const char *name, const struct statx &stx, bool isBrokenLink)
+{
+    if (isBrokenLink)
+        return g_strdup("inode/symlink");
+    if (S_ISDIR(stx.stx_mode))
+        return g_strdup("inode/directory");
+    if (S_ISCHR(stx.stx_mode))
+        return g_strdup("inode/chardevice");
+    if (S_ISBLK(stx.stx_mode))
+        return g_strdup("inode/blockdevice");
+    if (S_ISFIFO(stx.stx_mode))
+        return g_strdup("inode/fifo");
+    if (S_ISSOCK(stx.stx_mode))
+        return g_strdup("inode/socket");
+
+    gboolean uncertain = false;
+    char *content_type = g_content_type_guess(name, nullptr, 0, &uncertain);
+    if (!uncertain || !S_ISREG(stx.stx_mode))
+        return content_type;
+
+    if (stx.stx_size == 0) {
+        g_free(content_type);
+        return g_strdup("application/x-zerosize");
+    }
+
+    int fd = openat(dirfd, name, O_RDONLY|O_CLOEXEC);
+    if (fd < 0)
+        return content_type;
+    guchar sniff_buffer[4096];
+    ssize_t length = read(fd, sniff_buffer, sizeof(sniff_buffer));
+    close(fd);
+    if (length > 0) {
+        g_free(content_type);
+        content_type = g_content_type_guess(name, sniff_buffer, length, nullptr);
+    }
+    return content_type;
+}
+
+/*!
+ * \brief special_directory_icon_name
+ * \return the icon name of home or xdg user directories, which GIO uses
+ * instead of the icon of content type.
+ */
+static const char *special_directory_icon_name(const char *path)
+{
+    if (g_strcmp0(path, g_get_home_dir()) == 0)
+        return "user-home";
+
+    struct SpecialDirectory {
+        GUserDirectory directory;
+        const char *icon_name;
+    };
+    static const SpecialDirectory directories[] = {
+        {G_USER_DIRECTORY_DESKTOP, "user-desktop"},
+        {G_USER_DIRECTORY_DOCUMENTS, "folder-documents"},
+        {G_USER_DIRECTORY_DOWNLOAD, "folder-download"},
+        {G_USER_DIRECTORY_MUSIC, "folder-music"},
+        {G_USER_DIRECTORY_PICTURES, "folder-pictures"},
+        {G_USER_DIRECTORY_PUBLIC_SHARE, "folder-publicshare"},
+        {G_USER_DIRECTORY_TEMPLATES, "folder-templates"},
+        {G_USER_DIRECTORY_VIDEOS, "folder-videos"},
+    };
+    for (auto special : directories) {
+        auto special_path = g_get_user_special_dir(special.directory);
+        if (special_path && g_strcmp0(path, special_path) == 0) {
+            //desktop might be same as home.
+            if (g_strcmp0(special_path, g_get_home_dir()) == 0)
+                continue;
+            return special.icon_name;
+        }
+    }
+    return nullptr;
+}
+
+#endif
+
+LocalFileEnumerator::LocalFileEnumerator(GFile *dir, bool withInfo)
+{
+    m_dir = G_FILE(g_object_ref(dir));
+    char *path = g_file_get_path(dir);
+    m_path = path;
+    g_free(path);
+    m_with_info = withInfo;
+}
+
+LocalFileEnumerator::~LocalFileEnumerator()
+{
+    if (m_fd >= 0)
+        ::close(m_fd);
+
+    for (auto info : m_metadata) {
+        g_object_unref(info);
+    }
+    g_object_unref(m_dir);
+}
+
+bool LocalFileEnumerator::isSupported(GFile *dir)
+{
+#ifdef PEONY_HAS_LOCAL_FILE_ENUMERATOR
+    if (!dir || !g_file_is_native(dir) || !g_file_has_uri_scheme(dir, "file"))
+        return false;
+    char *path = g_file_get_path(dir);
+    bool supported = path != nullptr;
+    g_free(path);
+    return supported;
+#else
+    Q_UNUSED(dir)
+    return false;
+#endif
+}
+
+bool LocalFileEnumerator::open(GCancellable *cancellable)
+{
+#ifdef PEONY_HAS_LOCAL_FILE_ENUMERATOR
+    if (m_path.isEmpty()) {
+        m_errno = ENOENT;
+        return false;
+    }
+
+    m_fd = ::open(m_path.constData(), O_RDONLY|O_DIRECTORY|O_CLOEXEC);
+    if (m_fd < 0) {
+        m_errno = errno;
+        return false;
+    }
+
+    m_buffer.resize(PEONY_LOCAL_ENUMERATOR_BUFFER_SIZE);
+    m_cancellable = cancellable;
+
+    if (m_with_info) {
+        loadHiddenNames();
+        loadDirectoryAccess(cancellable);
+    }
+    return true;
+#else
+    Q_UNUSED(cancellable)
+    m_errno = ENOTSUP;
+    return false;
+#endif
+}
+
+bool LocalFileEnumerator::readEntries()
+{
+#ifdef PEONY_HAS_LOCAL_FILE_ENUMERATOR
+    long length = syscall(SYS_getdents64, m_fd, m_buffer.data(), m_buffer.size());
+    if (length <= 0) {
+        if (length < 0)
+            m_errno = errno;
+        m_eof = true;
+        m_buffer_length = 0;
+        m_buffer_offset = 0;
+        return false;
+    }
+    m_buffer_length = int(length);
+    m_buffer_offset = 0;
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool LocalFileEnumerator::nextFiles(int count, QList<LocalFileEntry> &children)
+{
+#ifdef PEONY_HAS_LOCAL_FILE_ENUMERATOR
+    if (m_fd < 0)
+        return false;
+
+    QByteArray prefix = m_path;
+    if (!prefix.endsWith('/'))
+        prefix.append('/');
+
+    QList<QByteArray> names;
+    QList<unsigned char> types;
+    while (names.count() < count) {
+        if (m_buffer_offset >= m_buffer_length) {
+            if (m_eof || !readEntries())
+                break;
+        }
+
+        auto entry = reinterpret_cast<linux_dirent64 *>(m_buffer.data() + m_buffer_offset);
+        m_buffer_offset += entry->d_reclen;
+
+        const char *name = entry->d_name;
+        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
+            continue;
+
+        names<<QByteArray(name);
+        types<<entry->d_type;
+    }
+
+    QVector<struct statx> results;
+    QVector<int> errors;
+    bool prefetched = m_with_info && prefetchStatx(names, AT_STATX_SYNC_AS_STAT, results, errors);
+
+    for (int i = 0; i < names.count(); i++) {
+        QByteArray path = prefix + names.at(i);
+        char *uri = g_filename_to_uri(path.constData(), nullptr, nullptr);
+        if (!uri)
+            continue;
+
+        LocalFileEntry child;
+        child.uri = uri;
+        g_free(uri);
+
+        if (m_with_info) {
+            bool stated = prefetched && errors.at(i) == 0;
+            child.info = createFileInfo(names.at(i).constData(), types.at(i), stated? &results.at(i): nullptr);
+            //the child might be removed while enumerating.
+            if (!child.info)
+                continue;
+        }
+
+        children<<child;
+    }
+
+    return !(m_eof && m_buffer_offset >= m_buffer_length);
+#else
+    Q_UNUSED(count)
+    Q_UNUSED(children)
+    return false;
+#endif
+}
+
+QList<GFileInfo *> LocalFileEnumerator::queryFileInfos(const QList<QByteArray> &names)
+{
+    QList<GFileInfo *> infos;
+#ifdef PEONY_HAS_LOCAL_FILE_ENUMERATOR
+    if (m_fd < 0) {
+        for (int i = 0; i < names.count(); i++) {
+            infos<<nullptr;
+        }
+        return infos;
+    }
+
+    //the entry types are unknown, do not follow symbolic links, so that the
+    //results can be used directly for all the children except links.
+    QVector<struct statx> results;
+    QVector<int> errors;
+    bool prefetched = prefetchStatx(names, AT_SYMLINK_NOFOLLOW|AT_STATX_SYNC_AS_STAT, results, errors);
+
+    for (int i = 0; i < names.count(); i++) {
+        if (prefetched && errors.at(i) == 0) {
+            auto &stx = results.at(i);
+            if (S_ISLNK(stx.stx_mode)) {
+                infos<<createFileInfo(names.at(i).constData(), DT_LNK);
+            } else {
+                infos<<createFileInfo(names.at(i).constData(), IFTODT(stx.stx_mode), &stx);
+            }
+        } else {
+            infos<<createFileInfo(names.at(i).constData(), DT_UNKNOWN);
+        }
+    }
+#else
+    for (int i = 0; i < names.count(); i++) {
+        infos<<nullptr;
+    }
+#endif
+    return infos;
+}
+
+bool LocalFileEnumerator::prefetchStatx(const QList<QByteArray> &names, int flags, QVector<struct statx> &results, QVector<int> &errors)
+{
+#ifdef PEONY_HAS_LOCAL_FILE_ENUMERATOR
+    if (names.count() < PEONY_URING_MIN_BATCH)
+        return false;
+
+    //the enumerator might be opened and used in different workers, use the
+    //ring of current thread.
+    auto uring = UringStatxEngine::threadInstance();
+    if (!uring)
+        return false;
+
+    QVector<const char *> paths;
+    for (auto &name : names) {
+        paths<<name.constData();
+    }
+    results.resize(names.count());
+    errors.resize(names.count());
+    //a failed ring is released, and it is not used in this thread any more.
+    return uring->statxBatch(m_fd, paths.constData(), paths.count(), flags, statx_mask, results.data(), errors.data());
+#else
+    Q_UNUSED(names)
+    Q_UNUSED(flags)
+    Q_UNUSED(results)
+    Q_UNUSED(errors)
+    return false;
+#endif
+}
+
+GFileInfo *LocalFileEnumerator::createFileInfo(const char *name, unsigned char type, const struct statx *prefetched)
+{
+#ifdef PEONY_HAS_LOCAL_FILE_ENUMERATOR
+    const unsigned int mask = statx_mask;
+
+    struct statx stx;
+    bool is_symlink = type == DT_LNK;
+    bool is_broken_link = false;
+
+    if (type == DT_UNKNOWN) {
+        //some file systems do not fill d_type.
+        if (statx(m_fd, name, AT_SYMLINK_NOFOLLOW|AT_STATX_SYNC_AS_STAT, STATX_TYPE, &stx) != 0)
+            return nullptr;
+        is_symlink = S_ISLNK(stx.stx_mode);
+    }
+
+    //standard attributes are about the target of a symbolic link, as GIO does.
+    if (prefetched) {
+        stx = *prefetched;
+    } else if (statx(m_fd, name, AT_STATX_SYNC_AS_STAT, mask, &stx) != 0) {
+        if (!is_symlink || statx(m_fd, name, AT_SYMLINK_NOFOLLOW|AT_STATX_SYNC_AS_STAT, mask, &stx) != 0)
+            return nullptr;
+        is_broken_link = true;
+    }
+
+    GFileInfo *info = g_file_info_new();
+
+    g_file_info_set_name(info, name);
+    char *display_name = g_filename_display_name(name);
+    g_file_info_set_display_name(info, display_name);
+    g_file_info_set_edit_name(info, display_name);
+    g_free(display_name);
+
+    g_file_info_set_file_type(info, is_broken_link? G_FILE_TYPE_SYMBOLIC_LINK: file_type_from_mode(stx.stx_mode));
+    g_file_info_set_is_symlink(info, is_symlink);
+    if (is_symlink) {
+        char target[PATH_MAX];
+        ssize_t length = readlinkat(m_fd, name, target, sizeof(target) - 1);
+        if (length >= 0) {
+            target[length] = '\0';
+            g_file_info_set_symlink_target(info, target);
+        }
+    }
+    g_file_info_set_is_hidden(info, name[0] == '.' || m_hidden_names.contains(name));
+    g_file_info_set_is_backup(info, g_str_has_suffix(name, "~"));
+
+    g_file_info_set_size(info, goffset(stx.stx_size));
+    g_file_info_set_attribute_uint64(info, G_FILE_ATTRIBUTE_STANDARD_ALLOCATED_SIZE, stx.stx_blocks*512);
+
+    g_file_info_set_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_MODIFIED, stx.stx_mtime.tv_sec);
+    g_file_info_set_attribute_uint32(info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC, stx.stx_mtime.tv_nsec/1000);
+    g_file_info_set_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_ACCESS, stx.stx_atime.tv_sec);
+    g_file_info_set_attribute_uint32(info, G_FILE_ATTRIBUTE_TIME_ACCESS_USEC, stx.stx_atime.tv_nsec/1000);
+    g_file_info_set_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_CHANGED, stx.stx_ctime.tv_sec);
+    g_file_info_set_attribute_uint32(info, G_FILE_ATTRIBUTE_TIME_CHANGED_USEC, stx.stx_ctime.tv_nsec/1000);
+
+    guint64 device = makedev(stx.stx_dev_major, stx.stx_dev_minor);
+    g_file_info_set_attribute_uint32(info, G_FILE_ATTRIBUTE_UNIX_DEVICE, device);
+    g_file_info_set_attribute_uint64(info, G_FILE_ATTRIBUTE_UNIX_INODE, stx.stx_ino);
+    g_file_info_set_attribute_uint32(info, G_FILE_ATTRIBUTE_UNIX_MODE, stx.stx_mode);
+    g_file_info_set_attribute_uint32(info, G_FILE_ATTRIBUTE_UNIX_NLINK, stx.stx_nlink);
+    g_file_info_set_attribute_uint32(info, G_FILE_ATTRIBUTE_UNIX_UID, stx.stx_uid);
+    g_file_info_set_attribute_uint32(info, G_FILE_ATTRIBUTE_UNIX_GID, stx.stx_gid);
+
+    char *file_id = g_strdup_printf("l%" G_GUINT64_FORMAT ":%" G_GUINT64_FORMAT, device, guint64(stx.stx_ino));
+    g_file_info_set_attribute_string(info, G_FILE_ATTRIBUTE_ID_FILE, file_id);
+    g_free(file_id);
+
+    g_file_info_set_attribute_boolean(info, G_FILE_ATTRIBUTE_ACCESS_CAN_READ, check_access(stx, R_OK));
+    g_file_info_set_attribute_boolean(info, G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE, check_access(stx, W_OK));
+    g_file_info_set_attribute_boolean(info, G_FILE_ATTRIBUTE_ACCESS_CAN_EXECUTE, check_access(stx, X_OK));
+    //deleting, renaming and trashing a child only depends on the directory.
+    g_file_info_set_attribute_boolean(info, G_FILE_ATTRIBUTE_ACCESS_CAN_DELETE, m_dir_can_write);
+    g_file_info_set_attribute_boolean(info, G_FILE_ATTRIBUTE_ACCESS_CAN_RENAME, m_dir_can_write);
+    g_file_info_set_attribute_boolean(info, G_FILE_ATTRIBUTE_ACCESS_CAN_TRASH, m_dir_can_write && m_dir_can_trash);
+
+    char *content_type = guess_content_type(m_fd, name, stx, is_broken_link);
+    g_file_info_set_content_type(info, content_type);
+    g_file_info_set_attribute_string(info, G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE, content_type);
+
+    GIcon *icon = nullptr;
+    GIcon *symbolic_icon = nullptr;
+    if (S_ISDIR(stx.stx_mode) && !is_broken_link) {
+        QByteArray path = m_path;
+        if (!path.endsWith('/'))
+            path.append('/');
+        path.append(name);
+        auto icon_name = special_directory_icon_name(path.constData());
+        if (icon_name) {
+            icon = g_themed_icon_new(icon_name);
+            g_themed_icon_append_name(G_THEMED_ICON(icon), "folder");
+            char *symbolic_icon_name = g_strconcat(icon_name, "-symbolic", nullptr);
+            symbolic_icon = g_themed_icon_new(symbolic_icon_name);
+            g_themed_icon_append_name(G_THEMED_ICON(symbolic_icon), "folder-symbolic");
+            g_free(symbolic_icon_name);
+        }
+    }
+    if (!icon)
+        icon = g_content_type_get_icon(content_type);
+    if (!symbolic_icon)
+        symbolic_icon = g_content_type_get_symbolic_icon(content_type);
+    g_file_info_set_icon(info, icon);
+    g_file_info_set_symbolic_icon(info, symbolic_icon);
+    g_object_unref(icon);
+    g_object_unref(symbolic_icon);
+    g_free(content_type);
+
+    //the metadata are looked up for the children of current batch only, a
+    //metadata query of the whole directory would delay the first batch.
+    GFileInfo *metadata = nullptr;
+    if (m_metadata_loaded) {
+        metadata = m_metadata.value(name);
+        if (metadata)
+            g_object_ref(metadata);
+    } else {
+        GFile *child = g_file_get_child(m_dir, name);
+        metadata = g_file_query_info(child, "metadata::*", G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, m_cancellable, nullptr);
+        g_object_unref(child);
+    }
+    if (metadata) {
+        char **attributes = g_file_info_list_attributes(metadata, "metadata");
+        for (int i = 0; attributes && attributes[i] != nullptr; i++) {
+            GFileAttributeType attribute_type;
+            gpointer value = nullptr;
+            if (g_file_info_get_attribute_data(metadata, attributes[i], &attribute_type, &value, nullptr))
+                g_file_info_set_attribute(info, attributes[i], attribute_type, value);
+        }
+        g_strfreev(attributes);
+        g_object_unref(metadata);
+    }
+
+    return info;
+#else
+    Q_UNUSED(name)
+    Q_UNUSED(type)
+    return nullptr;
+#endif
+}
+
+void LocalFileEnumerator::loadMetadata(GCancellable *cancellable)
+{
+    if (m_metadata_loaded)
+        return;
+
+    //gvfs metadata are stored in a meta tree of the directory, query them
+    //without any other attributes.
+    GFileEnumerator *enumerator = g_file_enumerate_children(m_dir,
+                                  G_FILE_ATTRIBUTE_STANDARD_NAME "," "metadata::*",
+                                  G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                  cancellable,
+                                  nullptr);
+    if (!enumerator)
+        return;
+
+    GError *err = nullptr;
+    while (GFileInfo *info = g_file_enumerator_next_file(enumerator, cancellable, &err)) {
+        if (g_file_info_has_namespace(info, "metadata")) {
+            m_metadata.insert(g_file_info_get_name(info), info);
+        } else {
+            g_object_unref(info);
+        }
+    }
+    g_file_enumerator_close(enumerator, nullptr, nullptr);
+    g_object_unref(enumerator);
+
+    //an incomplete result would drop the metadata of the other children,
+    //keep looking up them per child.
+    if (err) {
+        g_error_free(err);
+        for (auto info : m_metadata) {
+            g_object_unref(info);
+        }
+        m_metadata.clear();
+        return;
+    }
+    m_metadata_loaded = true;
+}
+
+void LocalFileEnumerator::loadHiddenNames()
+{
+#ifdef PEONY_HAS_LOCAL_FILE_ENUMERATOR
+    //the names listed in .hidden are hidden too.
+    int fd = openat(m_fd, ".hidden", O_RDONLY|O_CLOEXEC);
+    if (fd < 0)
+        return;
+
+    QByteArray content;
+    char buffer[4096];
+    ssize_t length = 0;
+    while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+        content.append(buffer, int(length));
+    }
+    ::close(fd);
+
+    for (auto line : content.split('\n')) {
+        auto name = line.trimmed();
+        if (!name.isEmpty())
+            m_hidden_names.insert(name);
+    }
+#endif
+}
+
+void LocalFileEnumerator::loadDirectoryAccess(GCancellable *cancellable)
+{
+    GFileInfo *info = g_file_query_info(m_dir,
+                                        G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE "," G_FILE_ATTRIBUTE_ACCESS_CAN_TRASH,
+                                        G_FILE_QUERY_INFO_NONE,
+                                        cancellable,
+                                        nullptr);
+    if (!info)
+        return;
+
+    m_dir_can_write = g_file_info_get_attribute_boolean(info, G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE);
+    m_dir_can_trash = g_file_info_get_attribute_boolean(info, G_FILE_ATTRIBUTE_ACCESS_CAN_TRASH);
+    g_object_unref(info);
+}
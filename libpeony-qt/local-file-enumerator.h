@@ -0,0 +1,184 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef LOCALFILEENUMERATOR_H
+#define LOCALFILEENUMERATOR_H
+
+#include "peony-core_global.h"
+
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QVector>
+
+#include <gio/gio.h>
+
+#define PEONY_LOCAL_ENUMERATOR_BUFFER_SIZE 256*1024
+
+/*!
+ * \brief PEONY_LOCAL_METADATA_PRELOAD_MIN
+ * querying the metadata of a whole directory is only worth when at least
+ * this many children of it are queried, otherwise they are looked up per child.
+ */
+#define PEONY_LOCAL_METADATA_PRELOAD_MIN 1024
+
+struct statx;
+
+namespace Peony {
+
+/*!
+ * \brief The LocalFileEntry struct
+ * a child enumerated by LocalFileEnumerator. the info is owned by
+ * the receiver, and it is nullptr if the enumerator is not enumerating
+ * with info.
+ */
+struct LocalFileEntry
+{
+    QString uri;
+    GFileInfo *info = nullptr;
+};
+
+/*!
+ * \brief The LocalFileEnumerator class
+ * <br>
+ * This is a fast path of enumerating the children of a local directory.
+ * GLocalFileEnumerator reads the directory with readdir(), and it queries
+ * every attribute of every child with several blocking calls and a lot of
+ * GFileInfo hash table operations.
+ * </br>
+ * <br>
+ * LocalFileEnumerator reads the directory entries with getdents64() and a
+ * large buffer. If only the uris of children are needed, it does not touch
+ * the children at all. Otherwise it issues one statx() for each child with
+ * the attributes FileInfo needs, and builds a GFileInfo with the same attributes
+ * as GIO does, so that the result can be applied by FileInfoJob::refreshInfoContents().
+ * The gvfs metadata of a child are looked up when its info is created, so that
+ * a batch only waits for the metadata of its own children.
+ * </br>
+ * <br>
+ * If io_uring is supported, the statx() calls of a batch are submitted to
+ * the UringStatxEngine of current thread at once, instead of being issued
+ * one by one.
+ * </br>
+ * \note This class is blocking and not thread safe, it is designed to be used
+ * in a worker thread by FileEnumerator. GIO is still used for all the
+ * other uris, and if the fast path failed for some reason.
+ * \see FileEnumerator, PEONY_FILE_INFO_QUERY_ATTRIBUTES.
+ */
+class PEONYCORESHARED_EXPORT LocalFileEnumerator
+{
+public:
+    explicit LocalFileEnumerator(GFile *dir, bool withInfo = false);
+    ~LocalFileEnumerator();
+
+    /*!
+     * \brief isSupported
+     * \param dir
+     * \return true if dir is a native directory can be enumerated with the fast path.
+     */
+    static bool isSupported(GFile *dir);
+
+    /*!
+     * \brief open
+     * \param cancellable
+     * \return false if the directory can not be opened, errno is kept in error().
+     */
+    bool open(GCancellable *cancellable = nullptr);
+    int error() {
+        return m_errno;
+    }
+
+    /*!
+     * \brief nextFiles
+     * \param count
+     * \param children, the enumerated children are appended to it.
+     * \return false if there is no more children.
+     */
+    bool nextFiles(int count, QList<LocalFileEntry> &children);
+
+    /*!
+     * \brief queryFileInfos
+     * \param names, names of children in the directory.
+     * \return the GFileInfos of the children, owned by the caller. an info
+     * is nullptr if the child can not be queried.
+     * \note the enumerator should be created with info and opened.
+     */
+    QList<GFileInfo *> queryFileInfos(const QList<QByteArray> &names);
+
+    /*!
+     * \brief loadMetadata
+     * query the metadata of all children with one enumeration of the directory,
+     * the later created infos take the metadata from it instead of looking up
+     * every child.
+     * \see PEONY_LOCAL_METADATA_PRELOAD_MIN.
+     */
+    void loadMetadata(GCancellable *cancellable);
+
+protected:
+    bool readEntries();
+    /*!
+     * \brief createFileInfo
+     * \param name
+     * \param type, d_type of the entry.
+     * \param prefetched, the statx result of the entry (following symbolic link)
+     * which has been fetched in a batch, or nullptr.
+     */
+    GFileInfo *createFileInfo(const char *name, unsigned char type, const struct statx *prefetched = nullptr);
+    /*!
+     * \brief prefetchStatx
+     * \return true if the names are stated with io_uring.
+     */
+    bool prefetchStatx(const QList<QByteArray> &names, int flags, QVector<struct statx> &results, QVector<int> &errors);
+    void loadHiddenNames();
+    void loadDirectoryAccess(GCancellable *cancellable);
+
+private:
+    GFile *m_dir = nullptr;
+    QByteArray m_path;
+    bool m_with_info = false;
+
+    int m_fd = -1;
+    int m_errno = 0;
+    GCancellable *m_cancellable = nullptr;
+    bool m_eof = false;
+
+    QByteArray m_buffer;
+    int m_buffer_length = 0;
+    int m_buffer_offset = 0;
+
+    /*!
+     * \brief m_metadata
+     * child name -> GFileInfo only contains the metadata attributes.
+     */
+    QHash<QByteArray, GFileInfo *> m_metadata;
+    bool m_metadata_loaded = false;
+    QSet<QByteArray> m_hidden_names;
+
+    bool m_dir_can_write = false;
+    bool m_dir_can_trash = false;
+};
+
+}
+
+#endif // LOCALFILEENUMERATOR_H
@@ -0,0 +1,160 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "metadata-write-queue.h"
+
+#include <QtConcurrent>
+#include <QCoreApplication>
+#include <QTimer>
+
+#include <QDebug>
+
+#include <gio/gio.h>
+
+using namespace Peony;
+
+MetadataWriteQueue *MetadataWriteQueue::getInstance()
+{
+    static MetadataWriteQueue *global_instance = new MetadataWriteQueue;
+    return global_instance;
+}
+
+MetadataWriteQueue::MetadataWriteQueue(QObject *parent) : QObject(parent)
+{
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    m_timer->setInterval(PEONY_METADATA_WRITE_DELAY);
+    connect(m_timer, &QTimer::timeout, this, &MetadataWriteQueue::flushAsync);
+
+    if (auto app = QCoreApplication::instance()) {
+        connect(app, &QCoreApplication::aboutToQuit, this, &MetadataWriteQueue::flush);
+    }
+}
+
+void MetadataWriteQueue::setAttribute(const QString &uri, const QString &key, const QString &value)
+{
+    m_mutex.lock();
+    m_pending[uri].insert(key, value);
+    m_mutex.unlock();
+    scheduleFlush();
+}
+
+void MetadataWriteQueue::removeAttribute(const QString &uri, const QString &key)
+{
+    m_mutex.lock();
+    m_pending[uri].insert(key, QVariant());
+    m_mutex.unlock();
+    scheduleFlush();
+}
+
+const QHash<QString, QVariant> MetadataWriteQueue::pendingAttributes(const QString &uri)
+{
+    QMutexLocker l(&m_mutex);
+    //the writes being flushed might not be visible in gvfs yet.
+    auto attributes = m_in_flight.value(uri);
+    auto pending = m_pending.value(uri);
+    for (auto it = pending.constBegin(); it != pending.constEnd(); it++) {
+        attributes.insert(it.key(), it.value());
+    }
+    return attributes;
+}
+
+void MetadataWriteQueue::flush()
+{
+    m_timer->stop();
+    //wait for the flushing worker.
+    QMutexLocker l(&m_flush_mutex);
+    writeAttributes(takePending());
+    finishWriting();
+}
+
+void MetadataWriteQueue::scheduleFlush()
+{
+    //do not restart the timer, so that the delay is bounded.
+    QTimer::singleShot(0, this, [=]() {
+        if (!m_timer->isActive())
+            m_timer->start();
+    });
+}
+
+void MetadataWriteQueue::flushAsync()
+{
+    QtConcurrent::run([=]() {
+        QMutexLocker l(&m_flush_mutex);
+        writeAttributes(takePending());
+        finishWriting();
+    });
+}
+
+QHash<QString, QHash<QString, QVariant>> MetadataWriteQueue::takePending()
+{
+    QMutexLocker l(&m_mutex);
+    m_in_flight = m_pending;
+    m_pending.clear();
+    return m_in_flight;
+}
+
+void MetadataWriteQueue::finishWriting()
+{
+    QMutexLocker l(&m_mutex);
+    m_in_flight.clear();
+}
+
+void MetadataWriteQueue::writeAttributes(const QHash<QString, QHash<QString, QVariant>> &pending)
+{
+    for (auto it = pending.constBegin(); it != pending.constEnd(); it++) {
+        GFile *file = g_file_new_for_uri(it.key().toUtf8().constData());
+        GFileInfo *info = g_file_info_new();
+        bool has_value = false;
+
+        auto keys = it.value();
+        for (auto key = keys.constBegin(); key != keys.constEnd(); key++) {
+            if (key.value().isValid()) {
+                g_file_info_set_attribute_string(info,
+                                                 key.key().toUtf8().constData(),
+                                                 key.value().toString().toUtf8().constData());
+                has_value = true;
+            } else {
+                g_file_set_attribute(file,
+                                     key.key().toUtf8().constData(),
+                                     G_FILE_ATTRIBUTE_TYPE_INVALID,
+                                     nullptr,
+                                     G_FILE_QUERY_INFO_NONE,
+                                     nullptr,
+                                     nullptr);
+            }
+        }
+
+        if (has_value) {
+            //set all the keys of this file in one call.
+            GError *err = nullptr;
+            g_file_set_attributes_from_info(file, info, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, nullptr, &err);
+            if (err) {
+                qDebug()<<err->message;
+                g_error_free(err);
+            }
+        }
+
+        g_object_unref(info);
+        g_object_unref(file);
+    }
+}
@@ -0,0 +1,125 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#ifndef METADATAWRITEQUEUE_H
+#define METADATAWRITEQUEUE_H
+
+#include "peony-core_global.h"
+
+#include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <QVariant>
+
+#define PEONY_METADATA_WRITE_DELAY 300
+
+class QTimer;
+
+namespace Peony {
+
+/*!
+ * \brief The MetadataWriteQueue class
+ * <br>
+ * This class delays and batches the gvfs metadata writes of FileMetaInfo.
+ * Writing metadata is a blocking call to gvfs metadata daemon, setting many
+ * keys in a row, such as saving the positions of all desktop icons, would
+ * block the caller for a long time.
+ * </br>
+ * <br>
+ * The writes are queued instead. Writes of same uri and key are coalesced, only
+ * the last one is kept. The queue is flushed in a worker thread, at most
+ * PEONY_METADATA_WRITE_DELAY milliseconds after the first write queued, and all
+ * keys of a file are set in one call.
+ * </br>
+ * \note
+ * The pending writes are flushed synchronously when the application is about to quit.
+ * Call flush() if you need the data written before reading it from another process.
+ * \see FileMetaInfo.
+ */
+class PEONYCORESHARED_EXPORT MetadataWriteQueue : public QObject
+{
+    Q_OBJECT
+public:
+    static MetadataWriteQueue *getInstance();
+
+    void setAttribute(const QString &uri, const QString &key, const QString &value);
+    void removeAttribute(const QString &uri, const QString &key);
+
+    /*!
+     * \brief pendingAttributes
+     * \param uri
+     * \return the writes of uri not written yet, including the ones being flushed,
+     * a removed key has an invalid value.
+     * \details
+     * FileMetaInfo created from a newly queried GFileInfo uses them to override
+     * the values read from gvfs, which might be out of date.
+     */
+    const QHash<QString, QVariant> pendingAttributes(const QString &uri);
+
+public Q_SLOTS:
+    /*!
+     * \brief flush
+     * write all pending writes in caller's thread, and wait for the flushing worker.
+     */
+    void flush();
+
+protected:
+    void scheduleFlush();
+    void flushAsync();
+
+    /*!
+     * \brief takePending
+     * \return the pending writes, which are taken out from queue
+     * and kept in flight until finishWriting().
+     */
+    QHash<QString, QHash<QString, QVariant>> takePending();
+    void finishWriting();
+    void writeAttributes(const QHash<QString, QHash<QString, QVariant>> &pending);
+
+private:
+    explicit MetadataWriteQueue(QObject *parent = nullptr);
+
+    /*!
+     * \brief m_pending
+     * file uri -> (key -> value), a removed key has an invalid value.
+     */
+    QHash<QString, QHash<QString, QVariant>> m_pending;
+    /*!
+     * \brief m_in_flight
+     * the writes taken by the flushing worker, still visible to pendingAttributes().
+     */
+    QHash<QString, QHash<QString, QVariant>> m_in_flight;
+    QMutex m_mutex;
+
+    /*!
+     * \brief m_flush_mutex
+     * serializes flushing, so that writes of a key keep their order.
+     */
+    QMutex m_flush_mutex;
+
+    QTimer *m_timer = nullptr;
+};
+
+}
+
+#endif // METADATAWRITEQUEUE_H
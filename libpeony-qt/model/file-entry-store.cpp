@@ -0,0 +1,339 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "file-entry-store.h"
+#include "file-info.h"
+
+#include <QUrl>
+#include <QtMath>
+
+#include <algorithm>
+
+using namespace Peony;
+
+FileEntryStore::FileEntryStore(const QString &parentUri)
+{
+    m_parent_uri = parentUri;
+    if (!m_parent_uri.endsWith("/"))
+        m_parent_uri.append("/");
+    rebuildIndex();
+}
+
+bool FileEntryStore::append(const std::shared_ptr<FileInfo> &info)
+{
+    auto name = nameFromUri(info->uri());
+    if (name.isEmpty() || findName(name.constData(), name.length()) >= 0)
+        return false;
+
+    FileEntry entry;
+    entry.nameOffset = m_names.length();
+    entry.nameLength = name.length();
+    m_names.append(name);
+    entry.flags = 0;
+    fillEntry(entry, info);
+
+    m_entries.append(entry);
+    insertIndex(m_entries.count() - 1);
+    return true;
+}
+
+void FileEntryStore::update(int row, const std::shared_ptr<FileInfo> &info)
+{
+    if (row < 0 || row >= m_entries.count())
+        return;
+    fillEntry(m_entries[row], info);
+}
+
+void FileEntryStore::remove(int row, int count)
+{
+    if (row < 0 || count <= 0 || row + count > m_entries.count())
+        return;
+
+    //the slots of removed rows become tombstones, and the rows stored after
+    //them are shifted when they are looked up. the index is rebuilt once there
+    //are too many tombstones, so that removing rows one by one stays cheap.
+    if (!m_index_dirty && m_removed_ids.count() + count <= qMax(PEONY_FILE_ENTRY_STORE_MAX_TOMBSTONES, m_entries.count()/16)) {
+        QVector<int> ids;
+        for (int i = row; i < row + count; i++) {
+            ids<<idOfRow(i);
+        }
+        for (int id : ids) {
+            m_removed_ids.insert(std::lower_bound(m_removed_ids.begin(), m_removed_ids.end(), id), id);
+        }
+    } else {
+        m_index_dirty = true;
+    }
+
+    for (int i = row; i < row + count; i++) {
+        releaseDisplayName(m_entries.at(i));
+        m_garbage_length += m_entries.at(i).nameLength;
+    }
+    m_entries.remove(row, count);
+
+    if (m_garbage_length > m_names.length()/2)
+        compactNames();
+}
+
+void FileEntryStore::removeRows(const QVector<int> &rows)
+{
+    if (rows.isEmpty())
+        return;
+
+    int next = 0;
+    int kept = 0;
+    for (int i = 0; i < m_entries.count(); i++) {
+        if (next < rows.count() && rows.at(next) == i) {
+            releaseDisplayName(m_entries.at(i));
+            m_garbage_length += m_entries.at(i).nameLength;
+            next++;
+            continue;
+        }
+        if (kept != i)
+            m_entries[kept] = m_entries.at(i);
+        kept++;
+    }
+    m_entries.resize(kept);
+
+    if (m_garbage_length > m_names.length()/2)
+        compactNames();
+    m_index_dirty = true;
+}
+
+void FileEntryStore::clear()
+{
+    m_entries.clear();
+    m_names.clear();
+    m_garbage_length = 0;
+    m_display_names.clear();
+    m_types.clear();
+    m_type_ids.clear();
+    rebuildIndex();
+}
+
+int FileEntryStore::indexOf(const QString &uri) const
+{
+    auto name = nameFromUri(uri);
+    if (name.isEmpty())
+        return -1;
+    return findName(name.constData(), name.length());
+}
+
+const QString FileEntryStore::uri(int row) const
+{
+    auto &entry = m_entries.at(row);
+    return m_parent_uri + QString::fromUtf8(m_names.constData() + entry.nameOffset, entry.nameLength);
+}
+
+static const QString decoded_name(const QByteArray &name, bool escaped)
+{
+    if (escaped)
+        return QUrl::fromPercentEncoding(name);
+    return QString::fromUtf8(name);
+}
+
+const QString FileEntryStore::displayName(int row) const
+{
+    auto &entry = m_entries.at(row);
+    if (entry.flags & FileEntry::HasDisplayName)
+        return m_display_names.value(entryName(entry));
+    return decoded_name(entryName(entry), entry.flags & FileEntry::IsEscaped);
+}
+
+const FileEntryType FileEntryStore::type(int row) const
+{
+    return m_types.value(m_entries.at(row).typeId);
+}
+
+const QByteArray FileEntryStore::nameFromUri(const QString &uri) const
+{
+    int length = uri.length();
+    if (length > 1 && uri.endsWith('/'))
+        length--;
+    int index = uri.lastIndexOf('/', length - 1);
+    if (index < 0)
+        return QByteArray();
+
+    //a child of other directory might have the same name, the parent might
+    //be escaped differently, see FileItemModel::uriKey().
+    auto parentUri = uri.left(index + 1);
+    if (parentUri != m_parent_uri) {
+        if (!parentUri.contains('%') && !m_parent_uri.contains('%'))
+            return QByteArray();
+        if (QUrl::fromPercentEncoding(parentUri.toUtf8()) != QUrl::fromPercentEncoding(m_parent_uri.toUtf8()))
+            return QByteArray();
+    }
+    return uri.midRef(index + 1, length - index - 1).toUtf8();
+}
+
+const QByteArray FileEntryStore::entryName(const FileEntry &entry) const
+{
+    return QByteArray::fromRawData(m_names.constData() + entry.nameOffset, entry.nameLength);
+}
+
+void FileEntryStore::fillEntry(FileEntry &entry, const std::shared_ptr<FileInfo> &info)
+{
+    //the name of entry is stored before filling.
+    releaseDisplayName(entry);
+    auto name = entryName(entry);
+
+    entry.flags = 0;
+    if (name.contains('%'))
+        entry.flags |= FileEntry::IsEscaped;
+    if (info->isDir())
+        entry.flags |= FileEntry::IsDir;
+    if (info->isVolume())
+        entry.flags |= FileEntry::IsVolume;
+    if (info->isSymbolLink())
+        entry.flags |= FileEntry::IsSymbolLink;
+    if (name.startsWith('.'))
+        entry.flags |= FileEntry::IsHidden;
+    if (info->canExecute())
+        entry.flags |= FileEntry::CanExecute;
+
+    auto displayName = info->displayName();
+    if (displayName != decoded_name(name, entry.flags & FileEntry::IsEscaped)) {
+        entry.flags |= FileEntry::HasDisplayName;
+        m_display_names.insert(QByteArray(name.constData(), name.length()), displayName);
+    }
+
+    entry.typeId = typeId(info->type(), info->iconName());
+    entry.size = info->size();
+    entry.modifiedTime = info->modifiedTime();
+}
+
+void FileEntryStore::releaseDisplayName(const FileEntry &entry)
+{
+    if (entry.flags & FileEntry::HasDisplayName)
+        m_display_names.remove(entryName(entry));
+}
+
+quint16 FileEntryStore::typeId(const QString &contentType, const QString &iconName)
+{
+    auto key = contentType + '\n' + iconName;
+    auto it = m_type_ids.constFind(key);
+    if (it != m_type_ids.constEnd())
+        return *it;
+
+    //the types are limited by the installed mime types and icons.
+    if (m_types.count() > 0xFFFF)
+        return 0;
+
+    FileEntryType type;
+    type.contentType = contentType;
+    type.iconName = iconName;
+    m_types.append(type);
+    quint16 id = m_types.count() - 1;
+    m_type_ids.insert(key, id);
+    return id;
+}
+
+int FileEntryStore::findName(const char *name, int length) const
+{
+    if (m_index_dirty)
+        rebuildIndex();
+
+    int mask = m_index.count() - 1;
+    int slot = qHashBits(name, length) & mask;
+    while (m_index.at(slot) != 0) {
+        //skip the tombstones.
+        int row = rowOfId(m_index.at(slot) - 1);
+        if (row >= 0) {
+            auto &entry = m_entries.at(row);
+            if (entry.nameLength == length && memcmp(m_names.constData() + entry.nameOffset, name, length) == 0)
+                return row;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return -1;
+}
+
+int FileEntryStore::rowOfId(int id) const
+{
+    auto it = std::lower_bound(m_removed_ids.constBegin(), m_removed_ids.constEnd(), id);
+    if (it != m_removed_ids.constEnd() && *it == id)
+        return -1;
+    return id - int(it - m_removed_ids.constBegin());
+}
+
+int FileEntryStore::idOfRow(int row) const
+{
+    int id = row;
+    for (int removedId : m_removed_ids) {
+        if (removedId > id)
+            break;
+        id++;
+    }
+    return id;
+}
+
+void FileEntryStore::insertIndex(int row)
+{
+    //keep the load factor under 3/4, the tombstones take slots too.
+    if (m_index_dirty || (m_entries.count() + m_removed_ids.count())*4 > m_index.count()*3) {
+        rebuildIndex();
+        return;
+    }
+
+    //the appended row is stored after all removed ones.
+    int id = row + m_removed_ids.count();
+    auto &entry = m_entries.at(row);
+    int mask = m_index.count() - 1;
+    int slot = qHashBits(m_names.constData() + entry.nameOffset, entry.nameLength) & mask;
+    while (m_index.at(slot) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    m_index[slot] = id + 1;
+}
+
+void FileEntryStore::rebuildIndex() const
+{
+    m_index_dirty = false;
+    m_removed_ids.clear();
+
+    int count = m_entries.count();
+    int capacity = qMax(64, int(qNextPowerOfTwo(quint32(count + count/2))));
+    m_index.fill(0, capacity);
+    m_index.squeeze();
+
+    int mask = capacity - 1;
+    for (int row = 0; row < count; row++) {
+        auto &entry = m_entries.at(row);
+        int slot = qHashBits(m_names.constData() + entry.nameOffset, entry.nameLength) & mask;
+        while (m_index.at(slot) != 0) {
+            slot = (slot + 1) & mask;
+        }
+        m_index[slot] = row + 1;
+    }
+}
+
+void FileEntryStore::compactNames()
+{
+    QByteArray names;
+    names.reserve(m_names.length() - m_garbage_length);
+    for (auto &entry : m_entries) {
+        quint32 offset = names.length();
+        names.append(m_names.constData() + entry.nameOffset, entry.nameLength);
+        entry.nameOffset = offset;
+    }
+    m_names = names;
+    m_garbage_length = 0;
+}
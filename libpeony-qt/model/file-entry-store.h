@@ -0,0 +1,216 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef FILEENTRYSTORE_H
+#define FILEENTRYSTORE_H
+
+#include "peony-core_global.h"
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+
+#include <memory>
+
+#define PEONY_FILE_ENTRY_STORE_THRESHOLD 50000
+#define PEONY_FILE_ENTRY_STORE_MAX_MATERIALIZED 4096
+/*!
+ * \brief PEONY_FILE_ENTRY_STORE_MAX_TOMBSTONES
+ * the minimal count of removed rows kept as tombstones in the name index
+ * before it is rebuilt, a huge store keeps up to 1/16 of its count.
+ */
+#define PEONY_FILE_ENTRY_STORE_MAX_TOMBSTONES 1024
+
+namespace Peony {
+
+class FileInfo;
+
+/*!
+ * \brief The FileEntry struct
+ * a compact record of a child in FileEntryStore, 32 bytes.
+ * the name is the last segment of child's uri stored in the name pool.
+ * the display name is only stored if it is not the decoded name.
+ */
+struct FileEntry
+{
+    enum Flag {
+        IsDir = 1,
+        IsVolume = 1 << 1,
+        IsSymbolLink = 1 << 2,
+        IsHidden = 1 << 3,
+        IsEscaped = 1 << 4,
+        HasDisplayName = 1 << 5,
+        CanExecute = 1 << 6
+    };
+
+    quint32 nameOffset;
+    quint16 nameLength;
+    quint16 typeId;
+    quint32 flags;
+    quint64 size;
+    quint64 modifiedTime;
+};
+
+/*!
+ * \brief The FileEntryType struct
+ * the attributes shared by the entries with the same content type and icon.
+ */
+struct FileEntryType
+{
+    QString contentType;
+    QString iconName;
+};
+
+/*!
+ * \brief The FileEntryStore class
+ * <br>
+ * FileEntryStore keeps the children of a huge directory in compact arrays
+ * instead of a FileItem and a FileInfo for each child. Every child costs
+ * a FileEntry, its name in the name pool and two slots of the name index,
+ * that is about 40 bytes plus the length of its name.
+ * </br>
+ * <br>
+ * The rows are in the order of appending. Looking up a child by uri uses
+ * an open addressing hash of the names, only the uris of direct children
+ * of the parent uri are found. Removing a few rows leaves tombstones in
+ * the hash, and the rows stored after them are shifted when they are looked
+ * up, so a burst of single removals does not rebuild it each time. Removing
+ * many rows marks the hash dirty, it is rebuilt once by the next lookup.
+ * </br>
+ * \note this class is not thread safe, it is used by FileItem in ui thread.
+ * \see FileItem::isVirtual(), FileItemModel::setVirtualThreshold().
+ */
+class PEONYCORESHARED_EXPORT FileEntryStore
+{
+public:
+    explicit FileEntryStore(const QString &parentUri);
+
+    int count() const {
+        return m_entries.count();
+    }
+
+    /*!
+     * \brief append
+     * \param info, a loaded info of a child.
+     * \return false if the child is existed.
+     */
+    bool append(const std::shared_ptr<FileInfo> &info);
+    void update(int row, const std::shared_ptr<FileInfo> &info);
+    /*!
+     * \brief remove
+     * \param row
+     * \param count
+     * remove a contiguous range of rows.
+     */
+    void remove(int row, int count = 1);
+    /*!
+     * \brief removeRows
+     * \param rows, sorted in ascending order.
+     * remove the rows in one pass.
+     */
+    void removeRows(const QVector<int> &rows);
+    void clear();
+
+    /*!
+     * \brief indexOf
+     * \param uri
+     * \return the row of child, or -1.
+     */
+    int indexOf(const QString &uri) const;
+
+    const QString uri(int row) const;
+    const QString displayName(int row) const;
+    const FileEntryType type(int row) const;
+    quint64 size(int row) const {
+        return m_entries.at(row).size;
+    }
+    quint64 modifiedTime(int row) const {
+        return m_entries.at(row).modifiedTime;
+    }
+    bool isDir(int row) const {
+        return m_entries.at(row).flags & (FileEntry::IsDir|FileEntry::IsVolume);
+    }
+    bool isSymbolLink(int row) const {
+        return m_entries.at(row).flags & FileEntry::IsSymbolLink;
+    }
+    bool isHidden(int row) const {
+        return m_entries.at(row).flags & FileEntry::IsHidden;
+    }
+    bool canExecute(int row) const {
+        return m_entries.at(row).flags & FileEntry::CanExecute;
+    }
+
+protected:
+    const QByteArray nameFromUri(const QString &uri) const;
+    const QByteArray entryName(const FileEntry &entry) const;
+    void fillEntry(FileEntry &entry, const std::shared_ptr<FileInfo> &info);
+    void releaseDisplayName(const FileEntry &entry);
+    quint16 typeId(const QString &contentType, const QString &iconName);
+    int findName(const char *name, int length) const;
+    /*!
+     * \brief rowOfId
+     * \param id, the row stored in the name index.
+     * \return the current row, or -1 if it is removed.
+     */
+    int rowOfId(int id) const;
+    int idOfRow(int row) const;
+    void insertIndex(int row);
+    void rebuildIndex() const;
+    void compactNames();
+
+private:
+    QString m_parent_uri;
+
+    QVector<FileEntry> m_entries;
+    QByteArray m_names;
+    int m_garbage_length = 0;
+
+    /*!
+     * \brief m_index
+     * open addressing hash of names, a slot is the stored row + 1, or 0 if empty.
+     * the stored row is the row when it was inserted, counting removed rows.
+     */
+    mutable QVector<quint32> m_index;
+    mutable bool m_index_dirty = false;
+    /*!
+     * \brief m_removed_ids
+     * the sorted stored rows removed since the index was built, their slots
+     * are tombstones.
+     */
+    mutable QVector<int> m_removed_ids;
+
+    /*!
+     * \brief m_display_names
+     * name -> display name, for the children whose display name is not their
+     * decoded name, such as the Name of a desktop file, or a name not in utf-8.
+     * there are only a few of them in a directory.
+     */
+    QHash<QByteArray, QString> m_display_names;
+
+    QVector<FileEntryType> m_types;
+    QHash<QString, quint16> m_type_ids;
+};
+
+}
+
+#endif // FILEENTRYSTORE_H
@@ -22,14 +22,17 @@
 
 #include "file-item-model.h"
 #include "file-item.h"
+#include "file-entry-store.h"
 #include "file-info.h"
 #include "file-info-job.h"
+#include "content-type-cache.h"
 
 #include "file-operation-manager.h"
 #include "file-move-operation.h"
 #include "file-copy-operation.h"
 
 #include "file-utils.h"
+#include "target-uri-resolver.h"
 
 #include "thumbnail-manager.h"
 
@@ -38,6 +41,7 @@
 #include <QIcon>
 #include <QMimeData>
 #include <QUrl>
+#include <QDateTime>
 
 #include <QTimer>
 
@@ -48,6 +52,7 @@ using namespace Peony;
 FileItemModel::FileItemModel(QObject *parent) : QAbstractItemModel (parent)
 {
     setPositiveResponse(true);
+    setVirtualThreshold(PEONY_FILE_ENTRY_STORE_THRESHOLD);
 }
 
 FileItemModel::~FileItemModel()
@@ -56,6 +61,12 @@ FileItemModel::~FileItemModel()
     disconnect();
     if (m_root_item)
         delete m_root_item;
+
+    //the items waiting for deleteLater() are deleted after m_items,
+    //they should not unregister themselves.
+    for (auto item : findChildren<FileItem*>(QString(), Qt::FindDirectChildrenOnly)) {
+        item->m_model = nullptr;
+    }
 }
 
 const QString FileItemModel::getRootUri()
@@ -83,6 +94,8 @@ void FileItemModel::setRootItem(FileItem *item)
 
     m_root_item = item;
     m_root_item->findChildrenAsync();
+    //warm the target uri of root for dropMimeData().
+    TargetUriResolver::getInstance()->resolveAsync(item->uri(), this, [](const QString &) {});
 
     endResetModel();
 }
@@ -91,84 +104,156 @@ QModelIndex FileItemModel::index(int row, int column, const QModelIndex &parent)
 {
     //root children
     if (!parent.isValid()) {
+        //virtual rows have no item.
+        if (auto store = m_root_item->m_store) {
+            if (row < 0 || row >= store->count())
+                return QModelIndex();
+            return createIndex(row, column, nullptr);
+        }
         if (row < 0 || row > m_root_item->m_children->count()-1)
             return QModelIndex();
         return createIndex(row, column, m_root_item->m_children->at(row));
     }
 
     FileItem *item = static_cast<FileItem*>(parent.internalPointer());
-    if (row < 0 || row > item->m_children->count()-1)
+    if (!item || row < 0 || row > item->m_children->count()-1)
         return QModelIndex();
     return createIndex(row, column, item->m_children->at(row));
 }
 
 FileItem *FileItemModel::itemFromIndex(const QModelIndex &index) const
 {
-    return static_cast<FileItem*>(index.internalPointer());
+    auto item = static_cast<FileItem*>(index.internalPointer());
+    if (!item && index.isValid() && m_root_item) {
+        //create the item of a virtual row on demand.
+        return m_root_item->materializeChild(index.row());
+    }
+    return item;
+}
+
+FileEntryStore *FileItemModel::entryStore(const QModelIndex &parent) const
+{
+    if (parent.isValid() || !m_root_item)
+        return nullptr;
+    return m_root_item->m_store;
 }
 
 QModelIndex FileItemModel::firstColumnIndex(FileItem *item)
 {
-    //root children
-    if (item->m_parent == nullptr) {
-        for (int i = 0; i < m_root_item->m_children->count(); i++) {
-            //qDebug()<<i<<item->m_info->uri()<<m_root_item->m_children->at(i)->m_info->uri();
-            if (item == m_root_item->m_children->at(i)) {
-                //qDebug()<<i<<item->m_info->uri();
-                return createIndex(i, 0, item);
-            }
-        }
-        return QModelIndex();
-    } else {
-        //has parent item
-        for (int i = 0; i < item->m_parent->m_children->count(); i++) {
-            if (item == item->m_parent->m_children->at(i))
-                return createIndex(i, 0, item);
-        }
-        return QModelIndex();
+    if (item->m_parent && item->m_parent->m_store) {
+        int row = item->m_parent->m_store->indexOf(item->uri());
+        return row < 0? QModelIndex(): createIndex(row, 0, nullptr);
     }
+
+    int row = rowOf(item);
+    return row < 0? QModelIndex(): createIndex(row, 0, item);
 }
 
 QModelIndex FileItemModel::lastColumnIndex(FileItem *item)
 {
-    if (!item->m_parent) {
-        for (int i = 0; i < m_root_item->m_children->count(); i++) {
-            //qDebug()<<i<<item->m_info->uri()<<m_root_item->m_children->at(i)->m_info->uri();
-            if (item == m_root_item->m_children->at(i)) {
-                //qDebug()<<i<<item->m_info->uri();
-                return createIndex(i, Other, item);
-            }
-        }
-        return QModelIndex();
-    } else {
-        //has parent item
-        for (int i = 0; i < item->m_parent->m_children->count(); i++) {
-            if (item == item->m_parent->m_children->at(i))
-                return createIndex(i, Other, item);
-        }
-        return QModelIndex();
+    if (item->m_parent && item->m_parent->m_store) {
+        int row = item->m_parent->m_store->indexOf(item->uri());
+        return row < 0? QModelIndex(): createIndex(row, Other, nullptr);
     }
+
+    int row = rowOf(item);
+    return row < 0? QModelIndex(): createIndex(row, Other, item);
+}
+
+void FileItemModel::setPinnedUris(QObject *owner, const QSet<QString> &uris)
+{
+    if (!m_pinned_uris.contains(owner)) {
+        connect(owner, &QObject::destroyed, this, [=]() {
+            m_pinned_uris.remove(owner);
+        });
+    }
+    m_pinned_uris.insert(owner, uris);
+}
+
+bool FileItemModel::isPinned(const QString &uri) const
+{
+    for (auto &uris : m_pinned_uris) {
+        if (uris.contains(uri))
+            return true;
+    }
+    return false;
+}
+
+int FileItemModel::rowOf(FileItem *item) const
+{
+    //the root item has no row.
+    auto parentItem = item->m_parent;
+    if (!parentItem)
+        return -1;
+
+    auto children = parentItem->m_children;
+    int row = item->m_row;
+    if (row >= 0 && row < children->count() && children->at(row) == item)
+        return row;
+
+    //appended item.
+    if (!children->isEmpty() && children->last() == item) {
+        item->m_row = children->count() - 1;
+        return item->m_row;
+    }
+
+    //the rows moved, refresh all of them.
+    item->m_row = -1;
+    for (int i = 0; i < children->count(); i++) {
+        children->at(i)->m_row = i;
+    }
+    return item->m_row;
+}
+
+const QString FileItemModel::uriKey(const QString &uri)
+{
+    //avoid parsing the uri with QUrl, this is called for every watcher event.
+    QString key = uri.contains('%')? QUrl::fromPercentEncoding(uri.toUtf8()): uri;
+    //keep the slash of "file:///".
+    if (key.size() > 1 && key.endsWith('/') && key.at(key.size() - 2) != '/')
+        key.chop(1);
+    return key;
+}
+
+void FileItemModel::registerItem(FileItem *item)
+{
+    m_items.insert(item->m_uri_key, item);
+}
+
+void FileItemModel::unregisterItem(FileItem *item)
+{
+    auto it = m_items.find(item->m_uri_key);
+    if (it != m_items.end() && it.value() == item)
+        m_items.erase(it);
 }
 
 const QModelIndex FileItemModel::indexFromUri(const QString &uri)
 {
-    //FIXME: support recursively finding?
-    for (auto child : *m_root_item->m_children) {
-        GFile *left = g_file_new_for_uri(child->uri().toUtf8().constData());
-        GFile *right = g_file_new_for_uri(uri.toUtf8().constData());
-        bool equal = g_file_equal(left, right);
-        g_object_unref(left);
-        g_object_unref(right);
-        if (equal) {
-            return child->firstColumnIndex();
-        }
+    if (auto store = m_root_item->m_store) {
+        int row = store->indexOf(uri);
+        return row < 0? QModelIndex(): createIndex(row, 0, nullptr);
     }
-    return QModelIndex();
+
+    auto item = m_items.value(uriKey(uri));
+    if (!item)
+        return QModelIndex();
+
+    //the items of previous root might not be deleted yet.
+    auto ancestor = item->m_parent;
+    while (ancestor && ancestor != m_root_item) {
+        ancestor = ancestor->m_parent;
+    }
+    if (!ancestor)
+        return QModelIndex();
+    return item->firstColumnIndex();
 }
 
 QModelIndex FileItemModel::parent(const QModelIndex &child) const
 {
     FileItem *childItem = static_cast<FileItem*>(child.internalPointer());
+    //virtual rows are root children.
+    if (!childItem)
+        return QModelIndex();
     //root children
     if (childItem->m_parent == nullptr)
         return QModelIndex();
@@ -187,9 +272,13 @@ int FileItemModel::rowCount(const QModelIndex &parent) const
         if (!m_root_item) {
             return 0;
         }
+        if (m_root_item->m_store)
+            return m_root_item->m_store->count();
         return m_root_item->m_children->count();
     }
     FileItem *parent_item = static_cast<FileItem*>(parent.internalPointer());
+    if (!parent_item)
+        return 0;
     return parent_item->m_children->count();
 }
 
@@ -200,6 +289,9 @@ QVariant FileItemModel::data(const QModelIndex &index, int role) const
     }
 
     FileItem *item = static_cast<FileItem*>(index.internalPointer());
+    if (!item) {
+        return entryData(m_root_item->m_store, index, role);
+    }
 
     // we have to add uri role to every valid index, so that we can ensure
     // that we can open the file/directory correctly.
@@ -279,6 +371,62 @@ QVariant FileItemModel::data(const QModelIndex &index, int role) const
     }
 }
 
+QVariant FileItemModel::entryData(FileEntryStore *store, const QModelIndex &index, int role) const
+{
+    int row = index.row();
+    if (!store || row >= store->count())
+        return QVariant();
+
+    if (role == FileItemModel::UriRole)
+        return QVariant(store->uri(row));
+
+    switch (index.column()) {
+    case FileName: {
+        switch (role) {
+        case Qt::TextAlignmentRole:
+            return QVariant(Qt::AlignHCenter | Qt::AlignBaseline);
+        case Qt::DisplayRole:
+        case Qt::ToolTipRole:
+            return QVariant(store->displayName(row));
+        case Qt::DecorationRole: {
+            auto uri = store->uri(row);
+            auto thumbnail = ThumbnailManager::getInstance()->tryGetThumbnail(uri);
+            //an untrusted desktop file does not show its own icon, as FileItem does.
+            if (!thumbnail.isNull() && !(uri.endsWith(".desktop") && !store->canExecute(row)))
+                return thumbnail;
+            return QIcon::fromTheme(store->type(row).iconName, QIcon::fromTheme("text-x-generic"));
+        }
+        default:
+            return QVariant();
+        }
+    }
+    case ModifiedDate: {
+        if (role != Qt::DisplayRole)
+            return QVariant();
+        QDateTime date = QDateTime::fromMSecsSinceEpoch(store->modifiedTime(row)*1000);
+        return QVariant(date.toString(Qt::SystemLocaleShortDate));
+    }
+    case FileType: {
+        if (role != Qt::DisplayRole)
+            return QVariant();
+        auto fileType = ContentTypeCache::getInstance()->description(store->type(row).contentType);
+        if (store->isSymbolLink(row))
+            return QVariant(tr("Symbol Link, ") + fileType);
+        return QVariant(fileType);
+    }
+    case FileSize: {
+        if (role != Qt::DisplayRole || store->isDir(row))
+            return QVariant();
+        char *size_full = g_format_size_full(store->size(row), G_FORMAT_SIZE_DEFAULT);
+        QString fileSize = size_full;
+        g_free(size_full);
+        return QVariant(fileSize);
+    }
+    default:
+        return QVariant();
+    }
+}
+
 QVariant FileItemModel::headerData(int section, Qt::Orientation orientation, int role) const
 {
     if (orientation == Qt::Vertical)
@@ -306,6 +454,9 @@ bool FileItemModel::hasChildren(const QModelIndex &parent) const
     if (!parent.isValid())
         return true;
     FileItem *parent_item = static_cast<FileItem*>(parent.internalPointer());
+    //virtual rows can not be expanded.
+    if (!parent_item)
+        return false;
     if (parent_item->hasChildren() && m_can_expand)
         return true;
     return false;
@@ -316,8 +467,9 @@ Qt::ItemFlags FileItemModel::flags(const QModelIndex &index) const
     if (index.isValid()) {
         Qt::ItemFlags flags = QAbstractItemModel::flags(index);
 
-        auto item = itemFromIndex(index);
-        if (item->m_info->isDir()) {
+        auto item = static_cast<FileItem*>(index.internalPointer());
+        bool isDir = item? item->m_info->isDir(): m_root_item->m_store->isDir(index.row());
+        if (isDir) {
             flags |= Qt::ItemIsDropEnabled;
         }
         if (index.column() == FileName) {
@@ -336,6 +488,8 @@ bool FileItemModel::canFetchMore(const QModelIndex &parent) const
     if (!parent.isValid())
         return true;
     FileItem *parent_item = static_cast<FileItem*>(parent.internalPointer());
+    if (!parent_item)
+        return false;
     if (!parent_item->m_expanded) {
         return true;
     }
@@ -431,8 +585,8 @@ QMimeData *FileItemModel::mimeData(const QModelIndexList &indexes) const
     //set urls data URLs correspond to the MIME type text/uri-list.
     QList<QUrl> urls;
     for (auto index : indexes) {
-        auto item = itemFromIndex(index);
-        QUrl url = item->m_info->uri();
+        //do not create items for virtual rows.
+        QUrl url = this->data(index, UriRole).toString();
         if (!urls.contains(url))
             urls<<url;
     }
@@ -472,8 +626,11 @@ bool FileItemModel::dropMimeData(const QMimeData *data, Qt::DropAction action, i
         //we have to set the dest dir uri as its mount point.
         //maybe i should do this when set model root item.
         destDirUri = m_root_item->m_info->uri();
-        //FIXME: replace BLOCKING api in ui thread.
-        auto targetUri = FileUtils::getTargetUri(destDirUri);
+        //the target uri of root is resolved when root set, only query it
+        //here if that has not finished.
+        QString targetUri;
+        if (!TargetUriResolver::getInstance()->lookup(destDirUri, targetUri))
+            targetUri = FileUtils::getTargetUri(destDirUri);
         if (!targetUri.isEmpty()) {
             destDirUri = targetUri;
         }
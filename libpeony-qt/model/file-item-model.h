@@ -24,12 +24,15 @@
 #define FILEITEMMODEL_H
 
 #include <QAbstractItemModel>
+#include <QHash>
+#include <QSet>
 #include "peony-core_global.h"
 
 namespace Peony {
 
 class FileItem;
 class FileItemProxyFilterSortModel;
+class FileEntryStore;
 
 /*!
  * \brief The FileItemModel class
@@ -105,6 +108,36 @@ public:
         return  m_can_expand;
     }
 
+    /*!
+     * \brief setVirtualThreshold
+     * \param threshold, a negative value disables virtual items.
+     * <br>
+     * If the root item finds more children than threshold, and the model can not
+     * expand children, the children are kept in a compact FileEntryStore rather
+     * than FileItems. The indexes of these rows have no internal pointer, the data
+     * is read from the store. itemFromIndex() still returns a FileItem for them,
+     * which is created on demand, so the views work as usual.
+     * </br>
+     * \see FileItem::isVirtual().
+     */
+    void setVirtualThreshold(int threshold) {
+        m_virtual_threshold = threshold;
+    }
+    int virtualThreshold() {
+        return m_virtual_threshold;
+    }
+
+    /*!
+     * \brief setPinnedUris
+     * \param owner, the selection model of a view.
+     * \param uris, the selected and current children in the view.
+     * the items of pinned children are not released when a virtual item
+     * releases its least recently used materialized children.
+     * \see FileItem::materializeChild(), FileItemProxyFilterSortModel::pinSelection().
+     */
+    void setPinnedUris(QObject *owner, const QSet<QString> &uris);
+    bool isPinned(const QString &uri) const;
+
     const QString getRootUri();
     void setRootUri(const QString &uri);
     /*!
@@ -140,8 +173,22 @@ public:
      */
     QModelIndex lastColumnIndex(FileItem *item);
 
+    /*!
+     * \brief indexFromUri
+     * \param uri
+     * \return the first column index of the item which has the uri.
+     * \note the items are looked up in a hash keyed by uriKey(), and the rows are
+     * cached in items, so this function does not scan the children.
+     */
     const QModelIndex indexFromUri(const QString &uri);
 
+    /*!
+     * \brief uriKey
+     * \param uri
+     * \return the normalized uri, percent encoding and trailing slash do not matter.
+     */
+    static const QString uriKey(const QString &uri);
+
     QModelIndex index(int row, int column, const QModelIndex &parent) const override;
     QModelIndex parent(const QModelIndex &child) const override;
 
@@ -262,10 +309,39 @@ public Q_SLOTS:
 
     void setRootIndex(const QModelIndex &index);
 
+protected:
+    /*!
+     * \brief entryStore
+     * \param parent
+     * \return the store of parent's children if they are virtual, or nullptr.
+     */
+    FileEntryStore *entryStore(const QModelIndex &parent) const;
+    QVariant entryData(FileEntryStore *store, const QModelIndex &index, int role) const;
+
+    /*!
+     * \brief rowOf
+     * \param item
+     * \return the row of item in its parent's children, or -1.
+     * \note each item caches its row, a stale cache refreshes all rows of the parent
+     * at once, so the lookups after inserting or removing a batch of rows are still O(1).
+     */
+    int rowOf(FileItem *item) const;
+
+    void registerItem(FileItem *item);
+    void unregisterItem(FileItem *item);
+
 private:
     FileItem *m_root_item = nullptr;
     bool m_is_positive = false;
     bool m_can_expand = false;
+    int m_virtual_threshold = -1;
+
+    /*!
+     * \brief m_items
+     * all the alive items of this model, keyed by uriKey().
+     */
+    QHash<QString, FileItem*> m_items;
+    QHash<QObject*, QSet<QString>> m_pinned_uris;
 };
 
 }
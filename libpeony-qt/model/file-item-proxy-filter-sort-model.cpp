@@ -23,6 +23,7 @@
 
 #include "file-item-model.h"
 #include "file-item.h"
+#include "file-entry-store.h"
 #include "file-item-proxy-filter-sort-model.h"
 #include "file-info.h"
 #include "file-meta-info.h"
@@ -30,6 +31,7 @@
 
 #include "file-utils.h"
 #include "file-operation-utils.h"
+#include "content-type-cache.h"
 
 #include "global-settings.h"
 
@@ -39,29 +41,381 @@
 
 #include <QLocale>
 #include <QCollator>
+#include <QThread>
+#include <QtConcurrent>
+#include <QCoreApplication>
+#include <QEvent>
+#include <QTimer>
+
+#include <algorithm>
+#include <iterator>
+#include <numeric>
 
 using namespace Peony;
 
 QLocale locale = QLocale(QLocale::system().name());
 QCollator comparer = QCollator(locale);
+static int sort_key_generation = 0;
+
+/*!
+ * \brief fill_sort_key
+ * fill the name keys of key, the folder flag is not changed.
+ * \note this is called in the threads of sort job, do not use shared objects here.
+ */
+static void fill_sort_key(FileSortKey *key, const QString &displayName)
+{
+    key->displayName = displayName;
+    key->lowerName = displayName.toLower();
+
+    //remove every "(n)" of the name, and record the number of last one,
+    //see FileOperationUtils::leftNameIsDuplicatedFileOfRightName().
+    key->duplicateBaseName.clear();
+    key->duplicateBaseName.reserve(displayName.size());
+    key->duplicateNumber = 0;
+    int i = 0;
+    int length = displayName.size();
+    while (i < length) {
+        if (displayName.at(i) == '(') {
+            int j = i + 1;
+            while (j < length && displayName.at(j).isDigit())
+                j++;
+            if (j > i + 1 && j < length && displayName.at(j) == ')') {
+                key->duplicateNumber = displayName.midRef(i + 1, j - i - 1).toInt();
+                i = j + 1;
+                continue;
+            }
+        }
+        key->duplicateBaseName.append(displayName.at(i));
+        i++;
+    }
+}
+
+/*!
+ * \brief The SortEntry struct
+ * the copied sort keys of a root row, used by the sort job.
+ */
+struct SortEntry {
+    FileSortKey key;
+    bool hasKey = false;
+    quint64 size = 0;
+    quint64 modifiedTime = 0;
+    QString fileType;
+};
+
+typedef QPair<int, int> SortRange;
+
+struct MergeRange {
+    int first;
+    int middle;
+    int last;
+};
+
+/*!
+ * \brief parallel_stable_sort
+ * sort the chunks of indexes in thread pool, then merge them pairwise.
+ * \return false if it is cancelled.
+ */
+template <typename LessThan>
+static bool parallel_stable_sort(QVector<int> &indexes, LessThan lessThan, const std::function<bool()> &isCancelled)
+{
+    int count = indexes.count();
+    int chunks = qBound(1, QThread::idealThreadCount(), qMax(1, count/PEONY_PARALLEL_SORT_MIN_CHUNK));
+    int *data = indexes.data();
+
+    QVector<SortRange> ranges;
+    for (int i = 0; i < chunks; i++) {
+        ranges<<SortRange(int(qint64(count)*i/chunks), int(qint64(count)*(i + 1)/chunks));
+    }
+    QtConcurrent::blockingMap(ranges, [=](SortRange &range) {
+        std::stable_sort(data + range.first, data + range.second, lessThan);
+    });
+
+    while (ranges.count() > 1) {
+        if (isCancelled())
+            return false;
+        QVector<SortRange> mergedRanges;
+        QVector<MergeRange> merges;
+        for (int i = 0; i + 1 < ranges.count(); i += 2) {
+            merges<<MergeRange{ranges.at(i).first, ranges.at(i).second, ranges.at(i + 1).second};
+            mergedRanges<<SortRange(ranges.at(i).first, ranges.at(i + 1).second);
+        }
+        if (ranges.count()%2 == 1)
+            mergedRanges<<ranges.last();
+        QtConcurrent::blockingMap(merges, [=](MergeRange &merge) {
+            std::inplace_merge(data + merge.first, data + merge.middle, data + merge.last, lessThan);
+        });
+        ranges = mergedRanges;
+    }
+    return !isCancelled();
+}
 
 FileItemProxyFilterSortModel::FileItemProxyFilterSortModel(QObject *parent) : QSortFilterProxyModel(parent)
 {
+    m_sort_generation = std::make_shared<QAtomicInt>(0);
     //enable number sort, like 100 is after 99
     comparer.setNumericMode(true);
     auto settings = GlobalSettings::getInstance();
     m_show_hidden = settings->isExist("show-hidden")? settings->getValue("show-hidden").toBool(): false;
     m_use_default_name_sort_order = settings->isExist("chinese-first")? settings->getValue("chinese-first").toBool(): false;
     m_folder_first = settings->isExist("folder-first")? settings->getValue("folder-first").toBool(): true;
+
+    //the collator and the cached sort keys are bound to the system locale.
+    qApp->installEventFilter(this);
+
+    //the label filter conditions are resolved to ids, resolve them again when
+    //the labels are changed.
+    auto labelModel = FileLabelModel::getGlobalModel();
+    auto labelsChanged = [=]() {
+        updateLabelFilterIds();
+        if (m_label_name != "" || m_label_color != Qt::transparent || !m_show_label_names.isEmpty() || !m_show_label_colors.isEmpty())
+            invalidateFilter();
+    };
+    connect(labelModel, &QAbstractItemModel::modelReset, this, labelsChanged);
+    connect(labelModel, &QAbstractItemModel::dataChanged, this, labelsChanged);
+}
+
+FileItemProxyFilterSortModel::~FileItemProxyFilterSortModel()
+{
+    cancelSortJob();
+    m_sort_future.waitForFinished();
 }
 
 void FileItemProxyFilterSortModel::setSourceModel(QAbstractItemModel *model)
 {
-    if (sourceModel())
+    if (sourceModel()) {
         disconnect(sourceModel());
-    QSortFilterProxyModel::setSourceModel(model);
+        sourceModel()->disconnect(this);
+    }
+    cancelSortJob();
     FileItemModel *file_item_model = static_cast<FileItemModel*>(model);
+    QSortFilterProxyModel::setSourceModel(model);
     connect(file_item_model, &FileItemModel::updated, this, &FileItemProxyFilterSortModel::update);
+
+    //the sort result is bound to the source rows, the appended root rows
+    //are placed into it when it is applied.
+    auto increaseRevision = [=]() {
+        m_source_revision++;
+    };
+    connect(file_item_model, &QAbstractItemModel::rowsInserted, this, [=](const QModelIndex &parent, int, int last) {
+        if (!parent.isValid() && last == sourceModel()->rowCount() - 1)
+            return;
+        m_source_revision++;
+    });
+    connect(file_item_model, &QAbstractItemModel::rowsRemoved, this, increaseRevision);
+    connect(file_item_model, &QAbstractItemModel::rowsMoved, this, increaseRevision);
+    connect(file_item_model, &QAbstractItemModel::modelReset, this, increaseRevision);
+    connect(file_item_model, &QAbstractItemModel::layoutChanged, this, increaseRevision);
+}
+
+void FileItemProxyFilterSortModel::sort(int column, Qt::SortOrder order)
+{
+    if (column < 0 || !sortsAsynchronously()) {
+        cancelSortJob();
+        QSortFilterProxyModel::sort(column, order);
+        return;
+    }
+
+    bool pending = m_pending_sort_column >= 0;
+    if (pending && column == m_pending_sort_column && order == m_pending_sort_order)
+        return;
+    //same as QSortFilterProxyModel::sort(), the rows are kept sorted dynamically.
+    if (!pending && column == sortColumn() && order == sortOrder() && dynamicSortFilter())
+        return;
+
+    //the rows keep their current order with current sort column until
+    //the result is applied, see applySortRanks().
+    startSortJob(column, order);
+}
+
+bool FileItemProxyFilterSortModel::sortsAsynchronously() const
+{
+    return sourceModel() && sourceModel()->rowCount() >= PEONY_ASYNC_SORT_THRESHOLD;
+}
+
+void FileItemProxyFilterSortModel::cancelSortJob()
+{
+    m_sort_generation->fetchAndAddOrdered(1);
+    m_pending_sort_column = -1;
+}
+
+void FileItemProxyFilterSortModel::startSortJob(int column, Qt::SortOrder order)
+{
+    int generation = m_sort_generation->fetchAndAddOrdered(1) + 1;
+    int revision = m_source_revision;
+    m_pending_sort_column = column;
+    m_pending_sort_order = order;
+
+    //copy the sort keys in ui thread, items and store are not thread safe.
+    FileItemModel *model = static_cast<FileItemModel*>(sourceModel());
+    auto store = model->entryStore(QModelIndex());
+    int count = model->rowCount();
+    auto entries = std::make_shared<QVector<SortEntry>>(count);
+    for (int row = 0; row < count; row++) {
+        auto &entry = (*entries)[row];
+        if (store) {
+            //virtual rows have no cached keys, they are built in sort job.
+            entry.key.isDir = store->isDir(row);
+            entry.key.displayName = store->displayName(row);
+            entry.size = store->size(row);
+            entry.modifiedTime = store->modifiedTime(row);
+            if (column == FileItemModel::FileType)
+                entry.fileType = ContentTypeCache::getInstance()->description(store->type(row).contentType);
+            continue;
+        }
+        auto item = model->m_root_item->m_children->at(row);
+        entry.key = *sortKey(item);
+        entry.hasKey = true;
+        entry.size = item->m_info->size();
+        entry.modifiedTime = item->m_info->modifiedTime();
+        if (column == FileItemModel::FileType)
+            entry.fileType = item->m_info->fileType();
+    }
+
+    auto currentGeneration = m_sort_generation;
+    bool folderFirst = m_folder_first;
+    bool useCollator = m_use_default_name_sort_order && column == FileItemModel::FileName;
+    QLocale sortLocale = locale;
+
+    m_sort_future = QtConcurrent::run([=]() {
+        auto isCancelled = [=]() {
+            return currentGeneration->load() != generation;
+        };
+        auto &sortEntries = *entries;
+
+        //build the missing keys, each chunk uses its own collator.
+        int chunks = qBound(1, QThread::idealThreadCount(), qMax(1, count/PEONY_PARALLEL_SORT_MIN_CHUNK));
+        QVector<SortRange> ranges;
+        for (int i = 0; i < chunks; i++) {
+            ranges<<SortRange(int(qint64(count)*i/chunks), int(qint64(count)*(i + 1)/chunks));
+        }
+        QtConcurrent::blockingMap(ranges, [&](SortRange &range) {
+            QCollator collator(sortLocale);
+            collator.setNumericMode(true);
+            for (int i = range.first; i < range.second; i++) {
+                auto &key = sortEntries[i].key;
+                if (!sortEntries.at(i).hasKey)
+                    fill_sort_key(&key, key.displayName);
+                if (useCollator && !key.collatorKey)
+                    key.collatorKey = std::make_shared<QCollatorSortKey>(collator.sortKey(key.displayName));
+            }
+        });
+        if (isCancelled())
+            return;
+
+        //same order as lessThan().
+        auto lessThan = [&](int leftRow, int rightRow) {
+            auto &left = sortEntries.at(leftRow);
+            auto &right = sortEntries.at(rightRow);
+            if (left.key.isDir != right.key.isDir && folderFirst) {
+                return order == Qt::AscendingOrder? left.key.isDir: right.key.isDir;
+            }
+            switch (column) {
+            case FileItemModel::FileName: {
+                if (left.key.duplicateBaseName == right.key.duplicateBaseName) {
+                    if (left.key.duplicateNumber == right.key.duplicateNumber)
+                        return left.key.displayName < right.key.displayName;
+                    return left.key.duplicateNumber < right.key.duplicateNumber;
+                }
+                if (useCollator)
+                    return left.key.collatorKey->compare(*right.key.collatorKey) < 0;
+                return left.key.lowerName < right.key.lowerName;
+            }
+            case FileItemModel::FileSize:
+                return left.size < right.size;
+            case FileItemModel::FileType:
+                return left.fileType < right.fileType;
+            case FileItemModel::ModifiedDate:
+                return left.modifiedTime < right.modifiedTime;
+            default:
+                return leftRow < rightRow;
+            }
+        };
+
+        QVector<int> indexes(count);
+        std::iota(indexes.begin(), indexes.end(), 0);
+        if (!parallel_stable_sort(indexes, lessThan, isCancelled))
+            return;
+
+        QVector<int> ranks(count);
+        for (int i = 0; i < count; i++) {
+            ranks[indexes.at(i)] = i;
+        }
+        QTimer::singleShot(0, this, [=]() {
+            applySortRanks(generation, revision, column, order, ranks);
+        });
+    });
+}
+
+void FileItemProxyFilterSortModel::applySortRanks(int generation, int revision, int column, Qt::SortOrder order, const QVector<int> &ranks)
+{
+    if (m_sort_generation->load() != generation)
+        return;
+    m_pending_sort_column = -1;
+
+    //the source rows changed while sorting, sort them again.
+    if (revision != m_source_revision) {
+        if (sortsAsynchronously())
+            startSortJob(column, order);
+        else
+            QSortFilterProxyModel::sort(column, order);
+        return;
+    }
+
+    //QSortFilterProxyModel does not let its mapping be replaced, so the ranks
+    //are applied by its own sort in one layout change. lessThan() only compares
+    //two ints then, the files are not compared again and the rows are not
+    //filtered again, see the sort benchmark of model-test for the cost.
+    m_sort_ranks = ranks;
+    if (sourceModel()->rowCount() > ranks.count())
+        m_sort_ranks = placeAppendedRows(column, order, ranks);
+    if (column != sortColumn() || order != sortOrder()) {
+        QSortFilterProxyModel::sort(column, order);
+    } else {
+        //sort() returns at once with same column and order, and invalidate()
+        //filters all rows again. lessThan() does not use the sort role, switching
+        //it only sorts the mapped rows again.
+        setSortRole(sortRole() == Qt::DisplayRole? Qt::EditRole: Qt::DisplayRole);
+    }
+    //make sure the root mapping is created while ranks are valid.
+    rowCount();
+    m_sort_ranks.clear();
+}
+
+QVector<int> FileItemProxyFilterSortModel::placeAppendedRows(int column, Qt::SortOrder order, const QVector<int> &ranks) const
+{
+    auto model = sourceModel();
+    int count = model->rowCount();
+    QVector<int> sortedRows(ranks.count());
+    for (int row = 0; row < ranks.count(); row++) {
+        sortedRows[ranks.at(row)] = row;
+    }
+
+    auto lessThanRows = [=](int leftRow, int rightRow) {
+        return lessThanColumn(model->index(leftRow, column), model->index(rightRow, column), column, order);
+    };
+    QVector<int> appendedRows;
+    for (int row = ranks.count(); row < count; row++) {
+        appendedRows<<row;
+    }
+    std::stable_sort(appendedRows.begin(), appendedRows.end(), lessThanRows);
+
+    //binary search the position of each appended row after the previous one.
+    QVector<int> mergedRows;
+    mergedRows.reserve(count);
+    auto first = sortedRows.constBegin();
+    for (auto row : appendedRows) {
+        auto position = std::upper_bound(first, sortedRows.constEnd(), row, lessThanRows);
+        std::copy(first, position, std::back_inserter(mergedRows));
+        mergedRows<<row;
+        first = position;
+    }
+    std::copy(first, sortedRows.constEnd(), std::back_inserter(mergedRows));
+
+    QVector<int> mergedRanks(count);
+    for (int i = 0; i < count; i++) {
+        mergedRanks[mergedRows.at(i)] = i;
+    }
+    return mergedRanks;
 }
 
 FileItem *FileItemProxyFilterSortModel::itemFromIndex(const QModelIndex &proxyIndex)
@@ -71,6 +425,28 @@ FileItem *FileItemProxyFilterSortModel::itemFromIndex(const QModelIndex &proxyIn
     return model->itemFromIndex(index);
 }
 
+void FileItemProxyFilterSortModel::pinSelection(QItemSelectionModel *selectionModel)
+{
+    auto updatePinnedUris = [=]() {
+        auto model = static_cast<FileItemModel*>(sourceModel());
+        if (!model)
+            return;
+        QSet<QString> uris;
+        //only the children of a virtual root are released.
+        if (model->entryStore(QModelIndex())) {
+            for (auto index : selectionModel->selectedRows()) {
+                uris<<index.data(FileItemModel::UriRole).toString();
+            }
+            auto current = selectionModel->currentIndex();
+            if (current.isValid())
+                uris<<current.data(FileItemModel::UriRole).toString();
+        }
+        model->setPinnedUris(selectionModel, uris);
+    };
+    connect(selectionModel, &QItemSelectionModel::selectionChanged, this, updatePinnedUris);
+    connect(selectionModel, &QItemSelectionModel::currentChanged, this, updatePinnedUris);
+}
+
 QModelIndex FileItemProxyFilterSortModel::getSourceIndex(const QModelIndex &proxyIndex)
 {
     return mapToSource(proxyIndex);
@@ -99,35 +475,47 @@ bool FileItemProxyFilterSortModel::lessThan(const QModelIndex &left, const QMode
 //    }
 
     //qDebug()<<left<<right;
+    //the root rows are ranked by sort job.
+    if (!m_sort_ranks.isEmpty() && !left.parent().isValid()) {
+        int leftRow = left.row();
+        int rightRow = right.row();
+        if (leftRow < m_sort_ranks.count() && rightRow < m_sort_ranks.count())
+            return m_sort_ranks.at(leftRow) < m_sort_ranks.at(rightRow);
+    }
+
+    return lessThanColumn(left, right, sortColumn(), sortOrder());
+}
+
+bool FileItemProxyFilterSortModel::lessThanColumn(const QModelIndex &left, const QModelIndex &right, int column, Qt::SortOrder order) const
+{
     if (left.isValid() && right.isValid()) {
         FileItemModel *model = static_cast<FileItemModel*>(sourceModel());
+        //virtual rows, compare them without creating items.
+        if (!left.internalPointer() || !right.internalPointer()) {
+            if (auto store = model->entryStore(left.parent()))
+                return lessThanEntries(store, left.row(), right.row(), column, order);
+        }
         auto leftItem = model->itemFromIndex(left);
         auto rightItem = model->itemFromIndex(right);
-        if (!(leftItem->hasChildren() && rightItem->hasChildren())) {
+        auto leftKey = sortKey(leftItem);
+        auto rightKey = sortKey(rightItem);
+        if (!(leftKey->isDir && rightKey->isDir)) {
             //make folder always has a higher order.
-            if (!leftItem->hasChildren() && !rightItem->hasChildren()) {
+            if (!leftKey->isDir && !rightKey->isDir) {
                 goto default_sort;
             }
             if (m_folder_first) {
-                bool lesser = leftItem->hasChildren();
-                if (sortOrder() == Qt::AscendingOrder)
+                bool lesser = leftKey->isDir;
+                if (order == Qt::AscendingOrder)
                     return lesser;
                 return !lesser;
             }
         }
 
 default_sort:
-        switch (sortColumn()) {
+        switch (column) {
         case FileItemModel::FileName: {
-            if (FileOperationUtils::leftNameIsDuplicatedFileOfRightName(leftItem->m_info->displayName(), rightItem->m_info->displayName())) {
-                return FileOperationUtils::leftNameLesserThanRightName(leftItem->info()->displayName(), rightItem->info()->displayName());
-            }
-            if (m_use_default_name_sort_order) {
-                QString leftDisplayName = leftItem->m_info->displayName();
-                QString rightDisplayName = rightItem->m_info->displayName();
-                return comparer.compare(leftDisplayName, rightDisplayName) < 0;
-            }
-            return leftItem->m_info->displayName().toLower() < rightItem->m_info->displayName().toLower();
+            return lessThanNames(leftKey, rightKey);
         }
         case FileItemModel::FileSize: {
             return leftItem->m_info->size() < rightItem->m_info->size();
@@ -143,7 +531,116 @@ default_sort:
         }
     }
 
-    return QSortFilterProxyModel::lessThan(left, right);
+    //same as QSortFilterProxyModel::lessThan() with display role, the sort
+    //role is switched by applySortRanks().
+    return left.data(Qt::DisplayRole).toString() < right.data(Qt::DisplayRole).toString();
+}
+
+FileSortKey *FileItemProxyFilterSortModel::sortKey(FileItem *item) const
+{
+    auto &key = item->m_sort_key;
+    auto displayName = item->m_info->displayName();
+    if (key && key->generation == sort_key_generation && key->displayName == displayName)
+        return key.get();
+
+    key = std::make_shared<FileSortKey>();
+    key->generation = sort_key_generation;
+    key->isDir = item->hasChildren();
+    fill_sort_key(key.get(), displayName);
+    return key.get();
+}
+
+void FileItemProxyFilterSortModel::invalidateSortKeys()
+{
+    locale = QLocale(QLocale::system().name());
+    comparer = QCollator(locale);
+    comparer.setNumericMode(true);
+    sort_key_generation++;
+}
+
+bool FileItemProxyFilterSortModel::lessThanNames(FileSortKey *left, FileSortKey *right) const
+{
+    //same as FileOperationUtils::leftNameIsDuplicatedFileOfRightName()
+    //and FileOperationUtils::leftNameLesserThanRightName(), with cached keys.
+    if (left->duplicateBaseName == right->duplicateBaseName) {
+        if (left->duplicateNumber == right->duplicateNumber)
+            return left->displayName < right->displayName;
+        return left->duplicateNumber < right->duplicateNumber;
+    }
+    if (m_use_default_name_sort_order) {
+        //the temporary keys of virtual rows are compared once, do not build collator keys for them.
+        if (left->generation < 0 || right->generation < 0)
+            return comparer.compare(left->displayName, right->displayName) < 0;
+        if (!left->collatorKey)
+            left->collatorKey = std::make_shared<QCollatorSortKey>(comparer.sortKey(left->displayName));
+        if (!right->collatorKey)
+            right->collatorKey = std::make_shared<QCollatorSortKey>(comparer.sortKey(right->displayName));
+        return left->collatorKey->compare(*right->collatorKey) < 0;
+    }
+    return left->lowerName < right->lowerName;
+}
+
+void FileItemProxyFilterSortModel::resort()
+{
+    if (!sourceModel())
+        return;
+    if (m_pending_sort_column >= 0) {
+        startSortJob(m_pending_sort_column, m_pending_sort_order);
+        return;
+    }
+    if (sortColumn() < 0)
+        return;
+    if (sortsAsynchronously())
+        startSortJob(sortColumn(), sortOrder());
+    else
+        invalidate();
+}
+
+bool FileItemProxyFilterSortModel::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == qApp && event->type() == QEvent::LocaleChange) {
+        //the collator is shared, only the first model handling it rebuilds it.
+        if (QLocale::system().name() != locale.name())
+            invalidateSortKeys();
+        resort();
+    }
+    return QSortFilterProxyModel::eventFilter(watched, event);
+}
+
+bool FileItemProxyFilterSortModel::lessThanEntries(FileEntryStore *store, int leftRow, int rightRow, int column, Qt::SortOrder order) const
+{
+    bool leftIsDir = store->isDir(leftRow);
+    bool rightIsDir = store->isDir(rightRow);
+    if (leftIsDir != rightIsDir && m_folder_first) {
+        if (order == Qt::AscendingOrder)
+            return leftIsDir;
+        return rightIsDir;
+    }
+
+    switch (column) {
+    case FileItemModel::FileName: {
+        //virtual rows are only compared here when the rows appended to a sorted
+        //proxy are placed, the keys are not worth caching for every row.
+        FileSortKey leftKey;
+        FileSortKey rightKey;
+        fill_sort_key(&leftKey, store->displayName(leftRow));
+        fill_sort_key(&rightKey, store->displayName(rightRow));
+        return lessThanNames(&leftKey, &rightKey);
+    }
+    case FileItemModel::FileSize: {
+        return store->size(leftRow) < store->size(rightRow);
+    }
+    case FileItemModel::FileType: {
+        auto cache = ContentTypeCache::getInstance();
+        return cache->description(store->type(leftRow).contentType) < cache->description(store->type(rightRow).contentType);
+    }
+    case FileItemModel::ModifiedDate: {
+        return store->modifiedTime(leftRow) < store->modifiedTime(rightRow);
+    }
+    default:
+        break;
+    }
+    return leftRow < rightRow;
 }
 
 bool FileItemProxyFilterSortModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
@@ -154,101 +651,82 @@ bool FileItemProxyFilterSortModel::filterAcceptsRow(int sourceRow, const QModelI
     auto childIndex = model->index(sourceRow, 0, sourceParent);
     if (childIndex.isValid()) {
         auto item = static_cast<FileItem*>(childIndex.internalPointer());
-        if (!m_show_hidden) {
-            //qDebug()<<sourceRow<<item->m_info->displayName()<<model->rowCount(sourceParent);
-            //QMessageBox::warning(nullptr, "filter", item->m_info->displayName());
-            //qDebug()<<item->m_info->displayName();
-            if (item->m_info->displayName() != nullptr) {
-                if (item->m_info->displayName().at(0) == '.')
-                    //qDebug()<<sourceRow<<item->m_info->displayName()<<model->rowCount(sourceParent);
-                    return false;
-            }
+        if (!item) {
+            //virtual row, do not create an item for filtering.
+            auto store = model->entryStore(sourceParent);
+            return filterAcceptsFile(store->uri(sourceRow), store->displayName(sourceRow), store->type(sourceRow).contentType,
+                                     store->modifiedTime(sourceRow), store->size(sourceRow));
         }
-        //regExp
+        return filterAcceptsFile(item->m_info->uri(), item->m_info->displayName(), item->m_info->type(),
+                                 item->m_info->modifiedTime(), item->m_info->size());
+    }
+    return true;
+}
 
-        //check the file info filter conditions
-        //qDebug()<<"start filter conditions check"<<item->m_info->displayName()<<item->m_info->type();
-        if (! checkFileTypeFilter(item->m_info->type()))
-            return false;
-        if (! checkFileModifyTimeFilter(item->m_info->modifiedTime()))
-            return false;
-        if (! checkFileSizeFilter(item->m_info->size()))
-            return false;
-        if (! checkFileNameFilter(item->m_info->displayName()))
-            return false;
+bool FileItemProxyFilterSortModel::filterAcceptsFile(const QString &uri, const QString &displayName, const QString &type,
+                                                     quint64 modifiedTime, quint64 size) const
+{
+    if (!m_show_hidden) {
+        if (displayName != nullptr) {
+            if (displayName.at(0) == '.')
+                return false;
+        }
+    }
+    //regExp
 
-        //check the file label filter conditions
-        if (m_label_name != "" || m_label_color != Qt::transparent)
-        {
-            QString uri = item->m_info->uri();
-            if (m_label_name != "")
-            {
-                auto names = FileLabelModel::getGlobalModel()->getFileLabels(uri);
-                if (! names.contains(m_label_name))
-                    return false;
-            }
+    //check the file info filter conditions
+    //qDebug()<<"start filter conditions check"<<displayName<<type;
+    if (! checkFileTypeFilter(type))
+        return false;
+    if (! checkFileModifyTimeFilter(modifiedTime))
+        return false;
+    if (! checkFileSizeFilter(size))
+        return false;
+    if (! checkFileNameFilter(displayName))
+        return false;
 
-            if (m_label_color != Qt::transparent)
-            {
-                auto colors = FileLabelModel::getGlobalModel()->getFileColors(uri);
-                if (! colors.contains(m_label_color))
-                    return false;
-            }
+    //check the file label filter conditions
+    //label names and colors are resolved to ids, then checked with the reverse label index.
+    if (m_label_name != "" || m_label_color != Qt::transparent)
+    {
+        auto labelModel = FileLabelModel::getGlobalModel();
+        if (m_label_name != "")
+        {
+            if (! labelModel->fileHasLabels(uri, m_label_name_ids))
+                return false;
         }
 
-        //check multiple label filter conditions, file has any one of these label is accepted
-        if(m_show_label_names.size() >0 || m_show_label_colors.size() >0)
+        if (m_label_color != Qt::transparent)
         {
-            bool bfind = false;
-            QString uri = item->m_info->uri();
-            if (m_show_label_names.size() >0 )
-            {
-                auto names = FileLabelModel::getGlobalModel()->getFileLabels(uri);
-                for(auto temp : m_show_label_names)
-                {
-                    if(names.contains(temp))
-                    {
-                        bfind = true;
-                        break;
-                    }
-                }
-            }
-
-            if (! bfind && m_show_label_colors.size() >0)
-            {
-                auto colors = FileLabelModel::getGlobalModel()->getFileColors(uri);
-                for(auto temp : m_show_label_colors)
-                {
-                    if (colors.contains(temp))
-                    {
-                        bfind = true;
-                        break;
-                    }
-                }
-            }
-
-            if (! bfind)
+            if (! labelModel->fileHasLabels(uri, m_label_color_ids))
                 return false;
         }
+    }
 
-        //check the blur name, can use as search color labels
-        if (m_blur_name != "")
+    //check multiple label filter conditions, file has any one of these label is accepted
+    if(m_show_label_names.size() >0 || m_show_label_colors.size() >0)
+    {
+        auto labelModel = FileLabelModel::getGlobalModel();
+        if (! labelModel->fileHasLabels(uri, m_show_label_ids))
+            return false;
+    }
+
+    //check the blur name, can use as search color labels
+    if (m_blur_name != "")
+    {
+        auto names = FileLabelModel::getGlobalModel()->getFileLabels(uri);
+        bool find = false;
+        for(auto temp : names)
         {
-            QString uri = item->m_info->uri();
-            auto names = FileLabelModel::getGlobalModel()->getFileLabels(uri);
-            bool find = false;
-            for(auto temp : names)
+            if ((m_case_sensitive && temp.indexOf(m_blur_name) >= 0) ||
+                    (! m_case_sensitive && temp.toLower().indexOf(m_blur_name.toLower()) >= 0))
             {
-                if ((m_case_sensitive && temp.indexOf(m_blur_name) >= 0) ||
-                        (! m_case_sensitive && temp.toLower().indexOf(m_blur_name.toLower()) >= 0))
-                {
-                    find = true;
-                    break;
-                }
+                find = true;
+                break;
             }
-            if (! find)
-                return false;
         }
+        if (! find)
+            return false;
     }
     return true;
 }
@@ -472,6 +950,10 @@ void FileItemProxyFilterSortModel::setUseDefaultNameSortOrder(bool use)
 {
     GlobalSettings::getInstance()->setValue("chinese-first", use);
     m_use_default_name_sort_order = use;
+    if (sortsAsynchronously()) {
+        startSortJob(sortColumn()>0? sortColumn(): 0, sortOrder()==Qt::DescendingOrder? Qt::DescendingOrder: Qt::AscendingOrder);
+        return;
+    }
     beginResetModel();
     sort(sortColumn()>0? sortColumn(): 0, sortOrder()==Qt::DescendingOrder? Qt::DescendingOrder: Qt::AscendingOrder);
     endResetModel();
@@ -481,6 +963,10 @@ void FileItemProxyFilterSortModel::setFolderFirst(bool folderFirst)
 {
     GlobalSettings::getInstance()->setValue("folder-first", folderFirst);
     m_folder_first = folderFirst;
+    if (sortsAsynchronously()) {
+        startSortJob(sortColumn()>0? sortColumn(): 0, sortOrder()==Qt::DescendingOrder? Qt::DescendingOrder: Qt::AscendingOrder);
+        return;
+    }
     beginResetModel();
     sort(sortColumn()>0? sortColumn(): 0, sortOrder()==Qt::DescendingOrder? Qt::DescendingOrder: Qt::AscendingOrder);
     endResetModel();
@@ -561,6 +1047,7 @@ void FileItemProxyFilterSortModel::setFilterLabelConditions(QString name, QColor
 {
     m_label_name = name;
     m_label_color = color;
+    updateLabelFilterIds();
     invalidateFilter();
 }
 
@@ -577,9 +1064,18 @@ void FileItemProxyFilterSortModel::setMutipleLabelConditions(QStringList names,
     {
         m_show_label_colors.append(color);
     }
+    updateLabelFilterIds();
     invalidateFilter();
 }
 
+void FileItemProxyFilterSortModel::updateLabelFilterIds()
+{
+    auto labelModel = FileLabelModel::getGlobalModel();
+    m_label_name_ids = labelModel->getLabelIds(QStringList()<<m_label_name, QList<QColor>());
+    m_label_color_ids = labelModel->getLabelIds(QStringList(), QList<QColor>()<<m_label_color);
+    m_show_label_ids = labelModel->getLabelIds(m_show_label_names, m_show_label_colors);
+}
+
 void FileItemProxyFilterSortModel::setLabelBlurName(QString blurName, bool caseSensitive)
 {
     m_blur_name = blurName;
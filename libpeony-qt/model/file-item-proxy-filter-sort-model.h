@@ -27,6 +27,24 @@
 #include <QObject>
 #include <QSortFilterProxyModel>
 #include <QColor>
+#include <QCollatorSortKey>
+#include <QFuture>
+#include <QAtomicInt>
+#include <QItemSelectionModel>
+
+#include <memory>
+
+/*!
+ * \brief PEONY_ASYNC_SORT_THRESHOLD
+ * the root rows of source model are sorted off the ui thread if there are so many of them.
+ * \see FileItemProxyFilterSortModel::sort().
+ */
+#define PEONY_ASYNC_SORT_THRESHOLD 20000
+/*!
+ * \brief PEONY_PARALLEL_SORT_MIN_CHUNK
+ * the minimal count of rows sorted by one thread.
+ */
+#define PEONY_PARALLEL_SORT_MIN_CHUNK 4096
 
 #include "peony-core_global.h"
 
@@ -34,6 +52,37 @@ namespace Peony {
 
 class FileItem;
 class FileItemModel;
+class FileEntryStore;
+
+/*!
+ * \brief The FileSortKey struct
+ * <br>
+ * The precomputed name sort keys of a FileItem, so that sorting does not collate
+ * or parse the display names in every comparison. It is cached in the item and
+ * rebuilt once the display name changed, or FileItemProxyFilterSortModel::invalidateSortKeys()
+ * is called, such as locale changed.
+ * </br>
+ * \note
+ * The virtual rows have no item, their keys are only built temporarily, in the
+ * sort job or for a comparison, so that a FileEntryStore stays compact.
+ */
+struct FileSortKey {
+    int generation = -1;
+    QString displayName;
+    bool isDir = false;
+    QString lowerName;
+    /*!
+     * \brief duplicateBaseName
+     * display name without the duplicated number, such as "a(1).txt" -> "a.txt".
+     */
+    QString duplicateBaseName;
+    int duplicateNumber = 0;
+    /*!
+     * \brief collatorKey
+     * created on demand, only the default name sort order needs it.
+     */
+    std::shared_ptr<QCollatorSortKey> collatorKey;
+};
 
 class PEONYCORESHARED_EXPORT FileItemProxyFilterSortModel : public QSortFilterProxyModel
 {
@@ -77,7 +126,22 @@ public:
     const QString Audio_Type = "audio/";
 
     explicit FileItemProxyFilterSortModel(QObject *parent = nullptr);
+    ~FileItemProxyFilterSortModel() override;
     void setSourceModel(QAbstractItemModel *model) override;
+
+    /*!
+     * \brief sort
+     * \param column
+     * \param order
+     * <br>
+     * If the source model has less root rows than PEONY_ASYNC_SORT_THRESHOLD, this is
+     * the same as QSortFilterProxyModel::sort(). Otherwise the sort keys are copied
+     * and sorted by a parallel merge sort in thread pool, the result is applied
+     * with one layout change. The rows keep their current order until then.
+     * A new sort request cancels the running one.
+     * </br>
+     */
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
     void setShowHidden(bool showHidden);
     void setUseDefaultNameSortOrder(bool use);
     void setFolderFirst(bool folderFirst);
@@ -104,14 +168,89 @@ public:
     QStringList getAllFileUris();
     QModelIndexList getAllFileIndexes();
 
+    /*!
+     * \brief pinSelection
+     * \param selectionModel, the selection model of a view of this model.
+     * keep the items of selected and current children alive while the children
+     * are virtual, so that they are not released under the view.
+     * \see FileItemModel::setPinnedUris().
+     */
+    void pinSelection(QItemSelectionModel *selectionModel);
+
+    /*!
+     * \brief invalidateSortKeys
+     * rebuild the collator with current system locale, and let the cached
+     * FileSortKey of all items be rebuilt.
+     */
+    static void invalidateSortKeys();
+
 public Q_SLOTS:
     void update();
 
 protected:
     bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
     bool lessThan(const QModelIndex &left, const QModelIndex &right) const override;
+    /*!
+     * \brief eventFilter
+     * invalidate the sort keys and sort again when the locale of application changed.
+     */
+    bool eventFilter(QObject *watched, QEvent *event) override;
 
 private:
+    /*!
+     * \brief lessThanColumn
+     * \return lessThan() result of column and order, without the sort ranks.
+     */
+    bool lessThanColumn(const QModelIndex &left, const QModelIndex &right, int column, Qt::SortOrder order) const;
+    /*!
+     * \brief lessThanEntries
+     * \return lessThanColumn() result of two virtual rows, which have no FileItem.
+     * \see FileItemModel::setVirtualThreshold().
+     */
+    bool lessThanEntries(FileEntryStore *store, int leftRow, int rightRow, int column, Qt::SortOrder order) const;
+    /*!
+     * \brief sortKey
+     * \param item
+     * \return the cached sort key of item, rebuild it if it is stale.
+     */
+    FileSortKey *sortKey(FileItem *item) const;
+    bool lessThanNames(FileSortKey *left, FileSortKey *right) const;
+    /*!
+     * \brief resort
+     * sort the rows again with current sort column and order.
+     */
+    void resort();
+    bool filterAcceptsFile(const QString &uri, const QString &displayName, const QString &type,
+                           quint64 modifiedTime, quint64 size) const;
+
+    bool sortsAsynchronously() const;
+    /*!
+     * \brief startSortJob
+     * sort the root rows of source model off the ui thread, see sort().
+     */
+    void startSortJob(int column, Qt::SortOrder order);
+    /*!
+     * \brief applySortRanks
+     * apply the result of sort job in one layout change, lessThan() compares the
+     * ranks of root rows meanwhile. The rows are not filtered again.
+     */
+    void applySortRanks(int generation, int revision, int column, Qt::SortOrder order, const QVector<int> &ranks);
+    /*!
+     * \brief placeAppendedRows
+     * \param ranks, the sort result of the rows before the appended ones.
+     * \return the ranks of all root rows, the rows appended while sorting are
+     * binary searched into the result instead of sorting all rows again.
+     */
+    QVector<int> placeAppendedRows(int column, Qt::SortOrder order, const QVector<int> &ranks) const;
+    void cancelSortJob();
+
+    /*!
+     * \brief updateLabelFilterIds
+     * resolve the label filter conditions to label ids, so that filtering
+     * a row only looks up the label index.
+     */
+    void updateLabelFilterIds();
+
     bool startWithChinese(const QString &displayName) const;
     bool checkFileTypeFilter(QString type) const;
     bool checkFileModifyTimeFilter(quint64 modifiedTime) const;
@@ -133,6 +272,24 @@ private:
     QStringList m_file_name_list;
     QStringList m_show_label_names;
     QList<QColor> m_show_label_colors;
+    QList<int> m_label_name_ids, m_label_color_ids, m_show_label_ids;
+
+    /*!
+     * \brief m_sort_ranks
+     * rank of each root row of source model, lessThan() compares the ranks
+     * instead of the files while it is not empty.
+     */
+    QVector<int> m_sort_ranks;
+    std::shared_ptr<QAtomicInt> m_sort_generation;
+    QFuture<void> m_sort_future;
+    int m_pending_sort_column = -1;
+    Qt::SortOrder m_pending_sort_order = Qt::AscendingOrder;
+    /*!
+     * \brief m_source_revision
+     * increased when the rows of source model changed, except appending root
+     * rows, a sort result of other revision is stale.
+     */
+    int m_source_revision = 0;
 };
 
 }
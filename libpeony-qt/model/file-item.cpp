@@ -23,12 +23,16 @@
 #include "file-item.h"
 #include "file-enumerator.h"
 #include "file-info-job.h"
+#include "file-info-batch-job.h"
+#include "directory-snapshot-cache.h"
+#include "prefetch-scheduler.h"
 #include "file-info-manager.h"
 #include "file-watcher.h"
 #include "file-utils.h"
 #include "file-operation-utils.h"
 
 #include "file-item-model.h"
+#include "file-entry-store.h"
 
 #include "thumbnail-manager.h"
 
@@ -43,6 +47,9 @@
 
 #include <QMessageBox>
 #include <QUrl>
+#include <QTimer>
+
+#include <algorithm>
 
 using namespace Peony;
 
@@ -53,6 +60,9 @@ FileItem::FileItem(std::shared_ptr<Peony::FileInfo> info, FileItem *parentItem,
     m_children = new QVector<FileItem*>();
 
     m_model = model;
+    m_uri_key = FileItemModel::uriKey(m_info->uri());
+    if (m_model)
+        m_model->registerItem(this);
 
     m_backend_enumerator = new FileEnumerator(this);
 
@@ -60,21 +70,18 @@ FileItem::FileItem(std::shared_ptr<Peony::FileInfo> info, FileItem *parentItem,
     connect(m_thumbnail_watcher.get(), &FileWatcher::fileChanged, this, [=](const QString &uri){
         auto index = m_model->indexFromUri(uri);
         if (index.isValid()) {
-            auto item = m_model->itemFromIndex(index);
-            if (item) {
-                /*!
-                  \note
-                  fix the probabilistic jamming while thumbnailing with list view.
+            /*!
+              \note
+              fix the probabilistic jamming while thumbnailing with list view.
 
-                  we have to only trigger first column index dataChanged signal,
-                  otherwise there will be probility stucked whole program.
+              we have to only trigger first column index dataChanged signal,
+              otherwise there will be probility stucked whole program.
 
-                  i'm not sure if it is a bug of qtreeview.
-                  */
+              i'm not sure if it is a bug of qtreeview.
+              */
 
-                //m_model->dataChanged(item->firstColumnIndex(), item->lastColumnIndex());
-                m_model->dataChanged(item->firstColumnIndex(), item->firstColumnIndex());
-            }
+            //the index of a virtual row has no item, do not create one here.
+            m_model->dataChanged(index, index);
         }
     });
 
@@ -94,6 +101,12 @@ FileItem::~FileItem()
     m_children->clear();
 
     delete m_children;
+
+    if (m_model)
+        m_model->unregisterItem(this);
+
+    releaseMaterializedChildren();
+    delete m_store;
 }
 
 bool FileItem::operator==(const FileItem &item)
@@ -116,7 +129,7 @@ QVector<FileItem*> *FileItem::findChildrenSync()
     auto infos = enumerator->getChildren(true);
     for (auto info : infos) {
         FileItem *child = new FileItem(info, this, m_model);
-        m_children->append(child);
+        appendChild(child);
         FileInfoJob *job = new FileInfoJob(info);
         job->setAutoDelete();
         job->querySync();
@@ -139,6 +152,9 @@ void FileItem::findChildrenAsync()
     m_expanded = true;
     Peony::FileEnumerator *enumerator = new Peony::FileEnumerator;
     enumerator->setEnumerateDirectory(m_info->uri());
+    //query children's info while enumerating, so that we do not need
+    //start a info job for each child.
+    enumerator->setEnumerateWithInfo(true);
     //NOTE: entry a new root might destroyed the current enumeration work.
     //the root item will be delete, so we should cancel the previous enumeration.
     enumerator->connect(this, &FileItem::cancelFindChildren, enumerator, &FileEnumerator::cancel);
@@ -180,8 +196,8 @@ void FileItem::findChildrenAsync()
             return;
         }
 
-        //FIXME: replace BLOCKING api in ui thread.
-        auto target = FileUtils::getTargetUri(m_info->uri());
+        //the target uri has been queried asynchronously while preparing.
+        auto target = enumerator->preparedTargetUri();
         if (!target.isEmpty()) {
             enumerator->cancel();
             //enumerator->deleteLater();
@@ -244,9 +260,25 @@ void FileItem::findChildrenAsync()
                     Q_EMIT m_model->findChildrenFinished();
                 }
 
+                if (enumerator->isEnumerateWithInfo() && !infos.isEmpty()) {
+                    //children infos are loaded, insert them at once.
+                    m_async_count = 0;
+                    for (auto info : infos) {
+                        FileItem *child = new FileItem(info, this, m_model);
+                        prependChild(child);
+                    }
+                    m_model->insertRows(0, m_children->count(), this->firstColumnIndex());
+                    Q_EMIT this->m_model->findChildrenFinished();
+                    Q_EMIT m_model->updated();
+                    for (auto info : infos) {
+                        ThumbnailManager::getInstance()->createThumbnail(info->uri(), m_thumbnail_watcher);
+                    }
+                    infos.clear();
+                }
+
                 for (auto info : infos) {
                     FileItem *child = new FileItem(info, this, m_model);
-                    m_children->prepend(child);
+                    prependChild(child);
                     FileInfoJob *job = new FileInfoJob(info);
                     job->setAutoDelete();
                     /*
@@ -305,24 +337,7 @@ void FileItem::findChildrenAsync()
                 this->onChildRemoved(uri);
                 Q_EMIT this->childRemoved(uri);
             });
-            connect(m_watcher.get(), &FileWatcher::fileChanged, this, [=](const QString &uri) {
-                auto index = m_model->indexFromUri(uri);
-                if (index.isValid()) {
-                    auto infoJob = new FileInfoJob(FileInfo::fromUri(index.data(FileItemModel::UriRole).toString()));
-                    infoJob->setAutoDelete();
-                    connect(infoJob, &FileInfoJob::queryAsyncFinished, this, [=]() {
-                        m_model->dataChanged(m_model->indexFromUri(uri), m_model->indexFromUri(uri));
-                        auto info = FileInfo::fromUri(uri);
-                        ThumbnailManager::getInstance()->createThumbnail(uri, m_thumbnail_watcher, true);
-                        /*
-                        if (info->isDesktopFile()) {
-                            ThumbnailManager::getInstance()->updateDesktopFileThumbnail(info->uri(), m_thumbnail_watcher);
-                        }
-                        */
-                    });
-                    infoJob->queryAsync();
-                }
-            });
+            connect(m_watcher.get(), &FileWatcher::fileChanged, this, &FileItem::onChildChanged);
             connect(m_watcher.get(), &FileWatcher::thumbnailUpdated, this, [=](const QString &uri) {
                 m_model->dataChanged(m_model->indexFromUri(uri), m_model->indexFromUri(uri));
             });
@@ -359,28 +374,104 @@ void FileItem::findChildrenAsync()
                 return ;
             }
 
+            //a snapshot loaded later than the enumerated children is useless.
+            if (!uris.isEmpty())
+                disconnect(m_snapshot_connection);
+
+            if (enumerator->isEnumerateWithInfo()) {
+                //children infos are loaded, insert this batch at once.
+                if (uris.isEmpty())
+                    return;
+
+                //a huge directory is kept in a FileEntryStore.
+                int threshold = m_model->virtualThreshold();
+                if (!m_store && !m_parent && !m_model->canExpandChildren() && threshold >= 0
+                        && m_children->count() + m_pending_infos.count() + uris.count() > threshold) {
+                    virtualize();
+                }
+                if (m_store) {
+                    QList<std::shared_ptr<FileInfo>> infos;
+                    for (auto uri : uris) {
+                        m_snapshot_uris.remove(uri);
+                        infos<<FileInfo::fromUri(uri);
+                    }
+                    appendVirtualChildren(infos);
+                    //the store holds the children now.
+                    enumerator->releaseChildren();
+                    return;
+                }
+
+                QList<std::shared_ptr<FileInfo>> infos;
+                int first = -1;
+                int last = -1;
+                for (auto uri : uris) {
+                    //the child shown from snapshot is revalidated, just update it.
+                    auto child = m_snapshot_uris.remove(uri)? getChildFromUri(uri): nullptr;
+                    if (child) {
+                        int row = m_model->rowOf(child);
+                        first = first < 0? row: qMin(first, row);
+                        last = qMax(last, row);
+                        ThumbnailManager::getInstance()->createThumbnail(uri, m_thumbnail_watcher);
+                        continue;
+                    }
+                    infos<<FileInfo::fromUri(uri);
+                }
+                if (first >= 0) {
+                    auto parent = firstColumnIndex();
+                    Q_EMIT m_model->dataChanged(m_model->index(first, 0, parent), m_model->index(last, FileItemModel::Other, parent));
+                }
+                queueChildren(infos);
+                return;
+            }
+
             for (auto uri : uris) {
                 auto info = FileInfo::fromUri(uri);
                 auto infoJob = new FileInfoJob(info);
                 infoJob->setAutoDelete();
                 infoJob->connect(infoJob, &FileInfoJob::infoUpdated, this, [=]() {
-                    auto item = new FileItem(info, this, m_model);
-                    m_model->beginInsertRows(firstColumnIndex(), m_children->count(), m_children->count());
-                    m_children->append(item);
-                    m_model->endInsertRows();
-                    //Q_EMIT m_model->dataChanged(item->firstColumnIndex(), item->lastColumnIndex());
-                    //Q_EMIT m_model->updated();
-                    ThumbnailManager::getInstance()->createThumbnail(info->uri(), m_thumbnail_watcher);
+                    queueChildren(QList<std::shared_ptr<FileInfo>>()<<info);
                 });
                 infoJob->queryAsync();
             }
         });
 
-        enumerator->connect(enumerator, &Peony::FileEnumerator::enumerateFinished, this, [=]() {
+        enumerator->connect(enumerator, &Peony::FileEnumerator::enumerateFinished, this, [=](bool successed) {
             delete enumerator;
+            disconnect(m_snapshot_connection);
             if (!m_model||!m_children||!m_info)
                 return;
 
+            //insert the accumulated children before the views resort.
+            flushPendingChildren();
+
+            if (successed) {
+                //remove the children shown from snapshot but not existed any more.
+                auto removedUris = m_snapshot_uris;
+                m_snapshot_uris.clear();
+                QVector<int> removedRows;
+                for (auto uri : removedUris) {
+                    int row = -1;
+                    if (m_store) {
+                        row = m_store->indexOf(uri);
+                    } else if (auto child = getChildFromUri(uri)) {
+                        row = m_model->rowOf(child);
+                    }
+                    if (row >= 0)
+                        removedRows<<row;
+                }
+                std::sort(removedRows.begin(), removedRows.end());
+                removeChildRows(removedRows);
+
+                //a virtual directory is too large for a snapshot.
+                if (!m_parent && !m_store) {
+                    QList<std::shared_ptr<FileInfo>> infos;
+                    for (auto child : *m_children) {
+                        infos<<child->m_info;
+                    }
+                    DirectorySnapshotCache::getInstance()->saveSnapshot(m_info, infos);
+                }
+            }
+
             Q_EMIT m_model->findChildrenFinished();
             Q_EMIT m_model->updated();
 
@@ -405,21 +496,7 @@ void FileItem::findChildrenAsync()
                 this->onChildRemoved(uri);
                 Q_EMIT this->childRemoved(uri);
             });
-            connect(m_watcher.get(), &FileWatcher::fileChanged, this, [=](const QString &uri) {
-                auto index = m_model->indexFromUri(uri);
-                if (index.isValid()) {
-                    auto infoJob = new FileInfoJob(FileInfo::fromUri(index.data(FileItemModel::UriRole).toString()));
-                    infoJob->setAutoDelete();
-                    connect(infoJob, &FileInfoJob::queryAsyncFinished, this, [=]() {
-                        m_model->dataChanged(m_model->indexFromUri(uri), m_model->indexFromUri(uri));
-                        auto info = FileInfo::fromUri(uri);
-                        if (info->isDesktopFile()) {
-                            ThumbnailManager::getInstance()->updateDesktopFileThumbnail(info->uri(), m_watcher);
-                        }
-                    });
-                    infoJob->queryAsync();
-                }
-            });
+            connect(m_watcher.get(), &FileWatcher::fileChanged, this, &FileItem::onChildChanged);
             connect(m_watcher.get(), &FileWatcher::thumbnailUpdated, this, [=](const QString &uri) {
                 m_model->dataChanged(m_model->indexFromUri(uri), m_model->indexFromUri(uri));
             });
@@ -444,9 +521,47 @@ void FileItem::findChildrenAsync()
         });
     }
 
+    if (m_model->isPositiveResponse() && !m_parent) {
+        //the children prefetched before user entered this directory are fully
+        //loaded and fresher than a snapshot, show them at once. otherwise show
+        //the children recorded in the snapshot of this directory. both of them
+        //are revalidated by the enumeration.
+        auto infos = PrefetchScheduler::getInstance()->takeWarmChildren(m_info->uri());
+        if (!infos.isEmpty()) {
+            insertSnapshotChildren(infos);
+        } else {
+            //the snapshot is read in a worker, it is only shown if the enumeration
+            //has not delivered any child yet.
+            auto snapshotCache = DirectorySnapshotCache::getInstance();
+            auto uri = m_info->uri();
+            m_snapshot_connection = connect(snapshotCache, &DirectorySnapshotCache::snapshotLoaded,
+                                            this, [=](const QString &snapshotUri, const QList<std::shared_ptr<FileInfo>> &snapshotInfos) {
+                if (snapshotUri != uri)
+                    return;
+                disconnect(m_snapshot_connection);
+                if (m_children && m_children->isEmpty() && m_pending_infos.isEmpty() && !m_store)
+                    insertSnapshotChildren(snapshotInfos);
+            });
+            snapshotCache->loadSnapshotAsync(m_info);
+        }
+    }
+
     enumerator->prepare();
 }
 
+void FileItem::insertSnapshotChildren(const QList<std::shared_ptr<FileInfo>> &infos)
+{
+    if (infos.isEmpty())
+        return;
+
+    m_model->beginInsertRows(firstColumnIndex(), m_children->count(), m_children->count() + infos.count() - 1);
+    for (auto info : infos) {
+        appendChild(new FileItem(info, this, m_model));
+        m_snapshot_uris.insert(info->uri());
+    }
+    m_model->endInsertRows();
+}
+
 QModelIndex FileItem::firstColumnIndex()
 {
     return m_model->firstColumnIndex(this);
@@ -465,19 +580,56 @@ bool FileItem::hasChildren()
 
 FileItem *FileItem::getChildFromUri(QString uri)
 {
-    for (auto item : *m_children) {
-        QUrl itemUrl = item->uri();
-        QUrl url = uri;
-        QString decodedUri = url.toDisplayString();
-        if (decodedUri == itemUrl.toDisplayString())
-            return item;
-    }
-    return nullptr;
+    return m_child_index.value(FileItemModel::uriKey(uri));
+}
+
+void FileItem::appendChild(FileItem *child)
+{
+    m_children->append(child);
+    m_child_index.insert(child->m_uri_key, child);
+}
+
+void FileItem::prependChild(FileItem *child)
+{
+    m_children->prepend(child);
+    m_child_index.insert(child->m_uri_key, child);
+}
+
+void FileItem::removeChild(FileItem *child)
+{
+    int row = m_model->rowOf(child);
+    if (row >= 0 && child->m_parent == this)
+        m_children->remove(row);
+    else
+        m_children->removeOne(child);
+
+    auto it = m_child_index.find(child->m_uri_key);
+    if (it != m_child_index.end() && it.value() == child)
+        m_child_index.erase(it);
 }
 
 void FileItem::onChildAdded(const QString &uri)
 {
     qDebug()<<"add child:" << uri;
+    if (m_store) {
+        if (m_store->indexOf(uri) >= 0) {
+            updateChildrenAsync(QStringList()<<uri);
+            return;
+        }
+        auto info = FileInfo::fromUri(uri);
+        auto infoJob = new FileInfoJob(info);
+        infoJob->setAutoDelete();
+        infoJob->connect(infoJob, &FileInfoJob::infoUpdated, this, [=]() {
+            queueChildren(QList<std::shared_ptr<FileInfo>>()<<info);
+        });
+        infoJob->queryAsync();
+        return;
+    }
+
+    //the info is loaded and the child will be inserted soon.
+    if (m_pending_keys.contains(FileItemModel::uriKey(uri)))
+        return;
+
     FileItem *child = getChildFromUri(uri);
     if (child) {
         qDebug()<<"has added";
@@ -491,13 +643,7 @@ void FileItem::onChildAdded(const QString &uri)
     auto infoJob = new FileInfoJob(info);
     infoJob->setAutoDelete();
     infoJob->connect(infoJob, &FileInfoJob::infoUpdated, this, [=]() {
-        auto item = new FileItem(info, this, m_model);
-        m_model->beginInsertRows(firstColumnIndex(), m_children->count(), m_children->count());
-        m_children->append(item);
-        m_model->endInsertRows();
-        //Q_EMIT m_model->dataChanged(item->firstColumnIndex(), item->lastColumnIndex());
-        //Q_EMIT m_model->updated();
-        ThumbnailManager::getInstance()->createThumbnail(info->uri(), m_thumbnail_watcher);
+        queueChildren(QList<std::shared_ptr<FileInfo>>()<<info);
     });
     infoJob->queryAsync();
 
@@ -510,13 +656,59 @@ void FileItem::onChildAdded(const QString &uri)
 //    //m_model->updated();
 }
 
+void FileItem::onChildChanged(const QString &uri)
+{
+    QString childUri = uri;
+    if (m_store) {
+        if (m_store->indexOf(uri) < 0)
+            return;
+    } else {
+        FileItem *child = getChildFromUri(uri);
+        if (!child)
+            return;
+        childUri = child->uri();
+    }
+
+    //a file might be changed many times in a short time, such as writing.
+    //coalesce the changes and update them in one batch job.
+    bool scheduled = !m_changed_uris.isEmpty();
+    if (!m_changed_uris.contains(childUri))
+        m_changed_uris<<childUri;
+
+    if (!scheduled) {
+        QTimer::singleShot(100, this, [=]() {
+            auto uris = m_changed_uris;
+            m_changed_uris.clear();
+            updateChildrenAsync(uris);
+        });
+    }
+}
+
 void FileItem::onChildRemoved(const QString &uri)
 {
+    //the child might be waiting for insertion.
+    if (m_pending_keys.contains(FileItemModel::uriKey(uri)))
+        flushPendingChildren();
+
+    if (m_store) {
+        int row = m_store->indexOf(uri);
+        if (row >= 0) {
+            m_model->beginRemoveRows(this->firstColumnIndex(), row, row);
+            auto childUri = m_store->uri(row);
+            m_store->remove(row);
+            if (m_materialized.contains(childUri))
+                m_materialized.take(childUri).item->deleteLater();
+            m_model->endRemoveRows();
+        }
+        m_model->updated();
+        return;
+    }
+
     FileItem *child = getChildFromUri(uri);
     if (child) {
-        int index = m_children->indexOf(child);
+        int index = m_model->rowOf(child);
         m_model->beginRemoveRows(this->firstColumnIndex(), index, index);
-        m_children->removeOne(child);
+        removeChild(child);
         delete child;
         m_model->endRemoveRows();
     }
@@ -535,13 +727,13 @@ void FileItem::onDeleted(const QString &thisUri)
     //doublue clicked twice it will be expanded. a qt's bug?
     if (m_parent) {
         if (m_parent->m_info->uri() == thisUri) {
-            m_model->removeRow(m_parent->m_children->indexOf(this), m_parent->firstColumnIndex());
-            m_parent->m_children->removeOne(this);
+            m_model->removeRow(m_model->rowOf(this), m_parent->firstColumnIndex());
+            m_parent->removeChild(this);
         } else {
             //if just clear children, there will be a small problem.
             clearChildren();
-            m_model->removeRow(m_parent->m_children->indexOf(this), m_parent->firstColumnIndex());
-            m_parent->m_children->removeOne(this);
+            m_model->removeRow(m_model->rowOf(this), m_parent->firstColumnIndex());
+            m_parent->removeChild(this);
             m_parent->onChildAdded(m_info->uri());
         }
         this->deleteLater();
@@ -574,42 +766,282 @@ void FileItem::onRenamed(const QString &oldUri, const QString &newUri)
 
 void FileItem::onUpdateDirectoryRequest()
 {
+    //the enumerator fills the shared infos of children in place, record
+    //their stats before, so that the changed children can be found.
+    auto rootItem = m_model->m_root_item;
+    QHash<QString, QPair<quint64, quint64>> stats;
+    if (!rootItem->m_store) {
+        stats.reserve(rootItem->m_children->count());
+        for (auto child : *rootItem->m_children) {
+            stats.insert(child->m_uri_key, qMakePair(child->m_info->modifiedTime(), child->m_info->size()));
+        }
+    }
+
     auto enumerator = new FileEnumerator(this);
     enumerator->setEnumerateDirectory(m_model->getRootUri());
-    connect(enumerator, &FileEnumerator::enumerateFinished, m_model, [=](){
-        if (m_model->getRootUri() != enumerator->getEnumerateUri())
+    enumerator->setEnumerateWithInfo(true);
+    connect(enumerator, &FileEnumerator::enumerateFinished, m_model, [=](bool successed){
+        enumerator->deleteLater();
+        if (!successed || m_model->getRootUri() != enumerator->getEnumerateUri())
             return;
 
-        auto currentUris = enumerator->getChildrenUris();
-        QStringList rawUris;
-        QStringList removedUris;
-        QStringList addedUris;
+        m_model->m_root_item->reconcileChildren(enumerator->getChildren(), stats);
+    });
+
+    enumerator->enumerateAsync();
+}
 
-        for (auto child : *m_model->m_root_item->m_children) {
-            rawUris<<child->uri();
-            if (!currentUris.contains(child->uri())) {
-                removedUris<<child->uri();
-                m_model->m_root_item->onChildRemoved(child->uri());
-            }
+void FileItem::reconcileChildren(const QList<std::shared_ptr<FileInfo>> &infos,
+                                 const QHash<QString, QPair<quint64, quint64>> &stats)
+{
+    flushPendingChildren();
+
+    QSet<QString> currentKeys;
+    currentKeys.reserve(infos.count());
+    for (auto info : infos) {
+        currentKeys.insert(FileItemModel::uriKey(info->uri()));
+    }
+
+    //remove first, so that the rows found later are not shifted.
+    QVector<int> removedRows;
+    int count = m_store? m_store->count(): m_children->count();
+    for (int row = 0; row < count; row++) {
+        auto key = m_store? FileItemModel::uriKey(m_store->uri(row)): m_children->at(row)->m_uri_key;
+        if (!currentKeys.contains(key))
+            removedRows<<row;
+    }
+    removeChildRows(removedRows);
+
+    QList<std::shared_ptr<FileInfo>> addedInfos;
+    QStringList unloadedUris;
+    int first = -1;
+    int last = -1;
+    for (auto info : infos) {
+        //the info could not be loaded while enumerating, query it later.
+        if (info->isEmptyInfo()) {
+            unloadedUris<<info->uri();
+            continue;
         }
 
-        for (auto uri : currentUris) {
-            if (!rawUris.contains(uri)) {
-                addedUris<<uri;
-                m_model->m_root_item->onChildAdded(uri);
+        int row = -1;
+        bool changed = false;
+        if (m_store) {
+            row = m_store->indexOf(info->uri());
+            if (row >= 0) {
+                changed = m_store->modifiedTime(row) != info->modifiedTime() || m_store->size(row) != info->size();
+                if (changed)
+                    m_store->update(row, info);
             }
+        } else {
+            auto key = FileItemModel::uriKey(info->uri());
+            auto child = m_child_index.value(key);
+            if (child) {
+                row = m_model->rowOf(child);
+                auto it = stats.find(key);
+                changed = it == stats.end() || it->first != info->modifiedTime() || it->second != info->size();
+            }
+        }
+
+        if (row < 0) {
+            addedInfos<<info;
+            continue;
         }
+        if (!changed)
+            continue;
+        first = first < 0? row: qMin(first, row);
+        last = qMax(last, row);
+        if (!m_store || m_materialized.contains(info->uri()))
+            ThumbnailManager::getInstance()->createThumbnail(info->uri(), m_thumbnail_watcher, true);
+    }
+
+    if (first >= 0) {
+        auto parent = firstColumnIndex();
+        Q_EMIT m_model->dataChanged(m_model->index(first, 0, parent), m_model->index(last, FileItemModel::Other, parent));
+    }
 
-        for (auto uri : currentUris) {
-            if (!addedUris.contains(uri) && !removedUris.contains(uri)) {
-                //m_model->m_root_item->getChildFromUri(uri)->updateInfoAsync();
+    if (m_store) {
+        appendVirtualChildren(addedInfos);
+    } else if (!addedInfos.isEmpty()) {
+        m_model->beginInsertRows(firstColumnIndex(), m_children->count(), m_children->count() + addedInfos.count() - 1);
+        for (auto info : addedInfos) {
+            appendChild(new FileItem(info, this, m_model));
+        }
+        m_model->endInsertRows();
+        for (auto info : addedInfos) {
+            ThumbnailManager::getInstance()->createThumbnail(info->uri(), m_thumbnail_watcher);
+        }
+    }
+
+    QStringList unloadedAddedUris;
+    QStringList unloadedKeptUris;
+    for (auto uri : unloadedUris) {
+        bool existed = m_store? m_store->indexOf(uri) >= 0: getChildFromUri(uri) != nullptr;
+        if (existed)
+            unloadedKeptUris<<uri;
+        else
+            unloadedAddedUris<<uri;
+    }
+    insertChildrenAsync(unloadedAddedUris);
+    updateChildrenAsync(unloadedKeptUris);
+
+    if (!removedRows.isEmpty() || !addedInfos.isEmpty() || first >= 0)
+        Q_EMIT m_model->updated();
+}
+
+void FileItem::removeChildRows(const QVector<int> &rows)
+{
+    if (rows.isEmpty())
+        return;
+
+    QList<QPair<int, int>> ranges;
+    for (int row : rows) {
+        if (!ranges.isEmpty() && ranges.last().second + 1 == row)
+            ranges.last().second = row;
+        else
+            ranges<<qMakePair(row, row);
+    }
+
+    auto releaseRow = [=](int row) {
+        if (m_store) {
+            auto uri = m_store->uri(row);
+            if (m_materialized.contains(uri))
+                m_materialized.take(uri).item->deleteLater();
+            return;
+        }
+        auto child = m_children->at(row);
+        auto it = m_child_index.find(child->m_uri_key);
+        if (it != m_child_index.end() && it.value() == child)
+            m_child_index.erase(it);
+        delete child;
+    };
+
+    //too many ranges in a huge directory, removing them one by one costs more
+    //than resetting the model. a layout change must not change the row count,
+    //so the rows can not be compacted in one.
+    if (ranges.count() > PEONY_RECONCILE_MAX_RANGES && !m_parent) {
+        m_model->beginResetModel();
+        for (int row : rows) {
+            releaseRow(row);
+        }
+        if (m_store) {
+            m_store->removeRows(rows);
+        } else {
+            QVector<FileItem*> children;
+            children.reserve(m_children->count() - rows.count());
+            int next = 0;
+            for (int row = 0; row < m_children->count(); row++) {
+                if (next < rows.count() && rows.at(next) == row) {
+                    next++;
+                    continue;
+                }
+                children<<m_children->at(row);
             }
+            *m_children = children;
         }
+        m_model->endResetModel();
+        return;
+    }
 
-        enumerator->deleteLater();
+    //remove from bottom, the rows of upper ranges are not changed.
+    auto parent = firstColumnIndex();
+    for (int i = ranges.count() - 1; i >= 0; i--) {
+        int first = ranges.at(i).first;
+        int last = ranges.at(i).second;
+        m_model->beginRemoveRows(parent, first, last);
+        for (int row = first; row <= last; row++) {
+            releaseRow(row);
+        }
+        if (m_store)
+            m_store->remove(first, last - first + 1);
+        else
+            m_children->remove(first, last - first + 1);
+        m_model->endRemoveRows();
+    }
+}
+
+void FileItem::insertChildrenAsync(const QStringList &uris)
+{
+    if (uris.isEmpty())
+        return;
+
+    auto job = new FileInfoBatchJob(uris, this);
+    job->setAutoDelete();
+    connect(job, &FileInfoBatchJob::chunkUpdated, this, [=](const QList<std::shared_ptr<FileInfo>> &chunk) {
+        if (m_store) {
+            appendVirtualChildren(chunk);
+            return;
+        }
+
+        QList<std::shared_ptr<FileInfo>> infos;
+        for (auto info : chunk) {
+            if (!getChildFromUri(info->uri()))
+                infos<<info;
+        }
+        if (infos.isEmpty())
+            return;
+
+        m_model->beginInsertRows(firstColumnIndex(), m_children->count(), m_children->count() + infos.count() - 1);
+        for (auto info : infos) {
+            appendChild(new FileItem(info, this, m_model));
+        }
+        m_model->endInsertRows();
+
+        for (auto info : infos) {
+            ThumbnailManager::getInstance()->createThumbnail(info->uri(), m_thumbnail_watcher);
+        }
     });
+    job->queryAsync();
+}
 
-    enumerator->enumerateAsync();
+void FileItem::updateChildrenAsync(const QStringList &uris)
+{
+    QList<std::shared_ptr<FileInfo>> infos;
+    for (auto uri : uris) {
+        if (m_store) {
+            if (m_store->indexOf(uri) >= 0)
+                infos<<FileInfo::fromUri(uri);
+            continue;
+        }
+        auto child = getChildFromUri(uri);
+        if (child)
+            infos<<child->m_info;
+    }
+    if (infos.isEmpty())
+        return;
+
+    auto job = new FileInfoBatchJob(infos, this);
+    job->setAutoDelete();
+    connect(job, &FileInfoBatchJob::chunkUpdated, this, [=](const QList<std::shared_ptr<FileInfo>> &chunk) {
+        int first = -1;
+        int last = -1;
+        for (auto info : chunk) {
+            if (m_store) {
+                int row = m_store->indexOf(info->uri());
+                if (row < 0)
+                    continue;
+                m_store->update(row, info);
+                first = first < 0? row: qMin(first, row);
+                last = qMax(last, row);
+                if (m_materialized.contains(info->uri()))
+                    ThumbnailManager::getInstance()->createThumbnail(info->uri(), m_thumbnail_watcher, true);
+                continue;
+            }
+            auto child = getChildFromUri(info->uri());
+            if (!child)
+                continue;
+            int row = m_model->rowOf(child);
+            first = first < 0? row: qMin(first, row);
+            last = qMax(last, row);
+            ThumbnailManager::getInstance()->createThumbnail(info->uri(), m_thumbnail_watcher, true);
+        }
+        if (first < 0)
+            return;
+
+        //one dataChanged for the rows of whole chunk.
+        auto parent = firstColumnIndex();
+        Q_EMIT m_model->dataChanged(m_model->index(first, 0, parent), m_model->index(last, FileItemModel::Other, parent));
+    });
+    job->queryAsync();
 }
 
 void FileItem::updateInfoSync()
@@ -641,7 +1073,193 @@ void FileItem::clearChildren()
         delete child;
     }
     m_children->clear();
+    m_child_index.clear();
+    m_pending_infos.clear();
+    m_pending_keys.clear();
+    releaseMaterializedChildren();
+    delete m_store;
+    m_store = nullptr;
     m_expanded = false;
     m_watcher.reset();
     m_watcher = nullptr;
 }
+
+void FileItem::virtualize()
+{
+    if (m_store)
+        return;
+
+    m_model->beginResetModel();
+    m_store = new FileEntryStore(m_info->uri());
+    for (auto child : *m_children) {
+        m_store->append(child->m_info);
+        delete child;
+    }
+    m_children->clear();
+    m_children->squeeze();
+    m_child_index.clear();
+    m_model->endResetModel();
+}
+
+void FileItem::appendVirtualChildren(const QList<std::shared_ptr<FileInfo>> &infos)
+{
+    int first = -1;
+    int last = -1;
+    QList<std::shared_ptr<FileInfo>> addedInfos;
+    QSet<QString> addedUris;
+    for (auto info : infos) {
+        int row = m_store->indexOf(info->uri());
+        if (row >= 0) {
+            m_store->update(row, info);
+            first = first < 0? row: qMin(first, row);
+            last = qMax(last, row);
+            continue;
+        }
+        if (addedUris.contains(info->uri()))
+            continue;
+        addedUris.insert(info->uri());
+        addedInfos<<info;
+    }
+
+    auto parent = firstColumnIndex();
+    if (first >= 0) {
+        Q_EMIT m_model->dataChanged(m_model->index(first, 0, parent), m_model->index(last, FileItemModel::Other, parent));
+    }
+    if (addedInfos.isEmpty())
+        return;
+
+    int count = m_store->count();
+    m_model->beginInsertRows(parent, count, count + addedInfos.count() - 1);
+    for (auto info : addedInfos) {
+        m_store->append(info);
+    }
+    m_model->endInsertRows();
+}
+
+FileItem *FileItem::materializeChild(int row)
+{
+    if (!m_store || row < 0 || row >= m_store->count())
+        return nullptr;
+
+    auto uri = m_store->uri(row);
+    auto it = m_materialized.find(uri);
+    if (it != m_materialized.end()) {
+        it->tick = ++m_materialize_tick;
+        return it->item;
+    }
+
+    auto info = FileInfo::fromUri(uri);
+    auto child = new FileItem(info, this, m_model);
+    m_materialized.insert(uri, MaterializedChild{child, ++m_materialize_tick});
+
+    if (info->isEmptyInfo()) {
+        auto job = new FileInfoJob(info);
+        job->setAutoDelete();
+        connect(job, &FileInfoJob::infoUpdated, this, [=]() {
+            int row = m_store? m_store->indexOf(uri): -1;
+            if (row < 0)
+                return;
+            m_store->update(row, info);
+            auto parent = firstColumnIndex();
+            Q_EMIT m_model->dataChanged(m_model->index(row, 0, parent), m_model->index(row, FileItemModel::Other, parent));
+            ThumbnailManager::getInstance()->createThumbnail(uri, m_thumbnail_watcher);
+        });
+        job->queryAsync();
+    } else {
+        ThumbnailManager::getInstance()->createThumbnail(uri, m_thumbnail_watcher);
+    }
+
+    //release the least recently used half.
+    if (m_materialized.count() > PEONY_FILE_ENTRY_STORE_MAX_MATERIALIZED) {
+        QVector<quint64> ticks;
+        ticks.reserve(m_materialized.count());
+        for (auto materialized : m_materialized) {
+            ticks<<materialized.tick;
+        }
+        auto middle = ticks.begin() + ticks.count()/2;
+        std::nth_element(ticks.begin(), middle, ticks.end());
+        quint64 threshold = *middle;
+        for (auto it = m_materialized.begin(); it != m_materialized.end();) {
+            //the selected and current children are still used by the views.
+            if (it->tick < threshold && !m_model->isPinned(it.key())) {
+                it->item->deleteLater();
+                it = m_materialized.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    return child;
+}
+
+void FileItem::releaseMaterializedChildren()
+{
+    for (auto materialized : m_materialized) {
+        delete materialized.item;
+    }
+    m_materialized.clear();
+}
+
+void FileItem::queueChildren(const QList<std::shared_ptr<FileInfo>> &infos)
+{
+    for (auto info : infos) {
+        auto key = FileItemModel::uriKey(info->uri());
+        if (m_pending_keys.contains(key))
+            continue;
+        m_pending_keys.insert(key);
+        m_pending_infos<<info;
+    }
+    if (m_pending_infos.isEmpty())
+        return;
+
+    if (m_pending_infos.count() >= PEONY_INSERT_FLUSH_COUNT) {
+        flushPendingChildren();
+        return;
+    }
+
+    if (!m_flush_timer) {
+        m_flush_timer = new QTimer(this);
+        m_flush_timer->setSingleShot(true);
+        m_flush_timer->setInterval(PEONY_INSERT_FLUSH_INTERVAL);
+        connect(m_flush_timer, &QTimer::timeout, this, &FileItem::flushPendingChildren);
+    }
+    if (!m_flush_timer->isActive())
+        m_flush_timer->start();
+}
+
+void FileItem::flushPendingChildren()
+{
+    if (m_flush_timer)
+        m_flush_timer->stop();
+    if (m_pending_infos.isEmpty())
+        return;
+
+    auto pendingInfos = m_pending_infos;
+    m_pending_infos.clear();
+    m_pending_keys.clear();
+
+    if (m_store) {
+        appendVirtualChildren(pendingInfos);
+        return;
+    }
+
+    //the children might be added by other ways while waiting.
+    QList<std::shared_ptr<FileInfo>> infos;
+    for (auto info : pendingInfos) {
+        if (!getChildFromUri(info->uri()))
+            infos<<info;
+    }
+    if (infos.isEmpty())
+        return;
+
+    m_model->beginInsertRows(firstColumnIndex(), m_children->count(), m_children->count() + infos.count() - 1);
+    for (auto info : infos) {
+        appendChild(new FileItem(info, this, m_model));
+    }
+    m_model->endInsertRows();
+
+    for (auto info : infos) {
+        ThumbnailManager::getInstance()->createThumbnail(info->uri(), m_thumbnail_watcher);
+    }
+}
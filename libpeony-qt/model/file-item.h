@@ -28,6 +28,30 @@
 
 #include <QObject>
 #include <QVector>
+#include <QStringList>
+#include <QSet>
+#include <QHash>
+
+class QTimer;
+
+/*!
+ * \brief PEONY_RECONCILE_MAX_RANGES
+ * if the removed children of root item are scattered in more ranges than this,
+ * the model is reset instead of removing the ranges one by one.
+ */
+#define PEONY_RECONCILE_MAX_RANGES 64
+
+/*!
+ * \brief PEONY_INSERT_FLUSH_INTERVAL
+ * the children ready to be inserted are accumulated and inserted as one row range
+ * at most once in this interval (ms), about one frame.
+ */
+#define PEONY_INSERT_FLUSH_INTERVAL 16
+/*!
+ * \brief PEONY_INSERT_FLUSH_COUNT
+ * the accumulated children are inserted at once if there are so many of them.
+ */
+#define PEONY_INSERT_FLUSH_COUNT 1000
 
 namespace Peony {
 
@@ -37,6 +61,8 @@ class FileItemModel;
 class FileWatcher;
 class FileItemProxyFilterSortModel;
 class FileEnumerator;
+class FileEntryStore;
+struct FileSortKey;
 
 /*!
  * \brief The FileItem class
@@ -92,6 +118,22 @@ public:
 
     bool hasChildren();
 
+    /*!
+     * \brief isVirtual
+     * \return true if the children of this item are kept in a FileEntryStore.
+     * <br>
+     * When the root item of a model which can not expand children finds more
+     * children than FileItemModel::virtualThreshold(), it moves them into a
+     * FileEntryStore. The model reads the data of rows from the store, and a
+     * child FileItem is only created when it is required by
+     * FileItemModel::itemFromIndex(), such as painting or selecting the row.
+     * </br>
+     * \see FileEntryStore, materializeChild().
+     */
+    bool isVirtual() {
+        return m_store != nullptr;
+    }
+
 Q_SIGNALS:
     void cancelFindChildren();
     void childAdded(const QString &uri);
@@ -102,6 +144,13 @@ Q_SIGNALS:
 public Q_SLOTS:
     void onChildAdded(const QString &uri);
     void onChildRemoved(const QString &uri);
+    /*!
+     * \brief onChildChanged
+     * \param uri
+     * the changed children are updated by a FileInfoBatchJob after a short delay,
+     * so that a burst of changes only triggers one job.
+     */
+    void onChildChanged(const QString &uri);
     void onDeleted(const QString &thisUri);
     void onRenamed(const QString &oldUri, const QString &newUri);
 
@@ -120,6 +169,21 @@ protected:
      */
     FileItem *getChildFromUri(QString uri);
 
+    /*!
+     * \brief appendChild
+     * \param child
+     * add child to m_children and m_child_index.
+     * \note the rows of model should be inserted by caller.
+     */
+    void appendChild(FileItem *child);
+    void prependChild(FileItem *child);
+    /*!
+     * \brief removeChild
+     * \param child
+     * remove child from m_children and m_child_index, the child is not deleted.
+     */
+    void removeChild(FileItem *child);
+
     /*!
      * \brief updateInfoSync
      * <br>
@@ -140,6 +204,94 @@ protected:
      */
     void updateInfoAsync();
 
+    /*!
+     * \brief insertChildrenAsync
+     * \param uris
+     * <br>
+     * Query the infos of uris in a FileInfoBatchJob, and insert the children
+     * which not existed in this item chunk by chunk.
+     * </br>
+     */
+    void insertChildrenAsync(const QStringList &uris);
+    /*!
+     * \brief updateChildrenAsync
+     * \param uris
+     * <br>
+     * Refresh the infos of existed children in a FileInfoBatchJob,
+     * every updated chunk sends one dataChanged() for its rows.
+     * </br>
+     */
+    void updateChildrenAsync(const QStringList &uris);
+
+    /*!
+     * \brief virtualize
+     * move the children into a FileEntryStore, the model is reset.
+     */
+    void virtualize();
+    /*!
+     * \brief appendVirtualChildren
+     * \param infos
+     * update the existed children in store and append the others as one row range.
+     */
+    void appendVirtualChildren(const QList<std::shared_ptr<FileInfo>> &infos);
+    /*!
+     * \brief materializeChild
+     * \param row
+     * \return the child item of row in store, create it if needed.
+     * \note at most PEONY_FILE_ENTRY_STORE_MAX_MATERIALIZED children are kept,
+     * the least recently used ones are released, except the pinned ones.
+     * \see FileItemModel::setPinnedUris().
+     */
+    FileItem *materializeChild(int row);
+    void releaseMaterializedChildren();
+
+    /*!
+     * \brief reconcileChildren
+     * \param infos, the loaded infos of current children.
+     * \param stats, modified time and size of children before they were re-enumerated,
+     * keyed by FileItemModel::uriKey().
+     * <br>
+     * Diff the children with a hash in linear time, remove the gone ones with
+     * removeChildRows(), insert the new ones in one range, and emit dataChanged
+     * for the ones which modified time or size changed.
+     * </br>
+     * \see onUpdateDirectoryRequest().
+     */
+    void reconcileChildren(const QList<std::shared_ptr<FileInfo>> &infos,
+                           const QHash<QString, QPair<quint64, quint64>> &stats);
+    /*!
+     * \brief removeChildRows
+     * \param rows, sorted in ascending order.
+     * remove and delete children at rows, contiguous rows are removed in one range.
+     * if the children of root item are removed in more than PEONY_RECONCILE_MAX_RANGES
+     * ranges, the model is reset once instead.
+     */
+    void removeChildRows(const QVector<int> &rows);
+
+    /*!
+     * \brief queueChildren
+     * \param infos, the loaded infos of new children.
+     * <br>
+     * Accumulate the new children and insert them with flushPendingChildren()
+     * in one contiguous row range, once per PEONY_INSERT_FLUSH_INTERVAL or every
+     * PEONY_INSERT_FLUSH_COUNT children. A single row insertion makes the proxy
+     * model and views relayout, this keeps the views responsive while a large
+     * directory is loading or many files are created.
+     * </br>
+     * \note updated() is not emitted here, the proxy model places the inserted
+     * rows incrementally, a full resort is only done when loading finished.
+     */
+    void queueChildren(const QList<std::shared_ptr<FileInfo>> &infos);
+    void flushPendingChildren();
+
+    /*!
+     * \brief insertSnapshotChildren
+     * \param infos, the warm prefetched children or the children of snapshot.
+     * they are shown before the enumeration and revalidated by it.
+     * \see m_snapshot_uris.
+     */
+    void insertSnapshotChildren(const QList<std::shared_ptr<FileInfo>> &infos);
+
 private:
     FileItem *m_parent = nullptr;
     std::shared_ptr<Peony::FileInfo> m_info;
@@ -147,11 +299,34 @@ private:
 
     FileItemModel *m_model = nullptr;
 
+    /*!
+     * \brief m_row
+     * cached row in parent's children, maintained by FileItemModel::rowOf().
+     */
+    mutable int m_row = -1;
+    QString m_uri_key;
+
+    /*!
+     * \brief m_child_index
+     * children keyed by FileItemModel::uriKey(), see getChildFromUri().
+     */
+    QHash<QString, FileItem*> m_child_index;
+
+    QList<std::shared_ptr<FileInfo>> m_pending_infos;
+    QSet<QString> m_pending_keys;
+    QTimer *m_flush_timer = nullptr;
+
     bool m_expanded = false;
 
     std::shared_ptr<FileWatcher> m_watcher = nullptr;
     std::shared_ptr<FileWatcher> m_thumbnail_watcher = nullptr;
 
+    /*!
+     * \brief m_sort_key
+     * \see FileItemProxyFilterSortModel::sortKey().
+     */
+    std::shared_ptr<FileSortKey> m_sort_key;
+
     /*!
      * \brief m_async_count
      * <br>
@@ -168,6 +343,40 @@ private:
      * only used in directory not support monitor.
      */
     FileEnumerator *m_backend_enumerator;
+
+    /*!
+     * \brief m_changed_uris
+     * the children changed uris waiting for updating.
+     * \see onChildChanged().
+     */
+    QStringList m_changed_uris;
+
+    /*!
+     * \brief m_snapshot_uris
+     * the children loaded from directory snapshot, which have not
+     * been revalidated by enumeration yet.
+     * \see DirectorySnapshotCache.
+     */
+    QSet<QString> m_snapshot_uris;
+    /*!
+     * \brief m_snapshot_connection
+     * connected to DirectorySnapshotCache::snapshotLoaded() while the snapshot
+     * of this directory is loading.
+     */
+    QMetaObject::Connection m_snapshot_connection;
+
+    /*!
+     * \brief m_store
+     * the children of a virtual item, see isVirtual().
+     */
+    FileEntryStore *m_store = nullptr;
+    struct MaterializedChild
+    {
+        FileItem *item;
+        quint64 tick;
+    };
+    QHash<QString, MaterializedChild> m_materialized;
+    quint64 m_materialize_tick = 0;
 };
 
 }
@@ -137,6 +137,7 @@ void FileLabelModel::addLabel(const QString &label, const QColor &color)
     item->m_color = color;
 
     m_labels.append(item);
+    m_label_hash.insert(item->m_id, item);
 
     addId();
 
@@ -163,12 +164,10 @@ void FileLabelModel::removeLabel(int id)
 {
     beginResetModel();
 
-    for (auto item : m_labels) {
-        if (item->id() == id) {
-            m_labels.removeOne(item);
-            item->deleteLater();
-            break;
-        }
+    auto item = m_label_hash.take(id);
+    if (item) {
+        m_labels.removeOne(item);
+        item->deleteLater();
     }
 
     m_label_settings->beginWriteArray("labels");
@@ -182,25 +181,21 @@ void FileLabelModel::removeLabel(int id)
 
 void FileLabelModel::setLabelName(int id, const QString &name)
 {
-    for (auto item : m_labels) {
-        if (item->id() == id) {
-            item->setName(name);
-            int row = m_labels.indexOf(item);
-            Q_EMIT dataChanged(index(row), index(row));
-            break;
-        }
+    auto item = itemFromId(id);
+    if (item) {
+        item->setName(name);
+        int row = m_labels.indexOf(item);
+        Q_EMIT dataChanged(index(row), index(row));
     }
 }
 
 void FileLabelModel::setLabelColor(int id, const QColor &color)
 {
-    for (auto item : m_labels) {
-        if (item->id() == id) {
-            item->setColor(color);
-            int row = m_labels.indexOf(item);
-            Q_EMIT dataChanged(index(row), index(row));
-            break;
-        }
+    auto item = itemFromId(id);
+    if (item) {
+        item->setColor(color);
+        int row = m_labels.indexOf(item);
+        Q_EMIT dataChanged(index(row), index(row));
     }
 }
 
@@ -208,11 +203,11 @@ const QList<int> FileLabelModel::getFileLabelIds(const QString &uri)
 {
     QList<int> l;
     auto metaInfo = Peony::FileMetaInfo::fromUri(uri);
-    if (! metaInfo || metaInfo->getMetaInfoVariant(PEONY_FILE_LABEL_IDS).isNull())
+    if (! metaInfo)
         return l;
-    auto labels = metaInfo->getMetaInfoStringList(PEONY_FILE_LABEL_IDS);
-    for (auto label : labels) {
-        l<<label.toInt();
+    //label ids have been parsed when the meta info loaded.
+    for (auto id : metaInfo->getLabelIds()) {
+        l<<id;
     }
     return l;
 }
@@ -221,11 +216,9 @@ const QStringList FileLabelModel::getFileLabels(const QString &uri)
 {
     QStringList l;
     auto metaInfo = Peony::FileMetaInfo::fromUri(uri);
-    if (! metaInfo || metaInfo->getMetaInfoVariant(PEONY_FILE_LABEL_IDS).isNull())
+    if (! metaInfo)
         return l;
-    auto labels = metaInfo->getMetaInfoStringList(PEONY_FILE_LABEL_IDS);
-    for (auto label : labels) {
-        auto id = label.toInt();
+    for (auto id : metaInfo->getLabelIds()) {
         auto item = itemFromId(id);
         if (item) {
             l<<item->name();
@@ -238,11 +231,9 @@ const QList<QColor> FileLabelModel::getFileColors(const QString &uri)
 {
     QList<QColor> l;
     auto metaInfo = Peony::FileMetaInfo::fromUri(uri);
-    if (! metaInfo || metaInfo->getMetaInfoVariant(PEONY_FILE_LABEL_IDS).isNull())
+    if (! metaInfo)
         return l;
-    auto labels = metaInfo->getMetaInfoStringList(PEONY_FILE_LABEL_IDS);
-    for (auto label : labels) {
-        auto id = label.toInt();
+    for (auto id : metaInfo->getLabelIds()) {
         auto item = itemFromId(id);
         if (item) {
             l<<item->color();
@@ -253,12 +244,7 @@ const QList<QColor> FileLabelModel::getFileColors(const QString &uri)
 
 FileLabelItem *FileLabelModel::itemFromId(int id)
 {
-    for (auto item : this->m_labels) {
-        if (id == item->id()) {
-            return item;
-        }
-    }
-    return nullptr;
+    return m_label_hash.value(id);
 }
 
 FileLabelItem *FileLabelModel::itemFormIndex(const QModelIndex &index)
@@ -274,6 +260,86 @@ QList<FileLabelItem *> FileLabelModel::getAllFileLabelItems()
     return m_labels;
 }
 
+void FileLabelModel::updateFileLabelIndex(const QString &uri, const QVector<int> &labelIds)
+{
+    QMutexLocker locker(&m_index_mutex);
+    if (m_file_label_ids.value(uri) == labelIds)
+        return;
+
+    takeFileLabelIndex(uri);
+    insertFileLabelIndex(uri, labelIds);
+}
+
+void FileLabelModel::removeFileLabelIndex(const QString &uri)
+{
+    if (!global_instance)
+        return;
+    QMutexLocker locker(&global_instance->m_index_mutex);
+    global_instance->takeFileLabelIndex(uri);
+}
+
+void FileLabelModel::renameFileLabelIndex(const QString &oldUri, const QString &newUri)
+{
+    if (!global_instance)
+        return;
+    QMutexLocker locker(&global_instance->m_index_mutex);
+    auto labelIds = global_instance->takeFileLabelIndex(oldUri);
+    global_instance->takeFileLabelIndex(newUri);
+    global_instance->insertFileLabelIndex(newUri, labelIds);
+}
+
+QVector<int> FileLabelModel::takeFileLabelIndex(const QString &uri)
+{
+    auto labelIds = m_file_label_ids.take(uri);
+    for (auto id : labelIds) {
+        auto it = m_label_uris.find(id);
+        if (it != m_label_uris.end()) {
+            it->remove(uri);
+            if (it->isEmpty())
+                m_label_uris.erase(it);
+        }
+    }
+    return labelIds;
+}
+
+void FileLabelModel::insertFileLabelIndex(const QString &uri, const QVector<int> &labelIds)
+{
+    if (labelIds.isEmpty())
+        return;
+
+    m_file_label_ids.insert(uri, labelIds);
+    for (auto id : labelIds) {
+        m_label_uris[id].insert(uri);
+    }
+}
+
+const QSet<QString> FileLabelModel::getLabelFileUris(int labelId)
+{
+    QMutexLocker locker(&m_index_mutex);
+    return m_label_uris.value(labelId);
+}
+
+bool FileLabelModel::fileHasLabels(const QString &uri, const QList<int> &labelIds)
+{
+    QMutexLocker locker(&m_index_mutex);
+    for (auto id : labelIds) {
+        auto it = m_label_uris.constFind(id);
+        if (it != m_label_uris.constEnd() && it->contains(uri))
+            return true;
+    }
+    return false;
+}
+
+const QList<int> FileLabelModel::getLabelIds(const QStringList &names, const QList<QColor> &colors)
+{
+    QList<int> l;
+    for (auto item : m_labels) {
+        if (names.contains(item->name()) || colors.contains(item->color()))
+            l<<item->id();
+    }
+    return l;
+}
+
 void FileLabelModel::addLabelToFile(const QString &uri, int labelId)
 {
     auto metaInfo = Peony::FileMetaInfo::fromUri(uri);
@@ -283,6 +349,7 @@ void FileLabelModel::addLabelToFile(const QString &uri, int labelId)
     labelIds<<QString::number(labelId);
     labelIds.removeDuplicates();
     metaInfo->setMetaInfoStringList(PEONY_FILE_LABEL_IDS, labelIds);
+    updateFileLabelIndex(uri, metaInfo->getLabelIds());
     Q_EMIT fileLabelChanged(uri);
 }
 
@@ -300,6 +367,7 @@ void FileLabelModel::removeFileLabel(const QString &uri, int labelId)
         labelIds.removeOne(QString::number(labelId));
         metaInfo->setMetaInfoStringList(PEONY_FILE_LABEL_IDS, labelIds);
     }
+    updateFileLabelIndex(uri, metaInfo->getLabelIds());
     Q_EMIT fileLabelChanged(uri);
 }
 
@@ -418,6 +486,7 @@ void FileLabelModel::initLabelItems()
             item->setColor(color);
 
             m_labels.append(item);
+            m_label_hash.insert(i, item);
         }
     }
     m_label_settings->endArray();
@@ -25,6 +25,10 @@
 
 #include <QAbstractListModel>
 #include <QSettings>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <QMutex>
 
 #include <QColor>
 #include <peony-core_global.h>
@@ -61,6 +65,47 @@ public:
 
     QList<FileLabelItem *> getAllFileLabelItems();
 
+    /*!
+     * \brief updateFileLabelIndex
+     * \param uri
+     * \param labelIds
+     * \details
+     * Record the label ids of a file in the label index. FileInfoJob calls this
+     * every time a file's meta info is loaded, so the index always covers the
+     * files which are known by FileInfoManager.
+     */
+    void updateFileLabelIndex(const QString &uri, const QVector<int> &labelIds);
+    /*!
+     * \brief getLabelFileUris
+     * \param labelId
+     * \return the uris of the loaded files which have the label.
+     */
+    const QSet<QString> getLabelFileUris(int labelId);
+    /*!
+     * \brief fileHasLabels
+     * \return true if the file has any one of the labels.
+     * \note
+     * This only does set lookups in the reverse label index, it is designed for
+     * filtering a large amount of rows.
+     */
+    bool fileHasLabels(const QString &uri, const QList<int> &labelIds);
+    /*!
+     * \brief removeFileLabelIndex
+     * \param uri
+     * remove a file from the label index, when it is deleted or its info is released.
+     * \note this does nothing if the global model is not created, it can be called
+     * in any thread.
+     */
+    static void removeFileLabelIndex(const QString &uri);
+    /*!
+     * \brief renameFileLabelIndex
+     * move the label ids of a renamed file to its new uri.
+     * \see removeFileLabelIndex().
+     */
+    static void renameFileLabelIndex(const QString &oldUri, const QString &newUri);
+
+    const QList<int> getLabelIds(const QStringList &names, const QList<QColor> &colors);
+
     // Basic functionality:
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
 
@@ -88,6 +133,12 @@ public Q_SLOTS:
 protected:
     void initLabelItems();
     void addId();
+    /*!
+     * \brief takeFileLabelIndex
+     * \return the label ids of uri removed from the index, called with m_index_mutex locked.
+     */
+    QVector<int> takeFileLabelIndex(const QString &uri);
+    void insertFileLabelIndex(const QString &uri, const QVector<int> &labelIds);
 
 private:
     explicit FileLabelModel(QObject *parent = nullptr);
@@ -96,6 +147,15 @@ private:
     QSettings *m_label_settings;
 
     QList<FileLabelItem *> m_labels;
+    QHash<int, FileLabelItem *> m_label_hash;
+
+    /*!
+     * \brief m_file_label_ids
+     * uri -> label ids, and the reverse label id -> uris index.
+     */
+    QHash<QString, QVector<int>> m_file_label_ids;
+    QHash<int, QSet<QString>> m_label_uris;
+    QMutex m_index_mutex;
 };
 
 class PEONYCORESHARED_EXPORT FileLabelItem : public QObject
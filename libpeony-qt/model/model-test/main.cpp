@@ -21,6 +21,7 @@
  */
 
 #include "mainwindow.h"
+#include "model-benchmark.h"
 #include <QApplication>
 #include <file-item-proxy-filter-sort-model.h>
 #include <file-item-model.h>
@@ -50,6 +51,14 @@
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+
+    QStringList args = a.arguments();
+    if (args.contains(PEONY_BENCHMARK_ARGUMENT)) {
+        //model-test --benchmark [names...]
+        args = args.mid(args.indexOf(PEONY_BENCHMARK_ARGUMENT) + 1);
+        return runBenchmarks(args);
+    }
+
     MainWindow w;
     QToolBar t;
     QLineEdit e;
@@ -0,0 +1,610 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "model-benchmark.h"
+
+#include "file-info.h"
+#include "file-info-job.h"
+#include "file-item.h"
+#include "file-item-model.h"
+#include "file-item-proxy-filter-sort-model.h"
+#include "local-file-enumerator.h"
+
+#include <QElapsedTimer>
+#include <QtConcurrent>
+#include <QEventLoop>
+#include <QFile>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <QUrl>
+
+#include <memory>
+
+#include <QDebug>
+
+using namespace Peony;
+
+#define BENCHMARK_CHILDREN_COUNT 100000
+#define BENCHMARK_LOCAL_CHILDREN_COUNT 200000
+#define BENCHMARK_LOCAL_ENUMERATE_MIN_SPEEDUP 3
+
+static QString benchmark_directory_uri()
+{
+    //the files are never created, the benchmarks must not touch the file system.
+    return "file:///tmp/peony-model-benchmark-not-existed";
+}
+
+static QStringList benchmark_children_uris(int count, const QString &dir = benchmark_directory_uri())
+{
+    QStringList uris;
+    uris.reserve(count);
+    for (int i = 0; i < count; i++) {
+        uris<<QString("%1/file-%2.txt").arg(dir).arg(i);
+    }
+    return uris;
+}
+
+static GFileInfo *benchmark_g_file_info(int i)
+{
+    GFileInfo *g_info = g_file_info_new();
+    QByteArray name = QString("file-%1.txt").arg(i).toUtf8();
+    g_file_info_set_name(g_info, name.constData());
+    g_file_info_set_display_name(g_info, name.constData());
+    g_file_info_set_file_type(g_info, G_FILE_TYPE_REGULAR);
+    g_file_info_set_content_type(g_info, "text/plain");
+    g_file_info_set_size(g_info, i*1024);
+    g_file_info_set_attribute_uint64(g_info, G_FILE_ATTRIBUTE_TIME_MODIFIED, 1600000000 + i);
+    return g_info;
+}
+
+/*!
+ * \brief benchmark_file_info
+ * creating infos must not query anything, and the lazy display strings
+ * must be safe to format in workers while ui thread refreshes the infos.
+ */
+static bool benchmark_file_info()
+{
+    auto uris = benchmark_children_uris(BENCHMARK_CHILDREN_COUNT);
+
+    QElapsedTimer timer;
+    timer.start();
+    QList<std::shared_ptr<FileInfo>> infos;
+    infos.reserve(uris.count());
+    for (auto uri : uris) {
+        infos<<FileInfo::fromUri(uri);
+    }
+    qInfo()<<"file-info: create"<<infos.count()<<"infos"<<timer.elapsed()<<"ms";
+
+    //none of them is loaded, or the creation did i/o.
+    for (auto info : infos) {
+        if (info->isLoaded()) {
+            qWarning()<<"file-info: a newly created info is loaded"<<info->uri();
+            return false;
+        }
+    }
+
+    timer.restart();
+    for (int i = 0; i < infos.count(); i++) {
+        GFileInfo *g_info = benchmark_g_file_info(i);
+        FileInfoJob::refreshInfoContents(infos.at(i).get(), g_info);
+        g_object_unref(g_info);
+    }
+    qInfo()<<"file-info: refresh"<<infos.count()<<"infos"<<timer.elapsed()<<"ms";
+
+    //format the display strings in workers while they are refreshed here.
+    timer.restart();
+    auto future = QtConcurrent::map(infos, [](const std::shared_ptr<FileInfo> &info) {
+        info->fileSize();
+        info->modifiedDate();
+        info->fileType();
+    });
+    for (int i = 0; i < infos.count(); i++) {
+        GFileInfo *g_info = benchmark_g_file_info(i);
+        FileInfoJob::refreshInfoContents(infos.at(i).get(), g_info);
+        g_object_unref(g_info);
+    }
+    future.waitForFinished();
+    qInfo()<<"file-info: refresh while formatting in workers"<<timer.elapsed()<<"ms";
+
+    timer.restart();
+    for (auto info : infos) {
+        if (info->fileSize().isEmpty() || info->modifiedDate().isEmpty() || !info->isLoaded() || info->isDir()) {
+            qWarning()<<"file-info: wrong display strings"<<info->uri();
+            return false;
+        }
+    }
+    qInfo()<<"file-info: format display strings"<<timer.elapsed()<<"ms";
+    return true;
+}
+
+/*!
+ * \brief benchmark_file_type
+ * isDir() of an info which is never loaded must not block on a query.
+ */
+static bool benchmark_file_type()
+{
+    auto uris = benchmark_children_uris(BENCHMARK_CHILDREN_COUNT);
+    QList<std::shared_ptr<FileInfo>> infos;
+    infos.reserve(uris.count());
+    for (auto uri : uris) {
+        infos<<FileInfo::fromUri(uri);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    int dirs = 0;
+    for (auto info : infos) {
+        if (info->isDir() || info->isVolume())
+            dirs++;
+    }
+    qInfo()<<"file-type: isDir() of"<<infos.count()<<"unloaded infos"<<timer.elapsed()<<"ms";
+
+    //the types are unknown until the async queries finished.
+    if (dirs != 0) {
+        qWarning()<<"file-type: the types are resolved synchronously";
+        return false;
+    }
+    return true;
+}
+
+/*!
+ * \brief The BenchmarkRootItem class
+ * a root item which children are appended directly, as virtual rows or
+ * as child items, they are not enumerated.
+ */
+class BenchmarkRootItem : public FileItem
+{
+public:
+    explicit BenchmarkRootItem(const std::shared_ptr<FileInfo> &info, FileItemModel *model) : FileItem(info, nullptr, model) {}
+
+    void appendChildren(const QList<std::shared_ptr<FileInfo>> &infos) {
+        virtualize();
+        appendVirtualChildren(infos);
+    }
+
+    void appendChildItems(const QList<std::shared_ptr<FileInfo>> &infos) {
+        int count = m_children->count();
+        m_model->beginInsertRows(QModelIndex(), count, count + infos.count() - 1);
+        for (auto info : infos) {
+            appendChild(new FileItem(info, this, m_model));
+        }
+        m_model->endInsertRows();
+    }
+
+    void removeRows(const QVector<int> &rows) {
+        removeChildRows(rows);
+    }
+};
+
+/*!
+ * \brief benchmark_wait
+ * run the event loop until signal of sender is emitted, or it timed out.
+ * \return false if it timed out.
+ */
+template <typename Sender, typename Signal>
+static bool benchmark_wait(Sender *sender, Signal signal, int timeout = 30000)
+{
+    QEventLoop loop;
+    bool emitted = false;
+    QObject::connect(sender, signal, &loop, [&]() {
+        emitted = true;
+        loop.quit();
+    });
+    QTimer::singleShot(timeout, &loop, &QEventLoop::quit);
+    loop.exec();
+    return emitted;
+}
+
+/*!
+ * \brief benchmark_loaded_infos
+ * \return loaded infos of the children [first, first + count) of dirUri,
+ * in a shuffled name order.
+ */
+static QList<std::shared_ptr<FileInfo>> benchmark_loaded_infos(const QString &dirUri, int first, int count)
+{
+    auto uris = benchmark_children_uris(first + count, dirUri);
+    QList<std::shared_ptr<FileInfo>> infos;
+    infos.reserve(count);
+    for (int i = 0; i < count; i++) {
+        //7919 is a prime, so that every child is used once.
+        int j = first + int(qint64(i)*7919%count);
+        auto info = FileInfo::fromUri(uris.at(j));
+        GFileInfo *g_info = benchmark_g_file_info(j);
+        FileInfoJob::refreshInfoContents(info.get(), g_info);
+        g_object_unref(g_info);
+        infos<<info;
+    }
+    return infos;
+}
+
+/*!
+ * \brief benchmark_load_model
+ * set an empty directory as the root of model, then append count children
+ * of it, as virtual rows or as child items.
+ */
+static BenchmarkRootItem *benchmark_load_model(FileItemModel *model, const QString &dirUri, int count, bool isVirtual = true)
+{
+    auto item = new BenchmarkRootItem(FileInfo::fromUri(dirUri), model);
+    QTimer::singleShot(0, model, [=]() {
+        model->setRootItem(item);
+    });
+    if (!benchmark_wait(model, &FileItemModel::findChildrenFinished))
+        return nullptr;
+
+    auto infos = benchmark_loaded_infos(dirUri, 0, count);
+    if (isVirtual)
+        item->appendChildren(infos);
+    else
+        item->appendChildItems(infos);
+    return item;
+}
+
+/*!
+ * \brief The BenchmarkProxyModel class
+ * a proxy which counts the filtered rows.
+ */
+class BenchmarkProxyModel : public FileItemProxyFilterSortModel
+{
+public:
+    int filteredRows = 0;
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override {
+        const_cast<BenchmarkProxyModel *>(this)->filteredRows++;
+        return FileItemProxyFilterSortModel::filterAcceptsRow(sourceRow, sourceParent);
+    }
+};
+
+static bool benchmark_is_sorted_by_name(FileItemProxyFilterSortModel *proxy)
+{
+    QString last;
+    for (int row = 0; row < proxy->rowCount(); row++) {
+        auto name = proxy->index(row, 0).data().toString().toLower();
+        if (name < last)
+            return false;
+        last = name;
+    }
+    return true;
+}
+
+/*!
+ * \brief benchmark_sort
+ * the virtual rows are compared without items, both placing the appended
+ * rows in a sorted proxy and the sort job of a column switch.
+ */
+static bool benchmark_sort()
+{
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        qWarning()<<"sort: can not create a temporary directory";
+        return false;
+    }
+    auto dirUri = QUrl::fromLocalFile(dir.path()).toString();
+
+    FileItemModel model;
+    BenchmarkProxyModel proxy;
+    proxy.setSourceModel(&model);
+    proxy.setUseDefaultNameSortOrder(false);
+    proxy.sort(FileItemModel::FileName);
+
+    QElapsedTimer timer;
+    timer.start();
+    auto item = benchmark_load_model(&model, dirUri, BENCHMARK_CHILDREN_COUNT);
+    if (!item) {
+        qWarning()<<"sort: the model is not loaded";
+        return false;
+    }
+    qInfo()<<"sort: append"<<model.rowCount()<<"rows to sorted proxy"<<timer.elapsed()<<"ms";
+    if (proxy.rowCount() != BENCHMARK_CHILDREN_COUNT || !benchmark_is_sorted_by_name(&proxy)) {
+        qWarning()<<"sort: the appended rows are not sorted";
+        return false;
+    }
+
+    //the root rows are sorted by the sort job, the result is applied once.
+    //applying it is the only part in ui thread, it is timed separately.
+    int layoutChanges = 0;
+    QElapsedTimer applyTimer;
+    qint64 applyTime = 0;
+    QObject::connect(&proxy, &QAbstractItemModel::layoutAboutToBeChanged, &proxy, [&]() {
+        applyTimer.start();
+    });
+    QObject::connect(&proxy, &QAbstractItemModel::layoutChanged, &proxy, [&]() {
+        applyTime = applyTimer.elapsed();
+        layoutChanges++;
+    });
+    for (auto column : {FileItemModel::FileSize, FileItemModel::FileName}) {
+        layoutChanges = 0;
+        timer.restart();
+        proxy.sort(column);
+        if (!benchmark_wait(&proxy, &QAbstractItemModel::layoutChanged)) {
+            qWarning()<<"sort: the sort job is not finished";
+            return false;
+        }
+        qInfo()<<"sort: sort"<<proxy.rowCount()<<"rows by column"<<column<<timer.elapsed()<<"ms, applied in"<<applyTime<<"ms,"<<layoutChanges<<"layout changes";
+        if (layoutChanges != 1) {
+            qWarning()<<"sort: the result is not applied with one layout change";
+            return false;
+        }
+    }
+
+    //sorting again with same column and order does not filter the rows again.
+    layoutChanges = 0;
+    proxy.filteredRows = 0;
+    timer.restart();
+    proxy.setUseDefaultNameSortOrder(false);
+    if (!benchmark_wait(&proxy, &QAbstractItemModel::layoutChanged)) {
+        qWarning()<<"sort: the sort job is not finished";
+        return false;
+    }
+    qInfo()<<"sort: sort"<<proxy.rowCount()<<"rows again"<<timer.elapsed()<<"ms, applied in"<<applyTime<<"ms,"<<proxy.filteredRows<<"rows filtered";
+    if (layoutChanges != 1 || proxy.filteredRows != 0) {
+        qWarning()<<"sort: the rows are filtered again to apply the result";
+        return false;
+    }
+
+    //the rows appended while sorting are placed into the result.
+    auto appendedInfos = benchmark_loaded_infos(dirUri, BENCHMARK_CHILDREN_COUNT, 1000);
+    layoutChanges = 0;
+    timer.restart();
+    proxy.sort(FileItemModel::FileName, Qt::DescendingOrder);
+    item->appendChildren(appendedInfos);
+    if (!benchmark_wait(&proxy, &QAbstractItemModel::layoutChanged)) {
+        qWarning()<<"sort: the sort job is not finished";
+        return false;
+    }
+    qInfo()<<"sort: sort"<<proxy.rowCount()<<"rows while appending"<<appendedInfos.count()<<"rows"<<timer.elapsed()<<"ms,"<<layoutChanges<<"layout changes";
+    if (layoutChanges != 1 || proxy.rowCount() != model.rowCount()) {
+        qWarning()<<"sort: the appended rows restarted the sort job";
+        return false;
+    }
+    proxy.sort(FileItemModel::FileName, Qt::AscendingOrder);
+    benchmark_wait(&proxy, &QAbstractItemModel::layoutChanged);
+    if (!benchmark_is_sorted_by_name(&proxy)) {
+        qWarning()<<"sort: the rows are not sorted by name";
+        return false;
+    }
+    return true;
+}
+
+/*!
+ * \brief benchmark_lookup_uris
+ * look up every uri with FileItemModel::indexFromUri(), and check the row
+ * points back to the uri.
+ */
+static bool benchmark_lookup_uris(FileItemModel *model, const QStringList &uris, const QString &name)
+{
+    QElapsedTimer timer;
+    timer.start();
+    QVector<QModelIndex> indexes;
+    indexes.reserve(uris.count());
+    for (auto uri : uris) {
+        indexes<<model->indexFromUri(uri);
+    }
+    qInfo()<<"index-from-uri:"<<name<<"look up"<<uris.count()<<"uris"<<timer.elapsed()<<"ms";
+
+    for (int i = 0; i < uris.count(); i++) {
+        auto index = indexes.at(i);
+        if (!index.isValid() || model->index(index.row(), 0).data(FileItemModel::UriRole).toString() != uris.at(i)) {
+            qWarning()<<"index-from-uri:"<<name<<"wrong index of"<<uris.at(i);
+            return false;
+        }
+    }
+    return true;
+}
+
+/*!
+ * \brief benchmark_index_from_uri
+ * the indexes are looked up by uri hash and cached rows, both for virtual
+ * rows and child items, also after scattered rows removed.
+ */
+static bool benchmark_index_from_uri()
+{
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        qWarning()<<"index-from-uri: can not create a temporary directory";
+        return false;
+    }
+    auto dirUri = QUrl::fromLocalFile(dir.path()).toString();
+    auto uris = benchmark_children_uris(BENCHMARK_CHILDREN_COUNT, dirUri);
+
+    {
+        FileItemModel model;
+        if (!benchmark_load_model(&model, dirUri, BENCHMARK_CHILDREN_COUNT)) {
+            qWarning()<<"index-from-uri: the model is not loaded";
+            return false;
+        }
+        if (!benchmark_lookup_uris(&model, uris, "virtual rows"))
+            return false;
+    }
+
+    FileItemModel model;
+    QElapsedTimer timer;
+    timer.start();
+    auto item = benchmark_load_model(&model, dirUri, BENCHMARK_CHILDREN_COUNT, false);
+    if (!item) {
+        qWarning()<<"index-from-uri: the model is not loaded";
+        return false;
+    }
+    qInfo()<<"index-from-uri: append"<<model.rowCount()<<"child items"<<timer.elapsed()<<"ms";
+    if (!benchmark_lookup_uris(&model, uris, "child items"))
+        return false;
+
+    //the rows after the removed ones are stale, the first lookup refreshes them.
+    //the rows are removed range by range first, then with one model reset.
+    QStringList remainingUris = uris;
+    for (int rangeCount : {PEONY_RECONCILE_MAX_RANGES, PEONY_RECONCILE_MAX_RANGES + 1}) {
+        QVector<int> removedRows;
+        QSet<QString> removedUris;
+        for (int i = 0; i < rangeCount; i++) {
+            removedRows<<i*2;
+            removedUris<<model.index(i*2, 0).data(FileItemModel::UriRole).toString();
+        }
+        timer.restart();
+        item->removeRows(removedRows);
+        qInfo()<<"index-from-uri: remove"<<removedRows.count()<<"scattered rows"<<timer.elapsed()<<"ms";
+
+        QStringList keptUris;
+        for (auto uri : remainingUris) {
+            if (removedUris.contains(uri)) {
+                if (model.indexFromUri(uri).isValid()) {
+                    qWarning()<<"index-from-uri: a removed uri is still found"<<uri;
+                    return false;
+                }
+                continue;
+            }
+            keptUris<<uri;
+        }
+        remainingUris = keptUris;
+        if (model.rowCount() != remainingUris.count()) {
+            qWarning()<<"index-from-uri: wrong row count after removing"<<model.rowCount();
+            return false;
+        }
+        if (!benchmark_lookup_uris(&model, remainingUris, "child items after removing"))
+            return false;
+    }
+    return true;
+}
+
+/*!
+ * \brief benchmark_local_enumerate
+ * LocalFileEnumerator and GIO enumerate the same generated directory with
+ * the infos FileEnumerator needs, the fast path should be several times faster.
+ */
+static bool benchmark_local_enumerate()
+{
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        qWarning()<<"local-enumerate: can not create a temporary directory";
+        return false;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    QSet<QString> names;
+    names.reserve(BENCHMARK_LOCAL_CHILDREN_COUNT);
+    for (int i = 0; i < BENCHMARK_LOCAL_CHILDREN_COUNT; i++) {
+        auto name = QString("file-%1.txt").arg(i);
+        QFile file(dir.filePath(name));
+        if (!file.open(QIODevice::WriteOnly)) {
+            qWarning()<<"local-enumerate: can not create"<<file.fileName();
+            return false;
+        }
+        names<<name;
+    }
+    qInfo()<<"local-enumerate: create"<<names.count()<<"files"<<timer.elapsed()<<"ms";
+
+    GFile *g_dir = g_file_new_for_path(dir.path().toUtf8().constData());
+    if (!LocalFileEnumerator::isSupported(g_dir)) {
+        qWarning()<<"local-enumerate: the fast path does not support"<<dir.path();
+        g_object_unref(g_dir);
+        return false;
+    }
+
+    timer.restart();
+    GError *err = nullptr;
+    GFileEnumerator *g_enumerator = g_file_enumerate_children(g_dir,
+                                                              PEONY_FILE_INFO_QUERY_ATTRIBUTES,
+                                                              G_FILE_QUERY_INFO_NONE,
+                                                              nullptr,
+                                                              &err);
+    if (!g_enumerator) {
+        qWarning()<<"local-enumerate: can not enumerate with gio"<<(err? err->message: "");
+        if (err)
+            g_error_free(err);
+        g_object_unref(g_dir);
+        return false;
+    }
+    int gioCount = 0;
+    bool gioMatched = true;
+    while (GList *infos = g_file_enumerator_next_files(g_enumerator, 1000, nullptr, nullptr)) {
+        for (GList *l = infos; l; l = l->next) {
+            auto g_info = static_cast<GFileInfo *>(l->data);
+            gioMatched &= names.contains(QString::fromUtf8(g_file_info_get_name(g_info)));
+            gioCount++;
+        }
+        g_list_free_full(infos, g_object_unref);
+    }
+    g_object_unref(g_enumerator);
+    qint64 gioTime = timer.elapsed();
+
+    timer.restart();
+    LocalFileEnumerator enumerator(g_dir, true);
+    if (!enumerator.open()) {
+        qWarning()<<"local-enumerate: can not open the directory, errno"<<enumerator.error();
+        g_object_unref(g_dir);
+        return false;
+    }
+    int localCount = 0;
+    bool localMatched = true;
+    bool hasNext = true;
+    while (hasNext) {
+        QList<LocalFileEntry> children;
+        hasNext = enumerator.nextFiles(1000, children);
+        for (auto child : children) {
+            localMatched &= child.info && names.contains(child.uri.mid(child.uri.lastIndexOf('/') + 1));
+            if (child.info)
+                g_object_unref(child.info);
+            localCount++;
+        }
+    }
+    qint64 localTime = timer.elapsed();
+    g_object_unref(g_dir);
+
+    qInfo()<<"local-enumerate: gio"<<gioCount<<"children"<<gioTime<<"ms";
+    qInfo()<<"local-enumerate: local"<<localCount<<"children"<<localTime<<"ms";
+    if (gioCount != names.count() || !gioMatched || localCount != names.count() || !localMatched) {
+        qWarning()<<"local-enumerate: the children are not the generated files";
+        return false;
+    }
+    if (localTime*BENCHMARK_LOCAL_ENUMERATE_MIN_SPEEDUP > gioTime) {
+        qWarning()<<"local-enumerate: the fast path is less than"<<BENCHMARK_LOCAL_ENUMERATE_MIN_SPEEDUP<<"times faster";
+        return false;
+    }
+    return true;
+}
+
+int runBenchmarks(const QStringList &names)
+{
+    struct Benchmark {
+        const char *name;
+        bool (*run)();
+    };
+    static const Benchmark benchmarks[] = {
+        {"file-info", benchmark_file_info},
+        {"file-type", benchmark_file_type},
+        {"sort", benchmark_sort},
+        {"index-from-uri", benchmark_index_from_uri},
+        {"local-enumerate", benchmark_local_enumerate},
+    };
+
+    int failed = 0;
+    for (auto benchmark : benchmarks) {
+        if (!names.isEmpty() && !names.contains(benchmark.name))
+            continue;
+        qInfo()<<"benchmark"<<benchmark.name;
+        if (!benchmark.run()) {
+            qWarning()<<"benchmark"<<benchmark.name<<"failed";
+            failed++;
+        }
+    }
+    return failed == 0? 0: 1;
+}
@@ -0,0 +1,44 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef MODELBENCHMARK_H
+#define MODELBENCHMARK_H
+
+#include <QStringList>
+
+#define PEONY_BENCHMARK_ARGUMENT "--benchmark"
+
+/*!
+ * \brief runBenchmarks
+ * \param names, the benchmarks to run, all of them are run if it is empty.
+ * \return 0 if all benchmarks passed.
+ * \details
+ * The benchmarks are run instead of the test window when model-test is
+ * started with --benchmark, for example:
+ * <br>
+ * model-test --benchmark file-info
+ * </br>
+ * The results are printed with qInfo().
+ */
+int runBenchmarks(const QStringList &names);
+
+#endif // MODELBENCHMARK_H
@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui
+QT       += core gui concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -29,10 +29,12 @@ include(../../libpeony-qt.pri)
 
 SOURCES += \
         main.cpp \
-        mainwindow.cpp
+        mainwindow.cpp \
+        model-benchmark.cpp
 
 HEADERS += \
-        mainwindow.h
+        mainwindow.h \
+        model-benchmark.h
 
 # Default rules for deployment.
 #qnx: target.path = /tmp/$${TARGET}/bin
@@ -3,6 +3,7 @@ INCLUDEPATH += $$PWD
 #include(../file-operation/file-operation.pri)
 
 HEADERS += \
+    $$PWD/file-entry-store.h \
     $$PWD/file-item.h \
     $$PWD/file-item-model.h \
     $$PWD/file-item-proxy-filter-sort-model.h \
@@ -18,6 +19,7 @@ HEADERS += \
     $$PWD/side-bar-separator-item.h
 
 SOURCES += \
+    $$PWD/file-entry-store.cpp \
     $$PWD/file-item.cpp \
     $$PWD/file-item-model.cpp \
     $$PWD/file-item-proxy-filter-sort-model.cpp \
@@ -32,6 +32,7 @@
 #include "gobject-template.h"
 #include "linux-pwd-helper.h"
 #include "side-bar-separator-item.h"
+#include "target-uri-resolver.h"
 
 #include <QIcon>
 #include <QMessageBox>
@@ -132,6 +133,7 @@ void SideBarFileSystemItem::findChildren()
             goto end;
         }
 
+        QList<SideBarFileSystemItem *> addedItems;
         for (auto info: infos) {
             if (!info->displayName().startsWith(".") && (info->isDir() || info->isVolume())) {
                 isEmpty = false;
@@ -146,16 +148,17 @@ void SideBarFileSystemItem::findChildren()
                     this,
                     m_model,
                     this);
-            //check is mounted.
-            //FIXME: replace BLOCKING api in ui thread.
-            auto targetUri = FileUtils::getTargetUri(info->uri());
-            bool isUmountable = FileUtils::isFileUnmountable(info->uri());
-            item->m_is_mounted = (!targetUri.isEmpty() && (targetUri != "file:///")) || isUmountable;
             m_children->append(item);
+            addedItems<<item;
             //qDebug()<<info->uri();
         }
         m_model->insertRows(0, real_children_count, firstColumnIndex());
 
+        //check is mounted, the target uris are resolved asynchronously.
+        for (auto item : addedItems) {
+            item->updateMountedAsync();
+        }
+
         if (isEmpty) {
             auto separator = new SideBarSeparatorItem(SideBarSeparatorItem::EmptyFile, this, m_model);
             this->m_children->prepend(separator);
@@ -218,18 +221,22 @@ end:
             for (auto child : *m_children) {
                 if (child->uri() == uri) {
                     SideBarFileSystemItem *changedItem = static_cast<SideBarFileSystemItem*>(child);
-                    //FIXME: replace BLOCKING api in ui thread.
-                    if (FileUtils::getTargetUri(uri).isEmpty()) {
-                        changedItem->m_is_mounted = false;
-                        changedItem->clearChildren();
-                    } else {
-                        changedItem->m_is_mounted = true;
-                    }
-
-                    //why it would failed when send changed signal for newly mounted item?
-                    //m_model->dataChanged(changedItem->firstColumnIndex(), changedItem->firstColumnIndex());
-                    updateFileInfo(changedItem);
-                    m_model->dataChanged(changedItem->firstColumnIndex(), changedItem->lastColumnIndex());
+                    //the target uri changes with mounting.
+                    auto resolver = TargetUriResolver::getInstance();
+                    resolver->invalidate(uri);
+                    resolver->resolveAsync(uri, changedItem, [=](const QString &targetUri) {
+                        if (targetUri.isEmpty()) {
+                            changedItem->m_is_mounted = false;
+                            changedItem->clearChildren();
+                        } else {
+                            changedItem->m_is_mounted = true;
+                        }
+
+                        //why it would failed when send changed signal for newly mounted item?
+                        //m_model->dataChanged(changedItem->firstColumnIndex(), changedItem->firstColumnIndex());
+                        updateFileInfo(changedItem);
+                        m_model->dataChanged(changedItem->firstColumnIndex(), changedItem->lastColumnIndex());
+                    });
                     break;
                 }
             }
@@ -296,15 +303,33 @@ bool SideBarFileSystemItem::isMounted()
     return m_is_mounted;
 }
 
+void SideBarFileSystemItem::updateMountedAsync()
+{
+    bool isUmountable = FileUtils::isFileUnmountable(m_uri);
+    m_is_mounted = isUmountable;
+    TargetUriResolver::getInstance()->resolveAsync(m_uri, this, [=](const QString &targetUri) {
+        bool isMounted = (!targetUri.isEmpty() && (targetUri != "file:///")) || isUmountable;
+        if (isMounted == m_is_mounted)
+            return;
+        m_is_mounted = isMounted;
+        m_model->dataChanged(firstColumnIndex(), lastColumnIndex());
+    });
+}
+
 void SideBarFileSystemItem::eject(GMountUnmountFlags ejectFlag)
 {
-    //FIXME: replace BLOCKING api in ui thread.
+    TargetUriResolver::getInstance()->resolveAsync(m_uri, this, [=](const QString &target) {
+        ejectTarget(target, ejectFlag);
+    });
+}
+
+void SideBarFileSystemItem::ejectTarget(const QString &target, GMountUnmountFlags ejectFlag)
+{
     VolumeManager *volumeManager;
     std::shared_ptr<Drive> drive;
     GDrive *gdrive;
 
     auto file = wrapGFile(g_file_new_for_uri(this->uri().toUtf8().constData()));
-    auto target = FileUtils::getTargetUri(m_uri);
 
     volumeManager = VolumeManager::getInstance();
     drive = volumeManager->getDriveFromUri(target);
@@ -92,6 +92,13 @@ protected:
                                         GAsyncResult *res,
                                         SideBarFileSystemItem *p_this);
     void updateFileInfo(SideBarFileSystemItem *pThis);
+    /*!
+     * \brief updateMountedAsync
+     * update the mounted state with the target uri resolved asynchronously,
+     * the item must have been inserted.
+     */
+    void updateMountedAsync();
+    void ejectTarget(const QString &target, GMountUnmountFlags ejectFlag);
     static void ejectDevicebyDrive(GObject* object,GAsyncResult* res,SideBarFileSystemItem *pThis);
 
 private:
@@ -15,7 +15,17 @@ HEADERS += $$PWD/peony-core_global.h \
     $$PWD/thumbnail-manager.h \
     $$PWD/linux-pwd-helper.h \
     $$PWD/file-meta-info.h \
-    $$PWD/bookmark-manager.h
+    $$PWD/bookmark-manager.h \
+    $$PWD/content-type-cache.h \
+    $$PWD/desktop-file-cache.h \
+    $$PWD/file-info-batch-job.h \
+    $$PWD/directory-snapshot-cache.h \
+    $$PWD/uri-atom.h \
+    $$PWD/metadata-write-queue.h \
+    $$PWD/local-file-enumerator.h \
+    $$PWD/uring-statx-engine.h \
+    $$PWD/prefetch-scheduler.h \
+    $$PWD/target-uri-resolver.h
 
 SOURCES += $$PWD/file-info.cpp \
            $$PWD/file-info-job.cpp \
@@ -31,6 +41,16 @@ SOURCES += $$PWD/file-info.cpp \
     $$PWD/thumbnail-manager.cpp \
     $$PWD/linux-pwd-helper.cpp \
     $$PWD/file-meta-info.cpp \
-    $$PWD/bookmark-manager.cpp
+    $$PWD/bookmark-manager.cpp \
+    $$PWD/content-type-cache.cpp \
+    $$PWD/desktop-file-cache.cpp \
+    $$PWD/file-info-batch-job.cpp \
+    $$PWD/directory-snapshot-cache.cpp \
+    $$PWD/uri-atom.cpp \
+    $$PWD/metadata-write-queue.cpp \
+    $$PWD/local-file-enumerator.cpp \
+    $$PWD/uring-statx-engine.cpp \
+    $$PWD/prefetch-scheduler.cpp \
+    $$PWD/target-uri-resolver.cpp
 
 FORMS += $$PWD/connect-server-dialog.ui
@@ -0,0 +1,225 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "prefetch-scheduler.h"
+
+#include "file-enumerator.h"
+#include "file-info.h"
+#include "directory-snapshot-cache.h"
+
+#include <QTimer>
+#include <QUrl>
+
+#include <gio/gio.h>
+#include <gio/gunixmounts.h>
+
+using namespace Peony;
+
+/*!
+ * \brief is_remote_file_system
+ * \return true if the path is on a network file system or a fuse mount,
+ * such as the mount points of gvfs.
+ */
+static bool is_remote_file_system(const QString &path)
+{
+#if GLIB_CHECK_VERSION(2, 52, 0)
+    GUnixMountEntry *entry = g_unix_mount_for(path.toUtf8().constData(), nullptr);
+    if (!entry)
+        return false;
+
+    QString type = g_unix_mount_get_fs_type(entry);
+    g_unix_mount_free(entry);
+
+    static const QStringList remote_types = {"nfs", "nfs4", "cifs", "smb3", "smbfs", "ncpfs",
+                                             "afs", "9p", "ceph", "glusterfs", "davfs"};
+    return remote_types.contains(type) || type.startsWith("fuse.");
+#else
+    return path.contains("/gvfs/");
+#endif
+}
+
+PrefetchScheduler *PrefetchScheduler::getInstance()
+{
+    static PrefetchScheduler *global_instance = new PrefetchScheduler;
+    return global_instance;
+}
+
+PrefetchScheduler::PrefetchScheduler(QObject *parent) : QObject(parent)
+{
+    m_hover_timer = new QTimer(this);
+    m_hover_timer->setSingleShot(true);
+    m_hover_timer->setInterval(PEONY_PREFETCH_HOVER_DELAY);
+    connect(m_hover_timer, &QTimer::timeout, this, [=]() {
+        request(m_hovered_uri);
+    });
+}
+
+bool PrefetchScheduler::isPrefetchable(const QString &uri)
+{
+    QUrl url = uri;
+    if (!url.isLocalFile())
+        return false;
+    return !is_remote_file_system(url.path());
+}
+
+void PrefetchScheduler::hover(const QString &uri)
+{
+    if (uri == m_hovered_uri)
+        return;
+
+    m_hovered_uri = uri;
+    if (uri.isEmpty()) {
+        m_hover_timer->stop();
+        return;
+    }
+    m_hover_timer->start();
+}
+
+void PrefetchScheduler::request(const QString &uri)
+{
+    if (uri.isEmpty())
+        return;
+
+    if (m_running.contains(uri))
+        return;
+
+    //a warm directory is refreshed only after it expired.
+    auto it = m_warm.constFind(uri);
+    if (it != m_warm.constEnd() && !it->time.hasExpired(PEONY_PREFETCH_EXPIRE_TIME))
+        return;
+
+    if (!isPrefetchable(uri))
+        return;
+
+    //the latest request is the most relevant one.
+    m_queue.removeOne(uri);
+    m_queue.prepend(uri);
+    while (m_queue.count() > PEONY_PREFETCH_MAX_QUEUED) {
+        m_queue.removeLast();
+    }
+
+    scheduleNext();
+}
+
+void PrefetchScheduler::cancel(const QString &uri)
+{
+    m_queue.removeOne(uri);
+    if (auto enumerator = m_running.take(uri)) {
+        enumerator->disconnect(this);
+        enumerator->cancel();
+        enumerator->deleteLater();
+    }
+}
+
+void PrefetchScheduler::cancelAll()
+{
+    m_hover_timer->stop();
+    m_hovered_uri.clear();
+    m_queue.clear();
+    for (auto uri : m_running.keys()) {
+        cancel(uri);
+    }
+}
+
+QList<std::shared_ptr<FileInfo>> PrefetchScheduler::takeWarmChildren(const QString &uri)
+{
+    //user has entered a directory, the other requests are out of date.
+    m_hover_timer->stop();
+    m_hovered_uri.clear();
+    m_queue.clear();
+    cancel(uri);
+
+    QList<std::shared_ptr<FileInfo>> children;
+    if (!m_warm.contains(uri))
+        return children;
+
+    auto entry = m_warm.take(uri);
+    m_warm_order.removeOne(uri);
+    m_warm_count -= entry.children.count();
+    if (entry.time.hasExpired(PEONY_PREFETCH_EXPIRE_TIME))
+        return children;
+    return entry.children;
+}
+
+void PrefetchScheduler::scheduleNext()
+{
+    while (m_running.count() < PEONY_PREFETCH_MAX_JOBS && !m_queue.isEmpty()) {
+        startPrefetch(m_queue.takeFirst());
+    }
+}
+
+void PrefetchScheduler::startPrefetch(const QString &uri)
+{
+    //do not prepare, prepare might mount a volume or block ui thread.
+    auto enumerator = new FileEnumerator;
+    enumerator->setEnumerateDirectory(uri);
+    enumerator->setEnumerateWithInfo(true);
+    m_running.insert(uri, enumerator);
+
+    connect(enumerator, &FileEnumerator::childrenUpdated, this, [=]() {
+        //the directory is too large to keep warm.
+        if (enumerator->getChildrenUris().count() > PEONY_PREFETCH_MAX_INFOS/2)
+            cancel(uri);
+    });
+    connect(enumerator, &FileEnumerator::enumerateFinished, this, [=](bool successed) {
+        onPrefetchFinished(enumerator, successed);
+    });
+
+    enumerator->enumerateAsync();
+}
+
+void PrefetchScheduler::onPrefetchFinished(FileEnumerator *enumerator, bool successed)
+{
+    auto uri = m_running.key(enumerator);
+    if (uri.isNull())
+        return;
+    m_running.remove(uri);
+    enumerator->disconnect(this);
+
+    if (successed) {
+        WarmEntry entry;
+        entry.children = enumerator->getChildren();
+        entry.time.start();
+
+        if (m_warm.contains(uri)) {
+            m_warm_count -= m_warm.value(uri).children.count();
+            m_warm_order.removeOne(uri);
+        }
+        m_warm.insert(uri, entry);
+        m_warm_order.append(uri);
+        m_warm_count += entry.children.count();
+
+        DirectorySnapshotCache::getInstance()->saveSnapshot(FileInfo::fromUri(uri), entry.children);
+        evict();
+    }
+
+    enumerator->deleteLater();
+    scheduleNext();
+}
+
+void PrefetchScheduler::evict()
+{
+    while (m_warm_count > PEONY_PREFETCH_MAX_INFOS && !m_warm_order.isEmpty()) {
+        auto uri = m_warm_order.takeFirst();
+        m_warm_count -= m_warm.take(uri).children.count();
+    }
+}
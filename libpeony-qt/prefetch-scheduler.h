@@ -0,0 +1,127 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef PREFETCHSCHEDULER_H
+#define PREFETCHSCHEDULER_H
+
+#include "peony-core_global.h"
+
+#include <QObject>
+#include <QHash>
+#include <QStringList>
+#include <QElapsedTimer>
+
+#include <memory>
+
+#define PEONY_PREFETCH_HOVER_DELAY 400
+#define PEONY_PREFETCH_MAX_JOBS 2
+#define PEONY_PREFETCH_MAX_QUEUED 8
+#define PEONY_PREFETCH_MAX_INFOS 20000
+#define PEONY_PREFETCH_EXPIRE_TIME 30000
+
+class QTimer;
+
+namespace Peony {
+
+class FileInfo;
+class FileEnumerator;
+
+/*!
+ * \brief The PrefetchScheduler class
+ * <br>
+ * This class enumerates a directory before user enters it. The views request
+ * a prefetch when a directory is hovered for PEONY_PREFETCH_HOVER_DELAY milliseconds,
+ * selected, or focused with keyboard. The children infos are enumerated with info
+ * and kept warm, the directory snapshot is saved as well.
+ * </br>
+ * <br>
+ * When FileItem finds the children of a root directory, it takes the warm children
+ * and shows them at once, the enumeration revalidates them as it does for a snapshot.
+ * </br>
+ * \note
+ * Prefetching is low priority. At most PEONY_PREFETCH_MAX_JOBS directories are enumerated
+ * at the same time, and the warm children are bounded by PEONY_PREFETCH_MAX_INFOS, the least
+ * recently prefetched directories are dropped first. Only local directories are prefetched,
+ * remote schemes and remote mounts are never touched, so that prefetching does not mount
+ * anything nor wake up a remote server.
+ * \see FileItem::findChildrenAsync().
+ */
+class PEONYCORESHARED_EXPORT PrefetchScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    static PrefetchScheduler *getInstance();
+
+    /*!
+     * \brief takeWarmChildren
+     * \param uri
+     * \return the warm children infos of the directory, or an empty list.
+     * \note the queued requests are dropped, user has entered a directory.
+     */
+    QList<std::shared_ptr<FileInfo>> takeWarmChildren(const QString &uri);
+
+    bool isPrefetchable(const QString &uri);
+
+public Q_SLOTS:
+    /*!
+     * \brief hover
+     * \param uri
+     * request a prefetch if the directory is still hovered after the delay.
+     * an empty uri means nothing is hovered.
+     */
+    void hover(const QString &uri);
+    void request(const QString &uri);
+    void cancel(const QString &uri);
+    void cancelAll();
+
+protected:
+    void scheduleNext();
+    void startPrefetch(const QString &uri);
+    void onPrefetchFinished(FileEnumerator *enumerator, bool successed);
+    void evict();
+
+private:
+    explicit PrefetchScheduler(QObject *parent = nullptr);
+
+    struct WarmEntry {
+        QList<std::shared_ptr<FileInfo>> children;
+        QElapsedTimer time;
+    };
+
+    QTimer *m_hover_timer = nullptr;
+    QString m_hovered_uri;
+
+    QStringList m_queue;
+    QHash<QString, FileEnumerator *> m_running;
+
+    QHash<QString, WarmEntry> m_warm;
+    /*!
+     * \brief m_warm_order
+     * the warm directories from the least recently prefetched one.
+     */
+    QStringList m_warm_order;
+    int m_warm_count = 0;
+};
+
+}
+
+#endif // PREFETCHSCHEDULER_H
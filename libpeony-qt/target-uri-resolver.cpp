@@ -0,0 +1,209 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "target-uri-resolver.h"
+#include "volume-manager.h"
+
+#include <QCoreApplication>
+#include <QThread>
+
+#include <QDebug>
+
+using namespace Peony;
+
+struct TargetUriResolver::ResolveRequest
+{
+    TargetUriResolver *resolver;
+    QString uri;
+    quint64 generation;
+};
+
+TargetUriResolver *TargetUriResolver::getInstance()
+{
+    static TargetUriResolver *global_instance = nullptr;
+    static QMutex global_instance_mutex;
+    QMutexLocker locker(&global_instance_mutex);
+    if (!global_instance) {
+        global_instance = new TargetUriResolver;
+        //the thumbnailers might create it in a worker thread.
+        if (qApp && global_instance->thread() != qApp->thread())
+            global_instance->moveToThread(qApp->thread());
+    }
+    return global_instance;
+}
+
+TargetUriResolver::TargetUriResolver(QObject *parent) : QObject(parent)
+{
+    m_cache.setMaxCost(PEONY_TARGET_URI_CACHE_SIZE);
+
+    auto volumeManager = VolumeManager::getInstance();
+    connect(volumeManager, &VolumeManager::volumeAdded, this, &TargetUriResolver::clear);
+    connect(volumeManager, &VolumeManager::volumeRemoved, this, &TargetUriResolver::clear);
+    connect(volumeManager, &VolumeManager::mountAdded, this, &TargetUriResolver::clear);
+    connect(volumeManager, &VolumeManager::mountRemoved, this, &TargetUriResolver::clear);
+}
+
+bool TargetUriResolver::hasNoTargetUri(const QString &uri)
+{
+    return uri.isEmpty() || uri.startsWith("file://");
+}
+
+bool TargetUriResolver::lookup(const QString &uri, QString &targetUri)
+{
+    if (hasNoTargetUri(uri)) {
+        targetUri = QString();
+        return true;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    auto cached = m_cache.object(uri);
+    if (!cached)
+        return false;
+    targetUri = *cached;
+    return true;
+}
+
+void TargetUriResolver::insert(const QString &uri, const QString &targetUri)
+{
+    if (hasNoTargetUri(uri))
+        return;
+
+    QMutexLocker locker(&m_mutex);
+    m_cache.insert(uri, new QString(targetUri));
+}
+
+void TargetUriResolver::resolveAsync(const QString &uri, QObject *receiver, const std::function<void (const QString &)> &callback)
+{
+    QString targetUri;
+    if (lookup(uri, targetUri)) {
+        callback(targetUri);
+        return;
+    }
+
+    Pending pending;
+    pending.receiver = receiver? receiver: this;
+    pending.callback = callback;
+
+    //there is a query of the uri running.
+    bool running = m_pending.contains(uri);
+    m_pending[uri]<<pending;
+    if (running)
+        return;
+
+    auto request = new ResolveRequest;
+    request->resolver = this;
+    request->uri = uri;
+    m_mutex.lock();
+    request->generation = m_generation;
+    m_mutex.unlock();
+
+    GFile *file = g_file_new_for_uri(uri.toUtf8().constData());
+    g_file_query_info_async(file,
+                            G_FILE_ATTRIBUTE_STANDARD_TARGET_URI,
+                            G_FILE_QUERY_INFO_NONE,
+                            G_PRIORITY_DEFAULT,
+                            nullptr,
+                            GAsyncReadyCallback(query_info_async_ready_callback),
+                            request);
+    g_object_unref(file);
+}
+
+QString TargetUriResolver::resolveSync(const QString &uri)
+{
+    QString targetUri;
+    if (lookup(uri, targetUri))
+        return targetUri;
+
+    m_mutex.lock();
+    quint64 generation = m_generation;
+    m_mutex.unlock();
+
+    GError *err = nullptr;
+    GFile *file = g_file_new_for_uri(uri.toUtf8().constData());
+    GFileInfo *info = g_file_query_info(file,
+                                        G_FILE_ATTRIBUTE_STANDARD_TARGET_URI,
+                                        G_FILE_QUERY_INFO_NONE,
+                                        nullptr,
+                                        &err);
+    g_object_unref(file);
+    if (info) {
+        targetUri = g_file_info_get_attribute_string(info, G_FILE_ATTRIBUTE_STANDARD_TARGET_URI);
+        g_object_unref(info);
+    }
+    if (err) {
+        //same as resolveAsync(), the uri might be mounted later.
+        g_error_free(err);
+        return targetUri;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (generation == m_generation)
+        m_cache.insert(uri, new QString(targetUri));
+    return targetUri;
+}
+
+void TargetUriResolver::invalidate(const QString &uri)
+{
+    QMutexLocker locker(&m_mutex);
+    m_cache.remove(uri);
+}
+
+void TargetUriResolver::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_cache.clear();
+    m_generation++;
+}
+
+GAsyncReadyCallback TargetUriResolver::query_info_async_ready_callback(GFile *file,
+        GAsyncResult *res,
+        ResolveRequest *request)
+{
+    GError *err = nullptr;
+    GFileInfo *info = g_file_query_info_finish(file, res, &err);
+    QString targetUri;
+    if (info) {
+        targetUri = g_file_info_get_attribute_string(info, G_FILE_ATTRIBUTE_STANDARD_TARGET_URI);
+        g_object_unref(info);
+    }
+
+    auto p_this = request->resolver;
+    if (err) {
+        qDebug()<<"resolve target uri err:"<<err->code<<err->message;
+        //do not cache a failed query, the uri might be mounted later.
+        g_error_free(err);
+    } else {
+        QMutexLocker locker(&p_this->m_mutex);
+        if (request->generation == p_this->m_generation)
+            p_this->m_cache.insert(request->uri, new QString(targetUri));
+    }
+
+    auto pendings = p_this->m_pending.take(request->uri);
+    for (auto pending : pendings) {
+        if (pending.receiver)
+            pending.callback(targetUri);
+    }
+    Q_EMIT p_this->resolved(request->uri, targetUri);
+
+    delete request;
+    return nullptr;
+}
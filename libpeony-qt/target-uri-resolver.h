@@ -0,0 +1,138 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef TARGETURIRESOLVER_H
+#define TARGETURIRESOLVER_H
+
+#include "peony-core_global.h"
+
+#include <QObject>
+#include <QCache>
+#include <QHash>
+#include <QMutex>
+#include <QPointer>
+
+#include <functional>
+#include <gio/gio.h>
+
+#define PEONY_TARGET_URI_CACHE_SIZE 1024
+
+namespace Peony {
+
+/*!
+ * \brief The TargetUriResolver class
+ * <br>
+ * Many virtual locations, such as the volumes in computer:///, the servers
+ * in network:///, or the files in trash:/// and recent:///, point to another
+ * uri with the standard::target-uri attribute. This class resolves the target
+ * uris and caches the results by uri, including the uris which have no target.
+ * </br>
+ * <br>
+ * Native files never have a target uri, they are not queried at all. The cache
+ * is cleared when a volume or mount is added or removed, because the targets
+ * of mountable uris change with mounting.
+ * </br>
+ * \note resolveAsync() should be called in the main thread. lookup(), insert()
+ * and resolveSync() are thread safe.
+ * \see FileUtils::getTargetUri(), VolumeManager.
+ */
+class PEONYCORESHARED_EXPORT TargetUriResolver : public QObject
+{
+    Q_OBJECT
+public:
+    static TargetUriResolver *getInstance();
+
+    /*!
+     * \brief hasNoTargetUri
+     * \param uri
+     * \return true if the uri is known to have no target uri without querying it.
+     */
+    static bool hasNoTargetUri(const QString &uri);
+
+    /*!
+     * \brief lookup
+     * \param uri
+     * \param targetUri, set to the cached target uri, it might be empty.
+     * \return true if the target uri of uri is known.
+     */
+    bool lookup(const QString &uri, QString &targetUri);
+    void insert(const QString &uri, const QString &targetUri);
+
+    /*!
+     * \brief resolveAsync
+     * \param uri
+     * \param receiver, the callback is not called if receiver is destroyed.
+     * \param callback, called with the target uri, or an empty string if uri
+     * has no target.
+     * <br>
+     * If the target uri is known, the callback is called at once. Otherwise
+     * the target uri is queried asynchronously, the requests of the same uri
+     * share one query.
+     * </br>
+     */
+    void resolveAsync(const QString &uri, QObject *receiver, const std::function<void(const QString &targetUri)> &callback);
+
+    /*!
+     * \brief resolveSync
+     * \param uri
+     * \return the target uri, or an empty string if uri has no target.
+     * \note it blocks if the target uri is not cached. do not use it in ui thread,
+     * use resolveAsync() instead.
+     */
+    QString resolveSync(const QString &uri);
+
+Q_SIGNALS:
+    void resolved(const QString &uri, const QString &targetUri);
+
+public Q_SLOTS:
+    void invalidate(const QString &uri);
+    void clear();
+
+protected:
+    struct ResolveRequest;
+    static GAsyncReadyCallback query_info_async_ready_callback(GFile *file,
+            GAsyncResult *res,
+            ResolveRequest *request);
+
+private:
+    explicit TargetUriResolver(QObject *parent = nullptr);
+
+    QCache<QString, QString> m_cache;
+    QMutex m_mutex;
+    /*!
+     * \brief m_generation
+     * increased when cache cleared, the results queried before
+     * are not cached.
+     */
+    quint64 m_generation = 0;
+
+    struct Pending
+    {
+        QPointer<QObject> receiver;
+        std::function<void(const QString &targetUri)> callback;
+    };
+    QHash<QString, QList<Pending>> m_pending;
+};
+
+}
+
+#endif // TARGETURIRESOLVER_H
@@ -27,6 +27,7 @@
 
 #include "file-watcher.h"
 #include "file-utils.h"
+#include "target-uri-resolver.h"
 
 #include "thumbnail/pdf-thumbnail.h"
 #include "thumbnail/video-thumbnail.h"
@@ -35,6 +36,7 @@
 #include "thumbnail-job.h"
 
 #include "global-settings.h"
+#include "desktop-file-cache.h"
 
 #include <QtConcurrent>
 #include <QIcon>
@@ -43,8 +45,6 @@
 #include <QThreadPool>
 #include <QSemaphore>
 
-#include <gio/gdesktopappinfo.h>
-
 using namespace Peony;
 
 static ThumbnailManager *global_instance = nullptr;
@@ -62,7 +62,13 @@ static ThumbnailManager *global_instance = nullptr;
  */
 ThumbnailManager::ThumbnailManager(QObject *parent) : QObject(parent)
 {
-    GlobalSettings::getInstance();
+    //the cached settings are kept up to date by GlobalSettings,
+    //including the changes made by other processes.
+    syncThumbnailPreferences();
+    connect(GlobalSettings::getInstance(), &GlobalSettings::valueChanged, this, [=](const QString &key) {
+        if (key == FORBID_THUMBNAIL_IN_VIEW)
+            syncThumbnailPreferences();
+    });
 
     m_thumbnail_thread_pool = new QThreadPool(this);
     m_thumbnail_thread_pool->setMaxThreadCount(1);
@@ -84,14 +90,16 @@ ThumbnailManager *ThumbnailManager::getInstance()
 
 void ThumbnailManager::syncThumbnailPreferences()
 {
-    GlobalSettings::getInstance()->forceSync("do-not-thumbnail");
+    auto settings = GlobalSettings::getInstance();
+    bool doNotThumbnail = settings->isExist(FORBID_THUMBNAIL_IN_VIEW) && settings->getValue(FORBID_THUMBNAIL_IN_VIEW).toBool();
+    m_do_not_thumbnail.storeRelease(doNotThumbnail);
 }
 
 void ThumbnailManager::insertOrUpdateThumbnail(const QString &uri, const QIcon &icon)
 {
+    auto atom = UriAtom::fromUri(uri);
     m_semaphore->acquire();
-    m_hash.remove(uri);
-    m_hash.insert(uri, icon);
+    m_hash.insert(atom, icon);
     m_semaphore->release();
 }
 
@@ -121,7 +129,7 @@ void ThumbnailManager::createPdfFileThumbnail(const QString &uri, std::shared_pt
     QUrl url = uri;
 
     if (!uri.startsWith("file:///")) {
-        url = FileUtils::getTargetUri(uri);
+        url = TargetUriResolver::getInstance()->resolveSync(uri);
         //qDebug()<<url;
     }
 
@@ -143,7 +151,7 @@ void ThumbnailManager::createImageFileThumbnail(const QString &uri, std::shared_
     QUrl url = uri;
 
     if (!uri.startsWith("file:///")) {
-        url = FileUtils::getTargetUri(uri);
+        url = TargetUriResolver::getInstance()->resolveSync(uri);
         //qDebug()<<url;
     }
 
@@ -181,30 +189,27 @@ void ThumbnailManager::createDesktopFileThumbnail(const QString &uri, std::share
     QUrl url = uri;
 
     if (!uri.startsWith("file:///")) {
-        url = FileUtils::getTargetUri(uri);
+        url = TargetUriResolver::getInstance()->resolveSync(uri);
         //qDebug()<<url;
     }
 
-    auto _desktop_file = g_desktop_app_info_new_from_filename(url.path().toUtf8().constData());
-    if (!_desktop_file) {
+    auto entry = DesktopFileCache::getInstance()->lookup(url.path());
+    if (!entry.isValid) {
         return;
     }
 
-    auto _icon_string = g_desktop_app_info_get_string(_desktop_file, "Icon");
-    thumbnail = QIcon::fromTheme(_icon_string);
-    QString string = _icon_string;
+    thumbnail = QIcon::fromTheme(entry.icon);
+    QString string = entry.icon;
 
     if (thumbnail.isNull()) {
         if (string.startsWith("/")) {
-            thumbnail = GenericThumbnailer::generateThumbnail(_icon_string, true);
+            thumbnail = GenericThumbnailer::generateThumbnail(entry.icon, true);
         } else if (string.contains(".")) {
             // try getting themed icon with image suffix.
             string.chop(string.count() - string.lastIndexOf("."));
             thumbnail = QIcon::fromTheme(string);
         }
     }
-    g_free(_icon_string);
-    g_object_unref(_desktop_file);
 
     if (!thumbnail.isNull()) {
         insertOrUpdateThumbnail(uri, thumbnail);
@@ -218,13 +223,10 @@ void ThumbnailManager::createDesktopFileThumbnail(const QString &uri, std::share
 
 void ThumbnailManager::createThumbnailInternal(const QString &uri, std::shared_ptr<FileWatcher> watcher, bool force)
 {
-    auto settings = GlobalSettings::getInstance();
-    if (settings->isExist("do-not-thumbnail")) {
-        bool do_not_thumbnail = settings->getValue("do-not-thumbnail").toBool();
-        if (do_not_thumbnail && !force) {
-            qDebug()<<"setting is not thumbnail";
-            return;
-        }
+    //this is called in thumbnail thread, use the preference cached in ui thread.
+    if (m_do_not_thumbnail.loadAcquire() && !force) {
+        qDebug()<<"setting is not thumbnail";
+        return;
     }
 
     //NOTE: we should do createThumbnail() after we have queried the file's info.
@@ -317,15 +319,22 @@ void ThumbnailManager::updateDesktopFileThumbnail(const QString &uri, std::share
 
 void ThumbnailManager::releaseThumbnail(const QString &uri)
 {
+    //a uri not interned has no thumbnail.
+    auto atom = UriAtom::find(uri);
+    if (atom.isNull())
+        return;
     m_semaphore->acquire();
-    m_hash.remove(uri);
+    m_hash.remove(atom);
     m_semaphore->release();
 }
 
 const QIcon ThumbnailManager::tryGetThumbnail(const QString &uri)
 {
+    auto atom = UriAtom::find(uri);
+    if (atom.isNull())
+        return QIcon();
     m_semaphore->acquire();
-    auto icon = m_hash.value(uri);
+    auto icon = m_hash.value(atom);
     m_semaphore->release();
     return icon;
 }
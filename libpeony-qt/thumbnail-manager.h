@@ -30,6 +30,7 @@
 #include <QHash>
 #include <QIcon>
 #include <QMutex>
+#include <QAtomicInt>
 
 class QThreadPool;
 class QSemaphore;
@@ -48,7 +49,7 @@ public:
     void setForbidThumbnailInView(bool forbid);
 
     bool hasThumbnail(const QString &uri) {
-        return !m_hash.values(uri).isEmpty();
+        return m_hash.contains(UriAtom::find(uri));
     }
 
     void createThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher = nullptr, bool force = false);
@@ -75,11 +76,17 @@ private:
     void createOfficeFileThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher);
     void createDesktopFileThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher);
 
-    QHash<QString, QIcon> m_hash;
+    QHash<UriAtom, QIcon> m_hash;
     //QMutex m_mutex;
 
     QThreadPool *m_thumbnail_thread_pool;
     QSemaphore *m_semaphore;
+
+    /*!
+     * \brief m_do_not_thumbnail
+     * the cached FORBID_THUMBNAIL_IN_VIEW preference, updated by syncThumbnailPreferences().
+     */
+    QAtomicInt m_do_not_thumbnail;
 };
 
 }
@@ -23,6 +23,7 @@
 #include "generic-thumbnailer.h"
 #include "video-thumbnail.h"
 #include "file-utils.h"
+#include "target-uri-resolver.h"
 #include <QFileInfo>
 #include <QDebug>
 #include <QtConcurrent>
@@ -35,7 +36,7 @@
 VideoThumbnail::VideoThumbnail(const QString &uri)
 {
     if (!uri.startsWith("file:///")) {
-        m_url = FileUtils::getTargetUri(uri);
+        m_url = TargetUriResolver::getInstance()->resolveSync(uri);
         qDebug()<<"target uri:"<< m_url.path();
     }
     else {
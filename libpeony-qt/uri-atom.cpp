@@ -0,0 +1,229 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "uri-atom.h"
+
+#include <QAtomicInt>
+#include <QMutex>
+
+#define URI_ATOM_TABLE_SHARD_COUNT 32
+
+namespace Peony {
+
+struct UriAtomData
+{
+    QString uri;
+    QByteArray utf8;
+    uint hash = 0;
+    UriAtom parent;
+    QAtomicInt ref;
+};
+
+}
+
+using namespace Peony;
+
+struct UriAtomShard
+{
+    QMutex mutex;
+    QHash<QString, UriAtomData *> hash;
+};
+
+static UriAtomShard *atom_shards()
+{
+    //never destroyed, atoms might be released by other static objects at exit.
+    static UriAtomShard *shards = new UriAtomShard[URI_ATOM_TABLE_SHARD_COUNT];
+    return shards;
+}
+
+static QString parent_uri(const QString &uri)
+{
+    int scheme_end = uri.indexOf("://");
+    if (scheme_end < 0)
+        return nullptr;
+    int path_start = scheme_end + 3;
+
+    QString tmp = uri;
+    while (tmp.length() > path_start + 1 && tmp.endsWith("/"))
+        tmp.chop(1);
+
+    int last = tmp.lastIndexOf("/");
+    //such as "smb://host" or "file:///"
+    if (last < path_start || last == tmp.length() - 1)
+        return nullptr;
+    //such as "file:///home"
+    if (last == path_start)
+        return tmp.left(last + 1);
+    return tmp.left(last);
+}
+
+UriAtom::UriAtom(const UriAtom &other)
+{
+    d = other.d;
+    if (d)
+        d->ref.ref();
+}
+
+UriAtom::UriAtom(UriAtom &&other) noexcept
+{
+    d = other.d;
+    other.d = nullptr;
+}
+
+UriAtom::~UriAtom()
+{
+    release();
+}
+
+UriAtom &UriAtom::operator=(const UriAtom &other)
+{
+    if (d != other.d) {
+        if (other.d)
+            other.d->ref.ref();
+        release();
+        d = other.d;
+    }
+    return *this;
+}
+
+UriAtom &UriAtom::operator=(UriAtom &&other) noexcept
+{
+    if (this != &other) {
+        release();
+        d = other.d;
+        other.d = nullptr;
+    }
+    return *this;
+}
+
+UriAtom UriAtom::fromUri(const QString &uri)
+{
+    if (uri.isEmpty())
+        return UriAtom();
+
+    auto hash = ::qHash(uri);
+    auto &shard = atom_shards()[hash % URI_ATOM_TABLE_SHARD_COUNT];
+    {
+        QMutexLocker l(&shard.mutex);
+        auto it = shard.hash.constFind(uri);
+        if (it != shard.hash.constEnd()) {
+            it.value()->ref.ref();
+            return UriAtom(it.value());
+        }
+    }
+
+    //intern the parent before locking, it might be in the same shard.
+    auto parent = fromUri(parent_uri(uri));
+
+    QMutexLocker l(&shard.mutex);
+    //another thread might have interned it.
+    auto it = shard.hash.constFind(uri);
+    if (it != shard.hash.constEnd()) {
+        it.value()->ref.ref();
+        return UriAtom(it.value());
+    }
+
+    auto data = new UriAtomData;
+    data->uri = uri;
+    data->utf8 = uri.toUtf8();
+    data->hash = hash;
+    data->parent = parent;
+    data->ref.store(1);
+    shard.hash.insert(uri, data);
+    return UriAtom(data);
+}
+
+UriAtom UriAtom::find(const QString &uri)
+{
+    if (uri.isEmpty())
+        return UriAtom();
+
+    auto &shard = atom_shards()[::qHash(uri) % URI_ATOM_TABLE_SHARD_COUNT];
+    QMutexLocker l(&shard.mutex);
+    auto it = shard.hash.constFind(uri);
+    if (it == shard.hash.constEnd())
+        return UriAtom();
+    it.value()->ref.ref();
+    return UriAtom(it.value());
+}
+
+const QString UriAtom::uri() const
+{
+    return d? d->uri: QString();
+}
+
+const QByteArray UriAtom::utf8() const
+{
+    return d? d->utf8: QByteArray();
+}
+
+uint UriAtom::hash() const
+{
+    return d? d->hash: 0;
+}
+
+const UriAtom UriAtom::parent() const
+{
+    return d? d->parent: UriAtom();
+}
+
+int UriAtom::count()
+{
+    int count = 0;
+    for (int i = 0; i < URI_ATOM_TABLE_SHARD_COUNT; i++) {
+        auto &shard = atom_shards()[i];
+        QMutexLocker l(&shard.mutex);
+        count += shard.hash.count();
+    }
+    return count;
+}
+
+void UriAtom::release()
+{
+    if (!d)
+        return;
+
+    //fast path, this is not the last reference.
+    int ref = d->ref.load();
+    while (ref > 1) {
+        if (d->ref.testAndSetOrdered(ref, ref - 1)) {
+            d = nullptr;
+            return;
+        }
+        ref = d->ref.load();
+    }
+
+    //the last reference might be released, lookups also ref the data
+    //with the shard locked, so check it again with lock.
+    UriAtomData *data = d;
+    d = nullptr;
+    auto &shard = atom_shards()[data->hash % URI_ATOM_TABLE_SHARD_COUNT];
+    shard.mutex.lock();
+    if (!data->ref.deref()) {
+        shard.hash.remove(data->uri);
+        shard.mutex.unlock();
+        //the parent is released out of lock.
+        delete data;
+        return;
+    }
+    shard.mutex.unlock();
+}
@@ -0,0 +1,113 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#ifndef URIATOM_H
+#define URIATOM_H
+
+#include "peony-core_global.h"
+
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+
+namespace Peony {
+
+struct UriAtomData;
+
+/*!
+ * \brief The UriAtom class
+ * <br>
+ * UriAtom is an interned uri. All the atoms created from the same uri string
+ * share one data, which holds the uri in both unicode and utf-8 forms, a
+ * precomputed hash and the atom of parent uri. So that comparing and hashing
+ * atoms only compare pointers, and the utf-8 form can be passed to gio without
+ * converting again. The forms are stored once per atom, not per user.
+ * </br>
+ * \note
+ * An atom is removed from the intern table when the last reference released,
+ * the table is thread safe.
+ * The parent atom is computed by splitting the uri string, it does not handle
+ * the redirection of virtual file systems, use FileUtils::getParentUri() for that.
+ */
+class PEONYCORESHARED_EXPORT UriAtom
+{
+public:
+    UriAtom() {}
+    UriAtom(const UriAtom &other);
+    UriAtom(UriAtom &&other) noexcept;
+    ~UriAtom();
+
+    UriAtom &operator=(const UriAtom &other);
+    UriAtom &operator=(UriAtom &&other) noexcept;
+
+    /*!
+     * \brief fromUri
+     * \param uri
+     * \return the interned atom of uri, it will be created if not existed.
+     */
+    static UriAtom fromUri(const QString &uri);
+    /*!
+     * \brief find
+     * \param uri
+     * \return the interned atom of uri, or a null atom if the uri is not interned.
+     * \note use this method for lookup, it does not create any atom.
+     */
+    static UriAtom find(const QString &uri);
+
+    bool isNull() const {
+        return !d;
+    }
+
+    const QString uri() const;
+    const QByteArray utf8() const;
+    uint hash() const;
+    const UriAtom parent() const;
+
+    bool operator==(const UriAtom &other) const {
+        return d == other.d;
+    }
+    bool operator!=(const UriAtom &other) const {
+        return d != other.d;
+    }
+
+    /*!
+     * \brief count
+     * \return the count of interned atoms, for debugging.
+     */
+    static int count();
+
+private:
+    explicit UriAtom(UriAtomData *data) : d(data) {}
+    void release();
+
+    UriAtomData *d = nullptr;
+};
+
+inline uint qHash(const UriAtom &atom, uint seed = 0)
+{
+    return atom.hash() ^ seed;
+}
+
+}
+
+#endif // URIATOM_H
@@ -0,0 +1,284 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "uring-statx-engine.h"
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include <memory>
+
+#include <QDebug>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>) && defined(SYS_io_uring_setup) && defined(STATX_BASIC_STATS)
+#include <linux/io_uring.h>
+#define PEONY_HAS_IO_URING
+#endif
+#endif
+
+using namespace Peony;
+
+UringStatxEngine::UringStatxEngine(unsigned int entries)
+{
+    if (!setup(entries))
+        release();
+}
+
+UringStatxEngine::~UringStatxEngine()
+{
+    release();
+}
+
+bool UringStatxEngine::isSupported()
+{
+    //the probe is done once, even if several workers check it at the same time.
+    static const bool supported = probe();
+    return supported;
+}
+
+UringStatxEngine *UringStatxEngine::threadInstance()
+{
+    if (!isSupported())
+        return nullptr;
+
+    thread_local std::unique_ptr<UringStatxEngine> engine;
+    if (!engine)
+        engine.reset(new UringStatxEngine);
+    return engine->isValid()? engine.get(): nullptr;
+}
+
+bool UringStatxEngine::probe()
+{
+#ifdef PEONY_HAS_IO_URING
+    UringStatxEngine engine(8);
+    if (!engine.isValid())
+        return false;
+
+    //IORING_OP_STATX is available since linux 5.6, the same as probing.
+    const int ops_count = 256;
+    size_t probe_size = sizeof(io_uring_probe) + ops_count*sizeof(io_uring_probe_op);
+    auto probe = static_cast<io_uring_probe *>(calloc(1, probe_size));
+    if (!probe)
+        return false;
+    bool supported = false;
+    int ret = syscall(SYS_io_uring_register, engine.m_ring_fd, IORING_REGISTER_PROBE, probe, ops_count);
+    if (ret == 0 && probe->last_op >= IORING_OP_STATX &&
+            (probe->ops[IORING_OP_STATX].flags & IO_URING_OP_SUPPORTED)) {
+        supported = true;
+    }
+    free(probe);
+    return supported;
+#else
+    return false;
+#endif
+}
+
+bool UringStatxEngine::setup(unsigned int entries)
+{
+#ifdef PEONY_HAS_IO_URING
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = syscall(SYS_io_uring_setup, entries, &params);
+    if (fd < 0)
+        return false;
+    m_ring_fd = fd;
+
+    m_sq_ring_size = params.sq_off.array + params.sq_entries*sizeof(unsigned int);
+    m_cq_ring_size = params.cq_off.cqes + params.cq_entries*sizeof(io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        m_sq_ring_size = m_cq_ring_size = qMax(m_sq_ring_size, m_cq_ring_size);
+    }
+
+    void *sq_ring = mmap(nullptr, m_sq_ring_size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sq_ring == MAP_FAILED)
+        return false;
+    m_sq_ring = sq_ring;
+
+    if (single_mmap) {
+        m_cq_ring = m_sq_ring;
+    } else {
+        void *cq_ring = mmap(nullptr, m_cq_ring_size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cq_ring == MAP_FAILED)
+            return false;
+        m_cq_ring = cq_ring;
+    }
+
+    m_sqes_size = params.sq_entries*sizeof(io_uring_sqe);
+    void *sqes = mmap(nullptr, m_sqes_size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+        return false;
+    m_sqes = static_cast<io_uring_sqe *>(sqes);
+
+    auto sq = static_cast<char *>(m_sq_ring);
+    m_sq_head = reinterpret_cast<unsigned int *>(sq + params.sq_off.head);
+    m_sq_tail = reinterpret_cast<unsigned int *>(sq + params.sq_off.tail);
+    m_sq_mask = reinterpret_cast<unsigned int *>(sq + params.sq_off.ring_mask);
+    m_sq_array = reinterpret_cast<unsigned int *>(sq + params.sq_off.array);
+    m_sq_entries = params.sq_entries;
+
+    auto cq = static_cast<char *>(m_cq_ring);
+    m_cq_head = reinterpret_cast<unsigned int *>(cq + params.cq_off.head);
+    m_cq_tail = reinterpret_cast<unsigned int *>(cq + params.cq_off.tail);
+    m_cq_mask = reinterpret_cast<unsigned int *>(cq + params.cq_off.ring_mask);
+    m_cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+    m_cq_entries = params.cq_entries;
+
+    return true;
+#else
+    Q_UNUSED(entries)
+    return false;
+#endif
+}
+
+int UringStatxEngine::reapCompletions(int count, int *errors)
+{
+#ifdef PEONY_HAS_IO_URING
+    int reaped = 0;
+    unsigned int cq_head = *m_cq_head;
+    unsigned int cq_tail = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+    while (cq_head != cq_tail) {
+        io_uring_cqe *cqe = &m_cqes[cq_head & *m_cq_mask];
+        int index = int(cqe->user_data);
+        if (index >= 0 && index < count)
+            errors[index] = cqe->res < 0? -cqe->res: 0;
+        cq_head++;
+        reaped++;
+    }
+    __atomic_store_n(m_cq_head, cq_head, __ATOMIC_RELEASE);
+    return reaped;
+#else
+    Q_UNUSED(count)
+    Q_UNUSED(errors)
+    return 0;
+#endif
+}
+
+bool UringStatxEngine::waitForCompletions(unsigned int submitted, int count, int *errors)
+{
+#ifdef PEONY_HAS_IO_URING
+    while (submitted > 0) {
+        submitted -= qMin(submitted, (unsigned int)reapCompletions(count, errors));
+        if (submitted == 0)
+            break;
+        int ret = syscall(SYS_io_uring_enter, m_ring_fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            return false;
+    }
+    return true;
+#else
+    Q_UNUSED(submitted)
+    Q_UNUSED(count)
+    Q_UNUSED(errors)
+    return true;
+#endif
+}
+
+void UringStatxEngine::release()
+{
+    if (m_sqes)
+        munmap(m_sqes, m_sqes_size);
+    if (m_cq_ring && m_cq_ring != m_sq_ring)
+        munmap(m_cq_ring, m_cq_ring_size);
+    if (m_sq_ring)
+        munmap(m_sq_ring, m_sq_ring_size);
+    if (m_ring_fd >= 0)
+        close(m_ring_fd);
+
+    m_sqes = nullptr;
+    m_cq_ring = nullptr;
+    m_sq_ring = nullptr;
+    m_ring_fd = -1;
+}
+
+bool UringStatxEngine::statxBatch(int dirfd, const char *const *paths, int count, int flags, unsigned int mask,
+                                  struct statx *results, int *errors)
+{
+    for (int i = 0; i < count; i++) {
+        errors[i] = ECANCELED;
+    }
+
+#ifdef PEONY_HAS_IO_URING
+    if (!isValid())
+        return false;
+
+    int next = 0;
+    int completed = 0;
+    unsigned int in_flight = 0;
+    while (completed < count) {
+        //queue as many entries as the rings can hold.
+        unsigned int tail = *m_sq_tail;
+        unsigned int head = __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE);
+        while (next < count && tail - head < m_sq_entries && in_flight < m_cq_entries) {
+            unsigned int index = tail & *m_sq_mask;
+            io_uring_sqe *sqe = &m_sqes[index];
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_STATX;
+            sqe->fd = dirfd;
+            sqe->addr = reinterpret_cast<__u64>(paths[next]);
+            sqe->len = mask;
+            sqe->off = reinterpret_cast<__u64>(&results[next]);
+            sqe->statx_flags = flags;
+            sqe->user_data = __u64(next);
+            m_sq_array[index] = index;
+            tail++;
+            next++;
+            in_flight++;
+        }
+        __atomic_store_n(m_sq_tail, tail, __ATOMIC_RELEASE);
+
+        //entries not consumed by an interrupted enter are submitted again.
+        unsigned int to_submit = tail - head;
+
+        int ret = syscall(SYS_io_uring_enter, m_ring_fd, to_submit, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            //the ring is broken, the caller should fall back. the kernel might
+            //still write the results of consumed entries, wait for them before
+            //the caller frees the buffers.
+            unsigned int not_consumed = tail - __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE);
+            if (!waitForCompletions(in_flight - not_consumed, count, errors))
+                qWarning()<<"io_uring: failed to wait for the submitted statx, errno"<<errno;
+            release();
+            return false;
+        }
+
+        int reaped = reapCompletions(count, errors);
+        completed += reaped;
+        in_flight -= reaped;
+    }
+    return true;
+#else
+    Q_UNUSED(dirfd)
+    Q_UNUSED(paths)
+    Q_UNUSED(count)
+    Q_UNUSED(flags)
+    Q_UNUSED(mask)
+    Q_UNUSED(results)
+    return false;
+#endif
+}
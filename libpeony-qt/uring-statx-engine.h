@@ -0,0 +1,140 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, KylinSoft Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef URINGSTATXENGINE_H
+#define URINGSTATXENGINE_H
+
+#include "peony-core_global.h"
+
+#include <stddef.h>
+
+#define PEONY_URING_QUEUE_DEPTH 256
+
+/*!
+ * \brief PEONY_URING_MIN_BATCH
+ * batches smaller than this are not worth submitting to a ring,
+ * blocking statx() is used for them.
+ */
+#define PEONY_URING_MIN_BATCH 16
+
+struct statx;
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace Peony {
+
+/*!
+ * \brief The UringStatxEngine class
+ * <br>
+ * A minimal io_uring ring which only submits IORING_OP_STATX. It lets
+ * LocalFileEnumerator and FileInfoBatchJob fetch the metadata of a whole batch
+ * of files with a deep queue, instead of one blocking statx() after another.
+ * This matters for cold cache on spinning disks and network file systems,
+ * where the throughput comes from the queue depth.
+ * </br>
+ * <br>
+ * The ring is driven with raw syscalls, there is no dependency of liburing.
+ * Use isSupported() to check whether the running kernel supports io_uring and
+ * IORING_OP_STATX. io_uring might also be disabled by the system administrator.
+ * If it is not supported, callers should keep using blocking statx().
+ * </br>
+ * \note A ring is not thread safe, use threadInstance() in workers.
+ */
+class PEONYCORESHARED_EXPORT UringStatxEngine
+{
+public:
+    explicit UringStatxEngine(unsigned int entries = PEONY_URING_QUEUE_DEPTH);
+    ~UringStatxEngine();
+
+    /*!
+     * \brief isSupported
+     * \return true if io_uring statx is usable in this system.
+     * \note the check is done once in a process.
+     */
+    static bool isSupported();
+
+    /*!
+     * \brief threadInstance
+     * \return the ring of current thread, created at the first call. nullptr if
+     * io_uring statx is not supported or the ring of this thread has failed.
+     * \note the ring is destroyed when the thread exits, do not pass it to
+     * another thread.
+     */
+    static UringStatxEngine *threadInstance();
+
+    bool isValid() {
+        return m_ring_fd >= 0;
+    }
+
+    /*!
+     * \brief statxBatch
+     * \param dirfd, the directory paths are relative to.
+     * \param paths
+     * \param count
+     * \param flags, statx flags, such as AT_SYMLINK_NOFOLLOW.
+     * \param mask, statx mask.
+     * \param results, at least count statx structs.
+     * \param errors, at least count ints, 0 if succeeded, otherwise errno.
+     * \return false if the ring failed, the entries not completed have ECANCELED.
+     */
+    bool statxBatch(int dirfd, const char *const *paths, int count, int flags, unsigned int mask,
+                    struct statx *results, int *errors);
+
+protected:
+    static bool probe();
+    bool setup(unsigned int entries);
+    void release();
+
+    int reapCompletions(int count, int *errors);
+    /*!
+     * \brief waitForCompletions
+     * \param submitted, the count of entries consumed by the kernel but not completed.
+     * \return false if the ring can not wait any more.
+     */
+    bool waitForCompletions(unsigned int submitted, int count, int *errors);
+
+private:
+    int m_ring_fd = -1;
+
+    void *m_sq_ring = nullptr;
+    size_t m_sq_ring_size = 0;
+    void *m_cq_ring = nullptr;
+    size_t m_cq_ring_size = 0;
+    io_uring_sqe *m_sqes = nullptr;
+    size_t m_sqes_size = 0;
+
+    unsigned int *m_sq_head = nullptr;
+    unsigned int *m_sq_tail = nullptr;
+    unsigned int *m_sq_mask = nullptr;
+    unsigned int *m_sq_array = nullptr;
+    unsigned int m_sq_entries = 0;
+
+    unsigned int *m_cq_head = nullptr;
+    unsigned int *m_cq_tail = nullptr;
+    unsigned int *m_cq_mask = nullptr;
+    io_uring_cqe *m_cqes = nullptr;
+    unsigned int m_cq_entries = 0;
+};
+
+}
+
+#endif // URINGSTATXENGINE_H
@@ -1273,6 +1273,7 @@ void DesktopIconView::dropEvent(QDropEvent *e)
         bool bmoved = false;
         if (index.isValid()) {
             auto info = FileInfo::fromUri(index.data(Qt::UserRole).toString());
+            info->resolveTypeSync();
             if (!info->isDir())
                 return;
             bmoved = true;
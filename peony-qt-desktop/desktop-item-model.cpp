@@ -25,6 +25,7 @@
 #include "file-enumerator.h"
 #include "file-info.h"
 #include "file-info-job.h"
+#include "file-info-batch-job.h"
 #include "file-info-manager.h"
 #include "file-watcher.h"
 #include "file-operation-manager.h"
@@ -45,6 +46,7 @@
 
 #include <QMimeData>
 #include <QUrl>
+#include <QSet>
 
 #include <QTimer>
 
@@ -360,6 +362,10 @@ DesktopItemModel::~DesktopItemModel()
 void DesktopItemModel::refresh()
 {
     ThumbnailManager::getInstance()->syncThumbnailPreferences();
+    if (m_info_batch_job) {
+        m_info_batch_job->cancel();
+        m_info_batch_job = nullptr;
+    }
     beginResetModel();
     //removeRows(0, m_files.count());
     //m_trash_watcher->stopMonitor();
@@ -461,43 +467,74 @@ void DesktopItemModel::onEnumerateFinished()
 
     //qDebug()<<m_files.count();
     //this->endResetModel();
-    for (auto info : infos) {
-        beginInsertRows(QModelIndex(), m_files.count(), m_files.count());
-        auto syncJob = new FileInfoJob(info);
-        syncJob->querySync();
-        syncJob->deleteLater();
-        m_files<<info;
+    if (m_info_batch_job) {
+        m_info_batch_job->cancel();
+    }
+
+    //query all the infos in one batch job, and insert them chunk by chunk.
+    auto job = new FileInfoBatchJob(infos, this);
+    m_info_batch_job = job;
+    connect(job, &FileInfoBatchJob::chunkUpdated, this, [=](const QList<std::shared_ptr<FileInfo>> &chunk) {
+        beginInsertRows(QModelIndex(), m_files.count(), m_files.count() + chunk.count() - 1);
+        m_files<<chunk;
         endInsertRows();
 
-        if (info->isDesktopFile()) {
-            ThumbnailManager::getInstance()->updateDesktopFileThumbnail(info->uri(), m_thumbnail_watcher);
-        } else {
-            ThumbnailManager::getInstance()->createThumbnail(info->uri(), m_thumbnail_watcher);
+        for (auto info : chunk) {
+            if (info->isDesktopFile()) {
+                ThumbnailManager::getInstance()->updateDesktopFileThumbnail(info->uri(), m_thumbnail_watcher);
+            } else {
+                ThumbnailManager::getInstance()->createThumbnail(info->uri(), m_thumbnail_watcher);
+            }
         }
-    }
-    for (auto info : m_files) {
-        auto uri = info->uri();
-        auto view = PeonyDesktopApplication::getIconView();
-        auto pos = view->getFileMetaInfoPos(info->uri());
-        if (pos.x() >= 0) {
-            view->updateItemPosByUri(info->uri(), pos);
-        } else {
-            view->ensureItemPosByUri(uri);
+    });
+    connect(job, &FileInfoBatchJob::queryAsyncFinished, this, [=](bool successed) {
+        job->deleteLater();
+        if (m_info_batch_job == job)
+            m_info_batch_job = nullptr;
+        if (!successed)
+            return;
+
+        //the infos failed to query are not in chunks, but they are shown as before.
+        QSet<QString> insertedUris;
+        for (auto info : m_files) {
+            insertedUris<<info->uri();
+        }
+        QList<std::shared_ptr<FileInfo>> failedInfos;
+        for (auto info : infos) {
+            if (!insertedUris.contains(info->uri()))
+                failedInfos<<info;
+        }
+        if (!failedInfos.isEmpty()) {
+            beginInsertRows(QModelIndex(), m_files.count(), m_files.count() + failedInfos.count() - 1);
+            m_files<<failedInfos;
+            endInsertRows();
+        }
+
+        for (auto info : m_files) {
+            auto uri = info->uri();
+            auto view = PeonyDesktopApplication::getIconView();
+            auto pos = view->getFileMetaInfoPos(info->uri());
+            if (pos.x() >= 0) {
+                view->updateItemPosByUri(info->uri(), pos);
+            } else {
+                view->ensureItemPosByUri(uri);
+            }
         }
-    }
 
-    Q_EMIT refreshed();
+        Q_EMIT refreshed();
 
-    //qDebug()<<"startMornitor";
-    m_trash_watcher->startMonitor();
-    if (m_desktop_watcher->currentUri() != "file://" + QStandardPaths::writableLocation(QStandardPaths::DesktopLocation)) {
-        m_desktop_watcher->stopMonitor();
-        m_desktop_watcher->forceChangeMonitorDirectory("file://" + QStandardPaths::writableLocation(QStandardPaths::DesktopLocation));
-        m_desktop_watcher->setMonitorChildrenChange(true);
-    }
-    m_desktop_watcher->startMonitor();
-    m_system_app_watcher->startMonitor();
-    m_andriod_app_watcher->startMonitor();
+        //qDebug()<<"startMornitor";
+        m_trash_watcher->startMonitor();
+        if (m_desktop_watcher->currentUri() != "file://" + QStandardPaths::writableLocation(QStandardPaths::DesktopLocation)) {
+            m_desktop_watcher->stopMonitor();
+            m_desktop_watcher->forceChangeMonitorDirectory("file://" + QStandardPaths::writableLocation(QStandardPaths::DesktopLocation));
+            m_desktop_watcher->setMonitorChildrenChange(true);
+        }
+        m_desktop_watcher->startMonitor();
+        m_system_app_watcher->startMonitor();
+        m_andriod_app_watcher->startMonitor();
+    });
+    job->queryAsync();
 }
 
 const QModelIndex DesktopItemModel::indexFromUri(const QString &uri)
@@ -595,6 +632,7 @@ bool DesktopItemModel::dropMimeData(const QMimeData *data, Qt::DropAction action
     }
 
     auto info = FileInfo::fromUri(destDirUri);
+    info->resolveTypeSync();
     if (!info->isDir()) {
         return false;
     }
@@ -32,6 +32,7 @@ namespace Peony {
 class FileEnumerator;
 class FileInfo;
 class FileWatcher;
+class FileInfoBatchJob;
 
 class DesktopItemModel : public QAbstractListModel
 {
@@ -88,6 +89,7 @@ protected Q_SLOTS:
 
 private:
     FileEnumerator *m_enumerator;
+    FileInfoBatchJob *m_info_batch_job = nullptr;
     QList<std::shared_ptr<FileInfo>> m_files;
     std::shared_ptr<FileWatcher> m_trash_watcher;
     std::shared_ptr<FileWatcher> m_desktop_watcher;
@@ -197,6 +197,7 @@ const QList<QAction *> DesktopMenu::constructOpenOpActions()
                 QStringList files;
                 for (auto uri : m_selections) {
                     auto info = FileInfo::fromUri(uri);
+                    info->resolveTypeSync();
                     if (info->isDir() || info->isVolume()) {
                         dirs<<uri;
                     } else {
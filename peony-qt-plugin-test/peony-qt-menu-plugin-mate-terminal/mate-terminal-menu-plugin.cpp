@@ -78,6 +78,7 @@ QList<QAction *> MateTerminalMenuPlugin::menuActions(Types types, const QString
         }
         if (selectionUris.count() == 1) {
             auto info = FileInfo::fromUri(selectionUris.first(), false);
+            info->resolveTypeSync();
             if (info->isDir()) {
                 QAction *dirAction = new QAction(QIcon::fromTheme("utilities-terminal-symbolic"), tr("Open Directory in Terminal"));
                 dirAction->connect(dirAction, &QAction::triggered, [=]() {
@@ -304,6 +304,7 @@ PeonyApplication::PeonyApplication(int &argc, char *argv[], const char *applicat
         connect(proxy, &Peony::DirectoryViewProxyIface::viewDoubleClicked, [=](const QString &uri) {
             qDebug()<<"app double clicked"<<uri;
             auto info = Peony::FileInfo::fromUri(uri);
+            info->resolveTypeSync();
             if (info->isDir() || info->isVolume() || uri.startsWith("network:")) {
                 proxy->setDirectoryUri(uri);
                 proxy->beginLocationChange();